@@ -0,0 +1,348 @@
+// bench/woflang_bench.cpp - micro and op benchmarks with JSON output.
+//
+//   woflang_bench [--filter S] [--reps N] [--warmup N] [--cpu N]
+//                 [--json FILE] [--compare BASELINE.json] [--threshold 0.10]
+//
+// Each benchmark is timed over `reps` samples after `warmup` discarded ones.
+// A sample repeats the body enough times to take about a millisecond and
+// records the time per run; the median, p99, min and mean of the samples
+// are reported. Benchmarks whose ops are not loaded (plugins/ missing or a
+// plugin that failed to build) are skipped; one whose ops fail while it
+// runs is reported as failed and not timed.
+//
+// --compare reads a file written by --json and flags every benchmark whose
+// median got slower by more than the threshold; the exit status is 1 if any
+// did, or if any benchmark failed.
+#include "../src/core/woflang.hpp"
+#include "../src/core/thread_pool.hpp"
+#include "../src/io/numeric_text.hpp"
+#include "../src/io/tokenizer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory_resource>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+using namespace woflang;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::string filter;
+    int reps = 25;
+    int warmup = 3;
+    int cpu = -1;  // -1: the CPU the benchmark starts on
+    std::string json;
+    std::string compare;
+    double threshold = 0.10;
+};
+
+struct Benchmark {
+    std::string name;         // group/size
+    std::string op;           // op that must be loaded, or empty
+    std::function<void()> setup;
+    std::function<void()> body;
+};
+
+struct Result {
+    std::string name;
+    double median = 0, p99 = 0, min = 0, mean = 0;  // ns per run
+    uint64_t runs_per_sample = 0;
+};
+
+double elapsed_ns(Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+Result measure(const Benchmark& b, const Options& opt) {
+    // Enough runs per sample that timer resolution does not matter.
+    auto start = Clock::now();
+    b.body();
+    double once = std::max(elapsed_ns(start), 1.0);
+    uint64_t runs = std::max<uint64_t>(1, static_cast<uint64_t>(1e6 / once));
+
+    std::vector<double> samples;
+    for (int k = 0; k < opt.warmup + opt.reps; ++k) {
+        start = Clock::now();
+        for (uint64_t r = 0; r < runs; ++r) b.body();
+        double t = elapsed_ns(start) / static_cast<double>(runs);
+        if (k >= opt.warmup) samples.push_back(t);
+    }
+    std::sort(samples.begin(), samples.end());
+    Result r;
+    r.name = b.name;
+    r.runs_per_sample = runs;
+    r.median = samples[samples.size() / 2];
+    r.p99 = samples[std::min(samples.size() - 1, static_cast<size_t>(0.99 * static_cast<double>(samples.size())))];
+    r.min = samples.front();
+    double sum = 0;
+    for (double s : samples) sum += s;
+    r.mean = sum / static_cast<double>(samples.size());
+    return r;
+}
+
+// Pins the calling thread. The shared thread pool is started first so its
+// workers keep the full CPU set.
+int pin_to_cpu(int cpu) {
+#ifdef __linux__
+    if (cpu < 0) cpu = sched_getcpu();
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) return -1;
+    return cpu;
+#else
+    (void)cpu;
+    return -1;
+#endif
+}
+
+std::string numbers_text(size_t n) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> u(-1e6, 1e6);
+    std::ostringstream out;
+    out << std::setprecision(10);
+    for (size_t i = 0; i < n; ++i) out << u(rng) << (i % 8 == 7 ? '\n' : ' ');
+    return out.str();
+}
+
+std::string repeat(std::string_view piece, size_t times) {
+    std::string s;
+    s.reserve(piece.size() * times);
+    for (size_t i = 0; i < times; ++i) s += piece;
+    return s;
+}
+
+WofValue random_matrix(size_t n) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> u(-1, 1);
+    WofArray values(n * n);
+    for (auto& v : values) v = u(rng);
+    for (size_t i = 0; i < n; ++i) values[i * n + i] += static_cast<double>(n);  // well conditioned
+    return WofValue::make_matrix(std::move(values), static_cast<uint32_t>(n));
+}
+
+class Suite {
+public:
+    Suite() {
+        interp_.set_plugin_messages(false);
+        if (std::filesystem::exists("plugins")) interp_.load_plugins("plugins");
+        build();
+    }
+
+    std::vector<Benchmark>& benchmarks() { return benchmarks_; }
+    WoflangInterpreter& interp() { return interp_; }
+
+private:
+    // Runs `source` compiled once; the stack is emptied after each run.
+    // Heavy ops are mostly declared pure, so `uncached` empties the memo
+    // cache first to time the computation rather than a cache hit.
+    void program(const std::string& name, const std::string& op, const std::string& source,
+                 bool uncached = false, std::function<void()> setup = {}) {
+        auto compiled = std::make_shared<const Program>(compile(source, std::pmr::get_default_resource()));
+        benchmarks_.push_back({name, op, std::move(setup), [this, compiled, uncached] {
+            if (uncached) interp_.memo().clear();
+            interp_.execute(compiled);
+            while (!interp_.stack.empty()) interp_.stack.pop();
+        }});
+    }
+
+    void build() {
+        // Fixed cost of one execute() call, included in every program below.
+        program("execute/overhead", "", "1 1 +", true);
+        for (size_t n : {1000, 10000, 100000}) {
+            auto text = std::make_shared<std::string>(repeat("12 3.5 + dup 'name { swap } ", n / 6));
+            benchmarks_.push_back({"tokenize/" + std::to_string(n), "", {}, [text] {
+                std::pmr::monotonic_buffer_resource arena;
+                auto tokens = tokenize_views(*text, &arena);
+                if (tokens.empty()) std::abort();
+            }});
+            benchmarks_.push_back({"compile/" + std::to_string(n), "", {}, [text] {
+                std::pmr::monotonic_buffer_resource arena;
+                Program p = compile(*text, &arena);
+                if (p.view().code.empty()) std::abort();
+            }});
+
+            auto words = std::make_shared<std::vector<std::string>>();
+            std::istringstream in(numbers_text(n));
+            for (std::string w; in >> w;) words->push_back(w);
+            benchmarks_.push_back({"parse_number/" + std::to_string(n), "", {}, [words] {
+                double sum = 0;
+                for (const auto& w : *words) sum += parse_number(w).as_numeric();
+                if (sum == 0.123) std::abort();
+            }});
+            auto numbers = std::make_shared<std::string>(numbers_text(n));
+            benchmarks_.push_back({"parse_numbers/" + std::to_string(n), "", {}, [numbers] {
+                if (parse_numbers(*numbers).empty()) std::abort();
+            }});
+
+            // Dispatch: one value on the stack, n literal pushes and n adds.
+            program("dispatch/" + std::to_string(n), "+", "0" + repeat(" 1 +", n));
+            program("stack_ops/" + std::to_string(n), "rot", repeat("1 2 3 rot swap over drop drop drop ", n / 7));
+            program("sum_sqrt/" + std::to_string(n), "Σ", "1 " + std::to_string(n) + " range sqrt Σ");
+        }
+        for (const char* p : {"1000003", "1000000007", "1000000000000000003"}) {
+            program("prime_check/" + std::to_string(std::strlen(p)) + "digits", "prime_check",
+                    std::string(p) + " prime_check", true);
+        }
+        for (int iters : {100, 1000, 10000}) {
+            program("mandelbrot/" + std::to_string(iters), "mandelbrot",
+                    "-0.1 0.1 " + std::to_string(iters) + " mandelbrot", true);
+        }
+        for (const char* e : {"1000", "1000000", "1000000000000"}) {
+            program("modexp/" + std::string(e), "modexp", std::string("7 ") + e + " 1000000007 modexp", true);
+        }
+        for (size_t n : {32, 128, 256}) {
+            auto set_a = [this, n] { interp_.set_variable("A", random_matrix(n)); };
+            program("matmul/" + std::to_string(n), "matmul", "A A matmul", false, set_a);
+            program("solve/" + std::to_string(n), "solve", "A A solve", false, set_a);
+            program("det/" + std::to_string(n), "det", "A det", false, set_a);
+        }
+    }
+
+    WoflangInterpreter interp_;
+    std::vector<Benchmark> benchmarks_;
+};
+
+void write_json(const std::string& path, const std::vector<Result>& results, const Options& opt, int cpu) {
+    std::ofstream out(path);
+    out << "{\n  \"version\": \"" << WOFLANG_VERSION << "\",\n  \"cpu\": " << cpu << ",\n  \"reps\": " << opt.reps
+        << ",\n  \"unit\": \"ns\",\n  \"benchmarks\": [\n";
+    for (size_t k = 0; k < results.size(); ++k) {
+        const Result& r = results[k];
+        // One benchmark per line; read_baseline depends on it.
+        out << "    {\"name\": \"" << r.name << "\", \"median\": " << r.median << ", \"p99\": " << r.p99
+            << ", \"min\": " << r.min << ", \"mean\": " << r.mean << ", \"runs_per_sample\": " << r.runs_per_sample
+            << "}" << (k + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+std::map<std::string, double> read_baseline(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("cannot read baseline " + path);
+    std::map<std::string, double> medians;
+    for (std::string line; std::getline(in, line);) {
+        size_t name = line.find("\"name\": \"");
+        size_t median = line.find("\"median\": ");
+        if (name == std::string::npos || median == std::string::npos) continue;
+        name += 9;
+        medians[line.substr(name, line.find('"', name) - name)] = std::strtod(line.c_str() + median + 10, nullptr);
+    }
+    return medians;
+}
+
+std::string human(double ns) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(ns < 10 ? 2 : 1);
+    if (ns < 1e3) out << ns << " ns";
+    else if (ns < 1e6) out << ns / 1e3 << " us";
+    else out << ns / 1e6 << " ms";
+    return out.str();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    for (int k = 1; k < argc; ++k) {
+        std::string a = argv[k];
+        bool has_value = k + 1 < argc;
+        if (a == "--filter" && has_value) opt.filter = argv[++k];
+        else if (a == "--reps" && has_value) opt.reps = std::max(1, std::atoi(argv[++k]));
+        else if (a == "--warmup" && has_value) opt.warmup = std::max(0, std::atoi(argv[++k]));
+        else if (a == "--cpu" && has_value) opt.cpu = std::atoi(argv[++k]);
+        else if (a == "--json" && has_value) opt.json = argv[++k];
+        else if (a == "--compare" && has_value) opt.compare = argv[++k];
+        else if (a == "--threshold" && has_value) opt.threshold = std::atof(argv[++k]);
+        else {
+            std::cerr << "usage: woflang_bench [--filter S] [--reps N] [--warmup N] [--cpu N]\n"
+                         "                     [--json FILE] [--compare BASELINE.json] [--threshold F]\n";
+            return 2;
+        }
+    }
+
+    try {
+        std::map<std::string, double> baseline;
+        if (!opt.compare.empty()) baseline = read_baseline(opt.compare);
+
+        ThreadPool::shared();
+        int cpu = pin_to_cpu(opt.cpu);
+        Suite suite;
+
+        std::vector<Result> results;
+        size_t regressions = 0;
+        size_t failed = 0;
+        WoflangInterpreter& interp = suite.interp();
+        interp.capture_errors(true);
+        std::cout << std::left << std::setw(30) << "benchmark" << std::right << std::setw(12) << "median"
+                  << std::setw(12) << "p99" << std::setw(12) << "min" << (baseline.empty() ? "" : "   vs baseline")
+                  << "\n";
+        for (const Benchmark& b : suite.benchmarks()) {
+            if (!opt.filter.empty() && b.name.find(opt.filter) == std::string::npos) continue;
+            if (!b.op.empty() && !suite.interp().has_op(b.op)) {
+                std::cout << std::left << std::setw(30) << b.name << "skipped (no '" << b.op << "')\n";
+                continue;
+            }
+            if (b.setup) b.setup();
+            // Keep what the body prints out of the table. A body whose ops
+            // fail would time the error path, so it is checked once before
+            // timing and again after.
+            std::ostringstream noise;
+            auto* saved = std::cout.rdbuf(noise.rdbuf());
+            interp.take_errors();
+            uint64_t errors = interp.op_errors();
+            b.body();
+            Result r;
+            if (interp.op_errors() == errors) r = measure(b, opt);
+            std::cout.rdbuf(saved);
+            if (interp.op_errors() != errors) {
+                std::string message = interp.take_errors();
+                message = message.substr(0, message.find('\n'));
+                std::cout << std::left << std::setw(30) << b.name << "failed: " << message << "\n";
+                ++failed;
+                continue;
+            }
+            results.push_back(r);
+
+            std::cout << std::left << std::setw(30) << r.name << std::right << std::setw(12) << human(r.median)
+                      << std::setw(12) << human(r.p99) << std::setw(12) << human(r.min);
+            if (auto it = baseline.find(r.name); it != baseline.end() && it->second > 0) {
+                double ratio = r.median / it->second;
+                std::cout << "   " << std::fixed << std::setprecision(2) << ratio << "x";
+                std::cout.unsetf(std::ios::fixed);
+                if (ratio > 1 + opt.threshold) {
+                    std::cout << "  REGRESSION";
+                    ++regressions;
+                } else if (ratio < 1 - opt.threshold) {
+                    std::cout << "  faster";
+                }
+            }
+            std::cout << "\n";
+        }
+        if (!opt.json.empty()) write_json(opt.json, results, opt, cpu);
+        if (!baseline.empty()) {
+            std::cout << regressions << " regression(s) beyond " << opt.threshold * 100 << "%\n";
+        }
+        if (failed) std::cout << failed << " benchmark(s) failed\n";
+        return regressions == 0 && failed == 0 ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 2;
+    }
+}
@@ -1,14 +1,27 @@
 #include "src/core/woflang.hpp"
+#include "src/api/batch_runner.hpp"
+#include "src/api/eval_server.hpp"
+#include "src/api/woflang_c.h"
+#include "src/io/statement_reader.hpp"
 #include <iostream>
 #include <string>
 #include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <csignal>
+#include <cstdlib>
 #include <cstring>
 #include <chrono>
 #include <iomanip>
+#include <sstream>
+#include <thread>
 #include <vector>
 
 #ifdef _WIN32
 #include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
 #endif
 
 // ASCII art banner
@@ -22,16 +35,38 @@ A Unicode-native stack language
 // --- HELP ---
 void show_help() {
     std::cout << "WofLang - Stack-based Programming Language\n\n";
-    std::cout << "Usage: woflang [options]\n\n";
+    std::cout << "Usage: woflang [options] [script.wof]\n\n";
     std::cout << "Options:\n";
     std::cout << "  -h, --help     Show this help message\n";
     std::cout << "  -v, --version  Show version information\n";
     std::cout << "  --test         Run test suite\n";
-    std::cout << "  --benchmark    Run prime benchmarking suite\n\n";
+    std::cout << "  --benchmark    Run prime benchmarking suite\n";
+    std::cout << "  --no-cache     Run script.wof without reading or writing script.wofc\n";
+    std::cout << "  --profile      Run script.wof and print a per-op profile to stderr\n";
+    std::cout << "  --sample FILE  Run script.wof under the sampling profiler, folded stacks to FILE\n";
+    std::cout << "  --image FILE   Start the REPL from an image instead of loading plugins/\n";
+    std::cout << "  -i, --interactive  Prompt even when stdin is not a terminal\n";
+    std::cout << "  --serve SOCKET [N]  Serve eval requests on a UNIX socket with N interpreters\n";
+    std::cout << "  --client SOCKET     Send each stdin line to a server as a pipelined request\n";
+    std::cout << "  --batch MANIFEST [--jobs N] [--setup FILE]\n";
+    std::cout << "                 Run the scripts listed in MANIFEST in forked children\n\n";
+    std::cout << "Piped input (woflang < job.wof) runs as a batch: no banner or prompts,\n";
+    std::cout << "read in blocks and compiled ahead of execution. Like a script, it exits\n";
+    std::cout << "with status 1 if any op failed.\n\n";
     std::cout << "Interactive Commands:\n";
     std::cout << "  exit, quit     Exit the interpreter\n";
     std::cout << "  help           Show this help\n";
     std::cout << "  benchmark      Run benchmarking suite\n";
+    std::cout << "  image save F   Save stack, words, variables and plugins to image F\n";
+    std::cout << "  image load F   Restore an image saved with image save\n";
+    std::cout << "  history on [N] Record stack states, keeping the last N steps\n";
+    std::cout << "  history off    Stop recording and drop the history\n";
+    std::cout << "  undo, redo [N] Step the stack back or forward N steps\n";
+    std::cout << "  goto STEP      Put the stack back as it was at STEP\n";
+    std::cout << "  profile on [counters]  Time every op, with hardware counters if asked\n";
+    std::cout << "  profile, profile off   Show the profile; stop profiling\n";
+    std::cout << "  profile sample [HZ]    Sample words and lines (default 1000 Hz)\n";
+    std::cout << "  profile folded FILE    Write the samples as folded stacks for flamegraphs\n";
     std::cout << "  <number>       Push number onto stack\n";
     std::cout << "  +, -, *, /     Basic arithmetic\n";
     std::cout << "  dup, drop      Stack manipulation\n";
@@ -44,6 +79,118 @@ void show_help() {
     std::cout << "  prime_check    Check if number is prime (if crypto_ops loaded)\n";
 }
 
+// --- HISTORY ---
+constexpr size_t kDefaultHistorySteps = 1000000;
+
+void show_history_position(const woflang::WoflangInterpreter& interp) {
+    const auto* h = interp.history();
+    std::cout << "step " << h->position() << " of " << h->first() << ".." << h->last()
+              << ", stack (top to bottom):";
+    std::stack<woflang::WofValue> temp = interp.stack;
+    for (int k = 0; k < 8 && !temp.empty(); ++k, temp.pop()) std::cout << " " << temp.top().to_string();
+    if (!temp.empty()) std::cout << " ... (" << interp.stack.size() << " values)";
+    std::cout << "\n";
+}
+
+// undo/redo/goto/history commands; false if `line` is not one of them.
+bool history_command(woflang::WoflangInterpreter& interp, const std::string& line) {
+    std::istringstream in(line);
+    std::string cmd, arg;
+    in >> cmd >> arg;
+    if (cmd == "history") {
+        if (arg == "on") {
+            size_t steps = kDefaultHistorySteps;
+            in >> steps;
+            interp.record_history(steps);
+            std::cout << "Recording up to " << steps << " steps\n";
+        } else if (arg == "off") {
+            interp.stop_history();
+        } else if (interp.history()) {
+            show_history_position(interp);
+        } else {
+            std::cout << "History is off (history on [N] starts recording)\n";
+        }
+        return true;
+    }
+    if (cmd != "undo" && cmd != "redo" && cmd != "goto") return false;
+    if (!interp.history()) {
+        std::cout << "Error: history is off (history on [N] starts recording)\n";
+        return true;
+    }
+    uint64_t at = interp.history()->position();
+    uint64_t first = interp.history()->first();
+    uint64_t n = cmd == "goto" ? 0 : 1;
+    if (!arg.empty()) {
+        try {
+            n = std::stoull(arg);
+        } catch (const std::exception&) {
+            std::cout << "Error: " << cmd << " expects a step count\n";
+            return true;
+        }
+    } else if (cmd == "goto") {
+        std::cout << "Error: goto expects a step\n";
+        return true;
+    }
+    uint64_t target = cmd == "goto" ? n : cmd == "undo" ? (n > at - first ? first : at - n) : at + n;
+    if (!interp.travel_to(target)) {
+        std::cout << "Error: step " << target << " is not retained\n";
+        return true;
+    }
+    show_history_position(interp);
+    return true;
+}
+
+// profile on [counters] / profile off / profile reset / profile, and
+// profile sample [HZ] / profile folded FILE; false if `line` is not one of
+// them.
+bool profile_command(woflang::WoflangInterpreter& interp, const std::string& line) {
+    std::istringstream in(line);
+    std::string cmd, arg, counters;
+    in >> cmd >> arg >> counters;
+    if (cmd != "profile") return false;
+    if (arg == "sample") {
+        try {
+            interp.start_sampler(counters.empty() ? 1000 : static_cast<unsigned>(std::stoul(counters)));
+        } catch (const std::exception& e) {
+            std::cout << "Error: " << e.what() << "\n";
+        }
+        return true;
+    }
+    if (arg == "folded") {
+        std::ofstream out(counters);
+        if (!interp.sampler()) {
+            std::cout << "Error: sampling is off (profile sample [HZ] starts it)\n";
+        } else if (counters.empty() || !out) {
+            std::cout << "Error: profile folded expects a writable file\n";
+        } else {
+            interp.sampler()->write_folded(out);
+            std::cout << interp.sampler()->samples() << " samples written to " << counters << "\n";
+        }
+        return true;
+    }
+    if (arg == "off" && interp.sampler()) {
+        std::cout << interp.sampler()->samples() << " samples, " << interp.sampler()->dropped() << " dropped\n";
+        interp.stop_sampler();
+        if (!interp.profiler()) return true;
+    }
+    if (arg == "on") {
+        interp.start_profiler(counters == "counters");
+        if (const auto& missing = interp.profiler()->unavailable(); !missing.empty()) {
+            std::cout << "Counters not available: " << missing << "\n";
+        }
+    } else if (!interp.profiler()) {
+        std::cout << "Profiling is off (profile on [counters] starts it)\n";
+    } else if (arg == "off") {
+        interp.profiler()->report(std::cout);
+        interp.stop_profiler();
+    } else if (arg == "reset") {
+        interp.profiler()->reset();
+    } else {
+        interp.profiler()->report(std::cout);
+    }
+    return true;
+}
+
 // --- BENCHMARK ---
 void run_benchmark() {
     std::cout << "🔢 WofLang Prime Benchmarking Suite\n";
@@ -268,6 +415,135 @@ void run_tests() {
     std::cout << "\nSystem Status: 🟢 FULLY OPERATIONAL 🟢\n";
 }
 
+// --- COMMANDS ---
+enum class Command { None, Handled, Quit };
+
+// REPL commands that are not woflang code.
+Command repl_command(woflang::WoflangInterpreter& interp, const std::string& line, bool interactive) {
+    if (line == "quit" || line == "exit") {
+        if (interactive) std::cout << "Goodbye from woflang! 🐺\n";
+        return Command::Quit;
+    }
+    if (line == "help") {
+        show_help();
+        return Command::Handled;
+    }
+    if (line == "benchmark") {
+        run_benchmark();
+        return Command::Handled;
+    }
+    if (line.rfind("image save ", 0) == 0) {
+        try {
+            interp.save_image(line.substr(11));
+        } catch (const std::exception& e) {
+            std::cout << "Error: " << e.what() << "\n";
+        }
+        return Command::Handled;
+    }
+    if (line.rfind("image load ", 0) == 0) {
+        interp.load_image(line.substr(11));
+        return Command::Handled;
+    }
+    return history_command(interp, line) || profile_command(interp, line) ? Command::Handled : Command::None;
+}
+
+bool stdin_is_terminal() {
+#ifdef _WIN32
+    return _isatty(_fileno(stdin)) != 0;
+#else
+    return isatty(fileno(stdin)) != 0;
+#endif
+}
+
+// --- SERVER ---
+woflang::EvalServer* running_server = nullptr;
+
+void stop_server(int) {
+    if (running_server) running_server->stop();
+}
+
+int serve(const char* socket_path, unsigned workers) {
+    if (workers == 0) workers = std::max(1u, std::thread::hardware_concurrency());
+    try {
+        woflang::EvalServer server(socket_path, workers, "plugins");
+        running_server = &server;
+        std::signal(SIGINT, stop_server);
+        std::signal(SIGTERM, stop_server);
+        std::cerr << "Serving on " << socket_path << " with " << workers << " interpreters\n";
+        server.run();
+        running_server = nullptr;
+        auto s = server.stats();
+        std::cerr << "Served " << s.requests << " requests (" << s.errors << " failed), latency mean "
+                  << (s.requests ? s.total_micros / s.requests : 0) << " us, p50 < " << s.quantile_micros(0.5)
+                  << " us, p99 < " << s.quantile_micros(0.99) << " us, max " << s.max_micros << " us\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// Sends each stdin line as a request, all before reading any response.
+int run_client(const char* socket_path) {
+    try {
+        woflang::EvalClient client(socket_path);
+        std::vector<std::string> lines;
+        for (std::string line; std::getline(std::cin, line);) lines.push_back(line);
+        auto start = std::chrono::steady_clock::now();
+        for (size_t id = 0; id < lines.size(); ++id) client.send(static_cast<uint32_t>(id), lines[id]);
+        woflang::ResponseHeader h;
+        std::string text;
+        size_t received = 0;
+        for (; received < lines.size() && client.receive(h, text); ++received) {
+            const char* status = h.status == WOF_OK ? "ok" : h.status == WOF_BUDGET_EXCEEDED ? "budget" : "error";
+            std::cout << "#" << h.id << " " << status << " " << h.micros << " us\n" << text;
+            if (h.status != WOF_OK) std::cout << "\n";
+        }
+        auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cerr << received << "/" << lines.size() << " responses in " << ms << " ms\n";
+        return received == lines.size() ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
+
+// --- BATCH ---
+// woflang --batch MANIFEST [--jobs N] [--setup FILE]
+int batch(int argc, char* argv[]) {
+    unsigned jobs = 0;
+    const char* setup = nullptr;
+    for (int k = 3; k + 1 < argc; k += 2) {
+        if (strcmp(argv[k], "--jobs") == 0) jobs = static_cast<unsigned>(std::atoi(argv[k + 1]));
+        else if (strcmp(argv[k], "--setup") == 0) setup = argv[k + 1];
+    }
+    try {
+        auto scripts = woflang::read_manifest(argv[2]);
+        woflang::WoflangInterpreter interp;
+        interp.set_plugin_messages(false);
+        if (std::filesystem::exists("plugins")) interp.load_plugins("plugins");
+        // Words and values the setup script leaves are inherited by every script.
+        if (setup && !interp.execute_file(setup)) {
+            std::cerr << "Error: setup script " << setup << " failed\n";
+            return 1;
+        }
+        auto start = std::chrono::steady_clock::now();
+        size_t failures = woflang::run_batch(interp, scripts, jobs, [&](const woflang::BatchResult& r) {
+            using Status = woflang::BatchResult::Status;
+            const char* tag = r.status == Status::Ok ? "ok" : r.status == Status::Error ? "error" : "crashed";
+            std::cout << "[" << tag << "] " << scripts[r.index].string() << " (" << r.micros / 1000.0 << " ms)\n"
+                      << r.output;
+        });
+        auto secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout.flush();
+        std::cerr << scripts.size() << " scripts, " << failures << " failed, in " << secs << " s\n";
+        return failures == 0 ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
+
 // --- MAIN ---
 int main(int argc, char* argv[]) {
 #ifdef _WIN32
@@ -275,6 +551,20 @@ int main(int argc, char* argv[]) {
     SetConsoleCP(CP_UTF8);
 #endif
 
+    bool interactive = stdin_is_terminal();
+    if (argc > 1 && (strcmp(argv[1], "-i") == 0 || strcmp(argv[1], "--interactive") == 0)) {
+        interactive = true;
+        --argc;
+        ++argv;
+    }
+    // Batch output goes through one large buffer, flushed when it fills or
+    // at exit, instead of once per prompt.
+    static char out_buffer[1 << 16];
+    if (!interactive) {
+        std::ios::sync_with_stdio(false);
+        std::cout.rdbuf()->pubsetbuf(out_buffer, sizeof(out_buffer));
+    }
+
     if (argc > 1) {
         if (strcmp(argv[1], "--help") == 0 || strcmp(argv[1], "-h") == 0) {
             show_help();
@@ -294,36 +584,107 @@ int main(int argc, char* argv[]) {
             std::cout << "Compiler: " << __VERSION__ << "\n";
             return 0;
         }
+
+        if (strcmp(argv[1], "--serve") == 0 && argc > 2) {
+            return serve(argv[2], argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : 0);
+        }
+        if (strcmp(argv[1], "--batch") == 0 && argc > 2) {
+            return batch(argc, argv);
+        }
+        if (strcmp(argv[1], "--client") == 0 && argc > 2) {
+            return run_client(argv[2]);
+        }
+
+        // Script mode: woflang [--no-cache] [--profile] script.wof
+        bool use_cache = true;
+        bool profile = false;
+        const char* folded = nullptr;
+        int arg = 1;
+        for (; arg < argc; ++arg) {
+            if (strcmp(argv[arg], "--no-cache") == 0) use_cache = false;
+            else if (strcmp(argv[arg], "--profile") == 0) profile = true;
+            else if (strcmp(argv[arg], "--sample") == 0 && arg + 1 < argc) folded = argv[++arg];
+            else if (argv[arg][0] == '-' && strcmp(argv[arg], "--image") != 0) {
+                std::cerr << "Unknown option: " << argv[arg] << " (see woflang --help)\n";
+                return 2;
+            } else break;
+        }
+        if (arg < argc && strcmp(argv[arg], "--image") != 0) {
+            woflang::WoflangInterpreter interp;
+            interp.set_plugin_messages(false);
+            std::filesystem::path plugin_dir = "plugins";
+            if (std::filesystem::exists(plugin_dir)) {
+                interp.load_plugins(plugin_dir);
+            }
+            if (profile) interp.start_profiler(true);
+            if (folded) {
+                try {
+                    interp.start_sampler(1000);
+                } catch (const std::exception& e) {
+                    std::cerr << "Error: " << e.what() << "\n";
+                    return 1;
+                }
+            }
+            // Exit status 1 if the script cannot be read, an op failed or a
+            // budget aborted it.
+            bool ok = false;
+            try {
+                ok = interp.execute_file(argv[arg], use_cache);
+            } catch (const std::exception& e) {
+                std::cout.flush();
+                std::cerr << "Error: " << e.what() << "\n";
+            }
+            std::cout.flush();
+            if (profile) interp.profiler()->report(std::cerr);
+            if (folded) {
+                std::ofstream out(folded);
+                interp.sampler()->write_folded(out);
+                std::cerr << interp.sampler()->samples() << " samples (" << interp.sampler()->dropped()
+                          << " dropped) written to " << folded << "\n";
+            }
+            return ok ? 0 : 1;
+        }
     }
 
-    std::cout << WOFLANG_BANNER << std::endl;
+    if (interactive) std::cout << WOFLANG_BANNER << std::endl;
 
     woflang::WoflangInterpreter interp;
+    interp.set_plugin_messages(interactive);
 
-    std::filesystem::path plugin_dir = "plugins";
-    if (std::filesystem::exists(plugin_dir)) {
-        interp.load_plugins(plugin_dir);
+    // Warm start: the image lists the plugins to re-bind.
+    if (argc > 2 && strcmp(argv[1], "--image") == 0) {
+        if (!interp.load_image(argv[2])) return 1;
     } else {
-        std::cout << "No plugins directory found. Running with built-in operations only.\n";
+        std::filesystem::path plugin_dir = "plugins";
+        if (std::filesystem::exists(plugin_dir)) {
+            interp.load_plugins(plugin_dir);
+        } else if (interactive) {
+            std::cout << "No plugins directory found. Running with built-in operations only.\n";
+        }
+    }
+
+    if (!interactive) {
+        woflang::StatementReader reader(stdin);
+        woflang::StatementReader::Statement statement;
+        std::string line;
+        uint64_t errors = interp.op_errors();
+        while (reader.next(statement)) {
+            line.assign(statement.text);
+            Command c = repl_command(interp, line, false);
+            if (c == Command::Quit) break;
+            if (c == Command::None) interp.execute(statement.program);
+        }
+        std::cout.flush();
+        return interp.op_errors() == errors ? 0 : 1;
     }
 
     std::cout << "Welcome to woflang!\n";
     std::cout << "Type 'help' for commands, 'quit' to exit, or '--benchmark' for speed tests.\n";
     std::string line;
     while (std::cout << "wof> ", std::getline(std::cin, line)) {
-        if (line == "quit" || line == "exit") {
-            std::cout << "Goodbye from woflang! 🐺\n";
-            break;
-        }
-        if (line == "help") {
-            show_help();
-            continue;
-        }
-        if (line == "benchmark") {
-            run_benchmark();
-            continue;
-        }
-        interp.execute_line(line);
+        Command c = repl_command(interp, line, true);
+        if (c == Command::Quit) break;
+        if (c == Command::None) interp.execute_line(line);
     }
     return 0;
 }
@@ -0,0 +1,131 @@
+// plugins/assert_ops.cpp — assertions for the .wof regression tests
+//
+// Each op pops its operands and throws on a mismatch, so a failed check is
+// an op error and fails the test under woflang_test_runner.
+#ifndef WOFLANG_PLUGIN_EXPORT
+#  ifdef _WIN32
+#    define WOFLANG_PLUGIN_EXPORT extern "C" __declspec(dllexport)
+#  else
+#    define WOFLANG_PLUGIN_EXPORT extern "C"
+#  endif
+#endif
+
+#include "core/woflang.hpp"
+#include <cmath>
+#include <iostream>
+#include <stack>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+using woflang::WofValue;
+
+double need_num(const WofValue& v, const char* op) {
+    if (v.is_string() || v.is_array() || v.is_quotation()) {
+        throw std::runtime_error(std::string(op) + ": numeric required");
+    }
+    return v.as_numeric();
+}
+
+std::shared_ptr<const woflang::WofArray> need_bounded(const WofValue& v, const char* op) {
+    if (woflang::array_size(v) == woflang::kUnbounded) {
+        throw std::runtime_error(std::string(op) + ": cannot compare an unbounded sequence");
+    }
+    return v.array();
+}
+
+void need_args(const std::stack<WofValue>& S, size_t n, const char* op, const char* usage) {
+    if (S.size() < n) throw std::runtime_error(std::string(op) + ": need " + usage);
+}
+
+// Arrays match elementwise (and in shape, for matrices); exact integers
+// match on the integer; other numbers as doubles, with NaN matching NaN so
+// missing values can be checked; everything else by its printed form.
+bool same(const WofValue& a, const WofValue& e, double tol, const char* op) {
+    if (a.is_array() || e.is_array()) {
+        if (!a.is_array() || !e.is_array() || a.cols != e.cols) return false;
+        auto av = need_bounded(a, op);
+        auto ev = need_bounded(e, op);
+        if (av->size() != ev->size()) return false;
+        for (size_t k = 0; k < av->size(); ++k) {
+            double x = (*av)[k], y = (*ev)[k];
+            if (!(x == y || (std::isnan(x) && std::isnan(y)) || std::fabs(x - y) <= tol)) return false;
+        }
+        return true;
+    }
+    if (a.is_string() || e.is_string() || a.is_quotation() || e.is_quotation()) {
+        return a.to_string() == e.to_string();
+    }
+    if (a.is_int() && e.is_int() && tol == 0.0) return a.i == e.i;
+    double x = a.as_numeric(), y = e.as_numeric();
+    return x == y || (std::isnan(x) && std::isnan(y)) || std::fabs(x - y) <= tol;
+}
+
+} // namespace
+
+WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* ops) {
+    if (!ops) return;
+
+    // actual expected            expect_eq
+    (*ops)["expect_eq"] = [](std::stack<WofValue>& S) {
+        need_args(S, 2, "expect_eq", "actual expected");
+        auto expected = S.top(); S.pop();
+        auto actual   = S.top(); S.pop();
+        if (!same(actual, expected, 0.0, "expect_eq")) {
+            throw std::runtime_error("expect_eq failed: got " + actual.to_string() +
+                                     ", expected " + expected.to_string());
+        }
+    };
+
+    // actual expected tol        expect_approx    (elementwise for arrays)
+    (*ops)["expect_approx"] = [](std::stack<WofValue>& S) {
+        need_args(S, 3, "expect_approx", "actual expected tol");
+        double tol = need_num(S.top(), "expect_approx");
+        if (!(std::isfinite(tol) && tol >= 0.0)) throw std::runtime_error("expect_approx: bad tol");
+        S.pop();
+        auto expected = S.top(); S.pop();
+        auto actual   = S.top(); S.pop();
+        if (!same(actual, expected, tol, "expect_approx")) {
+            throw std::runtime_error("expect_approx failed: got " + actual.to_string() +
+                                     ", expected " + expected.to_string() +
+                                     " (tol " + std::to_string(tol) + ")");
+        }
+    };
+
+    // actual expected            expect_int       (exact int64, not promoted)
+    (*ops)["expect_int"] = [](std::stack<WofValue>& S) {
+        need_args(S, 2, "expect_int", "actual expected");
+        auto expected = S.top(); S.pop();
+        auto actual   = S.top(); S.pop();
+        if (!actual.is_int() || !expected.is_int() || actual.i != expected.i) {
+            throw std::runtime_error("expect_int failed: got " + actual.to_string() +
+                                     (actual.is_int() ? "" : " (not an exact integer)") +
+                                     ", expected " + expected.to_string());
+        }
+    };
+
+    // cond                       expect_true      (nonzero numeric == true)
+    (*ops)["expect_true"] = [](std::stack<WofValue>& S) {
+        need_args(S, 1, "expect_true", "cond");
+        double c = need_num(S.top(), "expect_true"); S.pop();
+        if (c == 0.0) throw std::runtime_error("expect_true failed: condition is false (0)");
+    };
+
+    // n                          expect_depth     (n values left under it)
+    (*ops)["expect_depth"] = [](std::stack<WofValue>& S) {
+        need_args(S, 1, "expect_depth", "n");
+        double n = need_num(S.top(), "expect_depth"); S.pop();
+        if (static_cast<double>(S.size()) != n) {
+            throw std::runtime_error("expect_depth failed: depth " + std::to_string(S.size()) +
+                                     ", expected " + std::to_string(static_cast<long long>(n)));
+        }
+    };
+
+    // 'message                   note             (prints to stdout)
+    (*ops)["note"] = [](std::stack<WofValue>& S) {
+        need_args(S, 1, "note", "message");
+        std::string m = S.top().to_string(); S.pop();
+        std::cout << "[NOTE] " << m << std::endl;
+    };
+}
@@ -10,7 +10,9 @@
 #include "core/woflang.hpp"
 #include <array>
 #include <cstdint>
+#include <memory_resource>
 #include <random>
+#include <span>
 #include <stack>
 #include <stdexcept>
 #include <string>
@@ -21,20 +23,27 @@ static inline double need_num(const WofValue& v,const char* op){
     if(!v.is_numeric()) throw std::runtime_error(std::string(op)+": numeric required");
     return v.as_numeric();
 }
-static std::string to_hex_bytes(const std::vector<uint8_t>& b){ static const char* H="0123456789abcdef"; std::string o; o.reserve(b.size()*2); for(uint8_t x: b){ o.push_back(H[x>>4]); o.push_back(H[x&15]); } return o; }
-static std::vector<uint8_t> from_hex_bytes(const std::string& s){ auto hv=[](char c)->int{ if(c>='0'&&c<='9') return c-'0'; if(c>='a'&&c<='f') return c-'a'+10; if(c>='A'&&c<='F') return c-'A'+10; return -1; }; if(s.size()%2) throw std::runtime_error("from_hex: odd length"); std::vector<uint8_t> o; o.reserve(s.size()/2); for(size_t i=0;i<s.size();i+=2){ int hi=hv(s[i]),lo=hv(s[i+1]); if(hi<0||lo<0) throw std::runtime_error("from_hex: bad digit"); o.push_back(uint8_t((hi<<4)|lo)); } return o; }
+// Encoders read the input bytes in place; decoders build their byte buffer in
+// the interpreter's per-execution scratch arena.
+using ByteView = std::span<const uint8_t>;
+using ScratchBytes = std::pmr::vector<uint8_t>;
+static ByteView bytes_of(const std::string& s){ return {reinterpret_cast<const uint8_t*>(s.data()), s.size()}; }
+static std::string to_hex_bytes(ByteView b){ static const char* H="0123456789abcdef"; std::string o; o.reserve(b.size()*2); for(uint8_t x: b){ o.push_back(H[x>>4]); o.push_back(H[x&15]); } return o; }
+static ScratchBytes from_hex_bytes(const std::string& s){ auto hv=[](char c)->int{ if(c>='0'&&c<='9') return c-'0'; if(c>='a'&&c<='f') return c-'a'+10; if(c>='A'&&c<='F') return c-'A'+10; return -1; }; if(s.size()%2) throw std::runtime_error("from_hex: odd length"); ScratchBytes o(scratch_resource()); o.reserve(s.size()/2); for(size_t i=0;i<s.size();i+=2){ int hi=hv(s[i]),lo=hv(s[i+1]); if(hi<0||lo<0) throw std::runtime_error("from_hex: bad digit"); o.push_back(uint8_t((hi<<4)|lo)); } return o; }
 static const char* B64="ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-static std::string b64_encode(const std::vector<uint8_t>& d){ std::string o; o.reserve(((d.size()+2)/3)*4); size_t i=0; while(i+3<=d.size()){ uint32_t n=(d[i]<<16)|(d[i+1]<<8)|d[i+2]; i+=3; o.push_back(B64[(n>>18)&63]); o.push_back(B64[(n>>12)&63]); o.push_back(B64[(n>>6)&63]); o.push_back(B64[n&63]); } if(i+1==d.size()){ uint32_t n=(d[i]<<16); o.push_back(B64[(n>>18)&63]); o.push_back(B64[(n>>12)&63]); o.push_back('='); o.push_back('='); } else if(i+2==d.size()){ uint32_t n=(d[i]<<16)|(d[i+1]<<8); o.push_back(B64[(n>>18)&63]); o.push_back(B64[(n>>12)&63]); o.push_back(B64[(n>>6)&63]); o.push_back('='); } return o; }
-static std::vector<uint8_t> b64_decode(const std::string& s){ std::array<int,256> T{}; T.fill(-1); for(int i=0;i<64;++i) T[uint8_t(B64[i])]=i; std::vector<uint8_t> o; int val=0,valb=-8; for(unsigned char c: s){ if(c=='=') break; int d=T[c]; if(d<0) continue; val=(val<<6)|d; valb+=6; if(valb>=0){ o.push_back(uint8_t((val>>valb)&0xFF)); valb-=8; } } return o; }
+static std::string b64_encode(ByteView d){ std::string o; o.reserve(((d.size()+2)/3)*4); size_t i=0; while(i+3<=d.size()){ uint32_t n=(d[i]<<16)|(d[i+1]<<8)|d[i+2]; i+=3; o.push_back(B64[(n>>18)&63]); o.push_back(B64[(n>>12)&63]); o.push_back(B64[(n>>6)&63]); o.push_back(B64[n&63]); } if(i+1==d.size()){ uint32_t n=(d[i]<<16); o.push_back(B64[(n>>18)&63]); o.push_back(B64[(n>>12)&63]); o.push_back('='); o.push_back('='); } else if(i+2==d.size()){ uint32_t n=(d[i]<<16)|(d[i+1]<<8); o.push_back(B64[(n>>18)&63]); o.push_back(B64[(n>>12)&63]); o.push_back(B64[(n>>6)&63]); o.push_back('='); } return o; }
+static ScratchBytes b64_decode(const std::string& s){ std::array<int,256> T{}; T.fill(-1); for(int i=0;i<64;++i) T[uint8_t(B64[i])]=i; ScratchBytes o(scratch_resource()); o.reserve(s.size()/4*3); int val=0,valb=-8; for(unsigned char c: s){ if(c=='=') break; int d=T[c]; if(d<0) continue; val=(val<<6)|d; valb+=6; if(valb>=0){ o.push_back(uint8_t((val>>valb)&0xFF)); valb-=8; } } return o; }
 }
 
+WOFLANG_PLUGIN_BIND_HOST()
+
 WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* ops){
     using namespace woflang;
     if (!ops) return;
 
     (*ops)["to_hex"] = [](std::stack<WofValue>& S){
         std::string s = S.top().to_string(); S.pop();
-        std::vector<uint8_t> b(s.begin(), s.end()); S.push(WofValue(to_hex_bytes(b)));
+        S.push(WofValue(to_hex_bytes(bytes_of(s))));
     };
     (*ops)["from_hex"] = [](std::stack<WofValue>& S){
         std::string hx = S.top().to_string(); S.pop();
@@ -42,7 +51,7 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* ops
     };
     (*ops)["base64_encode"] = [](std::stack<WofValue>& S){
         std::string s = S.top().to_string(); S.pop();
-        std::vector<uint8_t> b(s.begin(), s.end()); S.push(WofValue(b64_encode(b)));
+        S.push(WofValue(b64_encode(bytes_of(s))));
     };
     (*ops)["base64_decode"] = [](std::stack<WofValue>& S){
         std::string s = S.top().to_string(); S.pop();
@@ -60,3 +69,8 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* ops
         S.push(WofValue(std::move(out)));
     };
 }
+
+WOFLANG_PLUGIN_EXPORT void declare_stack_effects(woflang::StackEffectSink declare, void* ctx){
+    for (const char* op : {"to_hex","from_hex","base64_encode","base64_decode","random_bytes"}) declare(ctx, op, 1, 1);
+    declare(ctx, "random", 0, 1);
+}
@@ -2,6 +2,8 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <cmath>
+#include <numeric>
 #include <stdexcept>
 
 #ifndef WOFLANG_PLUGIN_EXPORT
@@ -12,25 +14,44 @@
 #  endif
 #endif
 
-WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_table) {
+#include "core/woflang.hpp"
+#include "core/int_math.hpp"
 
 namespace woflang {
 
-unsigned long long factorial(int n) {
+// Exact int64 results; false when the value does not fit, in which case the
+// op falls back to a double computed via lgamma.
+bool factorial(int64_t n,int64_t* out) {
     if (n < 0) throw std::runtime_error("factorial domain error");
-    unsigned long long result = 1;
-    for (int i = 2; i <= n; ++i) result *= i;
-    return result;
+    int64_t result = 1;
+    for (int64_t i = 2; i <= n; ++i) if (mul_overflow(result, i, &result)) return false;
+    *out = result;
+    return true;
 }
 
-unsigned long long permutations(int n, int r) {
-    if (n < r) return 0;
-    return factorial(n) / factorial(n - r);
+bool permutations(int64_t n,int64_t r,int64_t* out) {
+    if (n < 0 || r < 0) throw std::runtime_error("permutations domain error");
+    if (n < r) { *out = 0; return true; }
+    int64_t result = 1;
+    for (int64_t i = n - r + 1; i <= n; ++i) if (mul_overflow(result, i, &result)) return false;
+    *out = result;
+    return true;
 }
 
-unsigned long long combinations(int n, int r) {
-    if (n < r) return 0;
-    return factorial(n) / (factorial(r) * factorial(n - r));
+bool combinations(int64_t n,int64_t r,int64_t* out) {
+    if (n < 0 || r < 0) throw std::runtime_error("combinations domain error");
+    if (n < r) { *out = 0; return true; }
+    r = std::min(r, n - r);
+    // C(n-r+i, i) is an integer at every step, so the division is exact.
+    int64_t result = 1;
+    for (int64_t i = 1; i <= r; ++i) {
+        int64_t g = std::gcd(result, i);
+        int64_t t;
+        if (mul_overflow(result / g, (n - r + i) / (i / g), &t)) return false;
+        result = t;
+    }
+    *out = result;
+    return true;
 }
 
 std::vector<int> greedyGraphColoring(const std::vector<std::vector<int>>& graph) {
@@ -47,3 +68,53 @@ std::vector<int> greedyGraphColoring(const std::vector<std::vector<int>>& graph)
     }
     return result;
 }
+
+static int64_t pop_int(std::stack<WofValue>& st,const char* op) {
+    if (st.empty()) throw std::runtime_error(std::string("Stack underflow on ") + op);
+    int64_t x = 0;
+    if (!exact_int(st.top(), &x)) throw std::runtime_error(std::string(op) + ": integer argument required");
+    st.pop();
+    return x;
+}
+
+static void push_result(std::stack<WofValue>& st,bool fits,int64_t exact,double approx) {
+    if (fits) { st.push(WofValue::make_int(exact)); return; }
+    WofValue v;
+    v.d = approx;
+    st.push(v);
+}
+
+} // namespace woflang
+
+WOFLANG_PLUGIN_BIND_HOST()
+
+WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_table) {
+    using namespace woflang;
+    (*op_table)["factorial"] = [](std::stack<WofValue>& st) {
+        int64_t n = pop_int(st, "factorial");
+        int64_t r = 0;
+        bool fits = factorial(n, &r);
+        push_result(st, fits, r, fits ? 0.0 : std::exp(std::lgamma(n + 1.0)));
+    };
+    (*op_table)["permutations"] = [](std::stack<WofValue>& st) {
+        int64_t k = pop_int(st, "permutations");
+        int64_t n = pop_int(st, "permutations");
+        int64_t r = 0;
+        bool fits = permutations(n, k, &r);
+        push_result(st, fits, r, fits ? 0.0 : std::exp(std::lgamma(n + 1.0) - std::lgamma(n - k + 1.0)));
+    };
+    (*op_table)["combinations"] = [](std::stack<WofValue>& st) {
+        int64_t k = pop_int(st, "combinations");
+        int64_t n = pop_int(st, "combinations");
+        int64_t r = 0;
+        bool fits = combinations(n, k, &r);
+        push_result(st, fits, r,
+                    fits ? 0.0 : std::round(std::exp(std::lgamma(n + 1.0) - std::lgamma(k + 1.0) - std::lgamma(n - k + 1.0))));
+    };
+}
+
+WOFLANG_PLUGIN_EXPORT void declare_pure_ops(woflang::PureOpSink declare, void* ctx) {
+    declare(ctx, "factorial", 1);
+    declare(ctx, "permutations", 2);
+    declare(ctx, "combinations", 2);
+}
@@ -8,6 +8,8 @@
 #include <chrono>
 #include <map>
 #include <algorithm>
+#include <span>
+#include <stdexcept>
 
 extern "C" {
 
@@ -26,6 +28,27 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
             return;
         }
         
+        // Entropy of a sequence on top, streamed without materializing it
+        if (stack.top().is_array()) {
+            woflang::WofValue seq = stack.top(); stack.pop();
+            std::map<double, size_t> seq_counts;
+            size_t n = 0;
+            woflang::for_each_chunk(seq, [&](std::span<const double> chunk) {
+                for (double x : chunk) seq_counts[x]++;
+                n += chunk.size();
+            });
+            double entropy = 0.0;
+            for (const auto& [_, count] : seq_counts) {
+                double p = static_cast<double>(count) / static_cast<double>(n);
+                entropy -= p * std::log2(p);
+            }
+            std::cout << "Sequence entropy: " << entropy << " bits\n";
+            woflang::WofValue result;
+            result.d = entropy;
+            stack.push(result);
+            return;
+        }
+
         // Calculate Shannon entropy of the stack
         std::map<double, int> counts;
         double total = 0;
@@ -86,6 +109,29 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     };
     
     (*op_table)["order"] = [](std::stack<woflang::WofValue>& stack) {
+        // A sequence on top is sorted in place; ranges just flip direction
+        if (!stack.empty() && stack.top().is_array()) {
+            woflang::WofValue seq = stack.top(); stack.pop();
+            size_t n = woflang::array_size(seq);
+            if (n == woflang::kUnbounded) {
+                stack.push(seq);
+                throw std::runtime_error("order: unbounded sequence");
+            }
+            woflang::WofValue result;
+            if (seq.lazy && seq.lazy->kind == woflang::LazyExpr::Kind::Range) {
+                const auto& r = *seq.lazy;
+                double last = r.scalar + r.step * static_cast<double>(n ? n - 1 : 0);
+                result.lazy = r.step >= 0 ? seq.lazy
+                                          : woflang::make_range(last, -r.step, n);
+            } else {
+                auto values = *seq.array();
+                std::sort(values.begin(), values.end());
+                result = woflang::WofValue::make_array(std::move(values));
+            }
+            stack.push(result);
+            return;
+        }
+
         if (stack.size() < 2) {
             std::cout << "Order requires at least two elements.\n";
             return;
@@ -109,3 +155,5 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
         std::cout << "Order has been restored to the stack.\n";
     };
 }
+
+} // extern "C"
@@ -9,13 +9,19 @@
 
 #include "../../src/core/woflang.hpp"
 #include <cmath>
+#include <iostream>
 #include <stack>
 #include <stdexcept>
 
 namespace woflang {
+// Huge max_iter values are user input; poll the governor every 1024 iterations.
+static inline void yield_point(int i, const char* op){
+    if ((i & 0x3FF) == 0 && should_yield()) throw BudgetExceeded(std::string(op)+": interrupted by resource governor");
+}
 static int mandelbrot_iters(double cr,double ci,int max_iter){
     double zr=0,zi=0; int i=0;
     while(i<max_iter){
+        yield_point(i,"mandelbrot");
         double zr2=zr*zr-zi*zi+cr;
         double zi2=2*zr*zi+ci;
         zr=zr2; zi=zi2;
@@ -27,6 +33,7 @@ static int mandelbrot_iters(double cr,double ci,int max_iter){
 static int julia_iters(double zr,double zi,double cr,double ci,int max_iter){
     int i=0;
     while(i<max_iter){
+        yield_point(i,"julia");
         double zr2=zr*zr-zi*zi+cr;
         double zi2=2*zr*zi+ci;
         zr=zr2; zi=zi2;
@@ -63,6 +70,14 @@ static double hausdorff_dimension(double scale, double count) {
 }
 }
 
+WOFLANG_PLUGIN_BIND_HOST()
+
+// Escape-time counts are pure functions of their arguments
+WOFLANG_PLUGIN_EXPORT void declare_pure_ops(woflang::PureOpSink declare, void* ctx) {
+    declare(ctx, "mandelbrot", 3);
+    declare(ctx, "julia", 5);
+}
+
 WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* ops){
     using namespace woflang;
     if (!ops) return;
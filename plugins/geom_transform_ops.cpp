@@ -50,3 +50,13 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* ops
         S.push(WofValue(-need_num(x,"reflect_y"))); S.push(WofValue(need_num(y,"reflect_y")));
     };
 }
+
+// Declared effects make the interpreter check depth before these handlers,
+// which pop without testing for underflow.
+WOFLANG_PLUGIN_EXPORT void declare_stack_effects(woflang::StackEffectSink declare, void* ctx){
+    declare(ctx, "rotate2d", 3, 2);
+    declare(ctx, "translate2d", 4, 2);
+    declare(ctx, "scale2d", 4, 2);
+    declare(ctx, "reflect_x", 2, 2);
+    declare(ctx, "reflect_y", 2, 2);
+}
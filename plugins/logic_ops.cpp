@@ -21,10 +21,6 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     
     // Boolean Operations
     (*op_table)["and"] = [to_bool](std::stack<woflang::WofValue>& stack) {
-        if (stack.size() < 2) {
-            throw std::runtime_error("and requires two values");
-        }
-        
         auto b = stack.top(); stack.pop();
         auto a = stack.top(); stack.pop();
         
@@ -36,10 +32,6 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     };
     
     (*op_table)["or"] = [to_bool](std::stack<woflang::WofValue>& stack) {
-        if (stack.size() < 2) {
-            throw std::runtime_error("or requires two values");
-        }
-        
         auto b = stack.top(); stack.pop();
         auto a = stack.top(); stack.pop();
         
@@ -51,10 +43,6 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     };
     
     (*op_table)["xor"] = [to_bool](std::stack<woflang::WofValue>& stack) {
-        if (stack.size() < 2) {
-            throw std::runtime_error("xor requires two values");
-        }
-        
         auto b = stack.top(); stack.pop();
         auto a = stack.top(); stack.pop();
         
@@ -66,10 +54,6 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     };
     
     (*op_table)["not"] = [to_bool](std::stack<woflang::WofValue>& stack) {
-        if (stack.empty()) {
-            throw std::runtime_error("not requires a value");
-        }
-        
         auto a = stack.top(); stack.pop();
         
         bool result = !to_bool(a);
@@ -80,10 +64,6 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     };
     
     (*op_table)["implies"] = [to_bool](std::stack<woflang::WofValue>& stack) {
-        if (stack.size() < 2) {
-            throw std::runtime_error("implies requires two values");
-        }
-        
         auto b = stack.top(); stack.pop();
         auto a = stack.top(); stack.pop();
         
@@ -95,10 +75,6 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     };
     
     (*op_table)["equivalent"] = [to_bool](std::stack<woflang::WofValue>& stack) {
-        if (stack.size() < 2) {
-            throw std::runtime_error("equivalent requires two values");
-        }
-        
         auto b = stack.top(); stack.pop();
         auto a = stack.top(); stack.pop();
         
@@ -110,10 +86,6 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     };
     
     (*op_table)["nand"] = [to_bool](std::stack<woflang::WofValue>& stack) {
-        if (stack.size() < 2) {
-            throw std::runtime_error("nand requires two values");
-        }
-        
         auto b = stack.top(); stack.pop();
         auto a = stack.top(); stack.pop();
         
@@ -125,10 +97,6 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     };
     
     (*op_table)["nor"] = [to_bool](std::stack<woflang::WofValue>& stack) {
-        if (stack.size() < 2) {
-            throw std::runtime_error("nor requires two values");
-        }
-        
         auto b = stack.top(); stack.pop();
         auto a = stack.top(); stack.pop();
         
@@ -183,3 +151,13 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     };
 }
 
+WOFLANG_PLUGIN_EXPORT void declare_stack_effects(woflang::StackEffectSink declare, void* ctx) {
+    for (const char* op : {"and", "or", "xor", "implies", "equivalent", "nand", "nor"}) {
+        declare(ctx, op, 2, 1);
+    }
+    declare(ctx, "not", 1, 1);
+    declare(ctx, "tautology", 0, 1);
+    declare(ctx, "contradiction", 0, 1);
+}
+
+} // extern "C"
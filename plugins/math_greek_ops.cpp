@@ -49,6 +49,17 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
             std::cout << "Σ: Stack is empty\n";
             return;
         }
+
+        // A sequence on top is reduced on its own, streamed in chunks.
+        if (stack.top().is_array()) {
+            // Reduced in place: an unbounded sequence throws and stays put.
+            woflang::WofValue result;
+            result.d = woflang::reduce_sum(stack.top());
+            stack.pop();
+            stack.push(result);
+            std::cout << "Σ = " << result.d << "\n";
+            return;
+        }
         
         double sum = 0.0;
         while (!stack.empty()) {
@@ -67,6 +78,17 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
             std::cout << "sum: Stack is empty\n";
             return;
         }
+
+        // A sequence on top is reduced on its own, streamed in chunks.
+        if (stack.top().is_array()) {
+            // Reduced in place: an unbounded sequence throws and stays put.
+            woflang::WofValue result;
+            result.d = woflang::reduce_sum(stack.top());
+            stack.pop();
+            stack.push(result);
+            std::cout << "sum = " << result.d << "\n";
+            return;
+        }
         
         double sum = 0.0;
         while (!stack.empty()) {
@@ -86,6 +108,17 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
             std::cout << "Π: Stack is empty\n";
             return;
         }
+
+        // A sequence on top is reduced on its own, streamed in chunks.
+        if (stack.top().is_array()) {
+            // Reduced in place: an unbounded sequence throws and stays put.
+            woflang::WofValue result;
+            result.d = woflang::reduce_product(stack.top());
+            stack.pop();
+            stack.push(result);
+            std::cout << "Π = " << result.d << "\n";
+            return;
+        }
         
         double product = 1.0;
         while (!stack.empty()) {
@@ -104,6 +137,17 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
             std::cout << "product: Stack is empty\n";
             return;
         }
+
+        // A sequence on top is reduced on its own, streamed in chunks.
+        if (stack.top().is_array()) {
+            // Reduced in place: an unbounded sequence throws and stays put.
+            woflang::WofValue result;
+            result.d = woflang::reduce_product(stack.top());
+            stack.pop();
+            stack.push(result);
+            std::cout << "product = " << result.d << "\n";
+            return;
+        }
         
         double product = 1.0;
         while (!stack.empty()) {
@@ -209,3 +253,5 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
         while (!stack.empty()) stack.pop();
     };
 }
+
+} // extern "C"
@@ -2,6 +2,7 @@
 // math_ops.cpp - Enhanced Mathematical Operations (Preserves Core Ops)
 // ==================================================
 #include "core/woflang.hpp"
+#include "core/int_math.hpp"
 #include <cmath>
 #include <iostream>
 #include <limits>
@@ -36,7 +37,16 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
         }
         
         // Display top of stack without popping it
-        std::cout << std::fixed << std::setprecision(6) << stack.top().d << std::endl;
+        const auto& top = stack.top();
+        if (top.is_array() || top.is_quotation()) {
+            std::cout << top.to_string() << std::endl;
+            return;
+        }
+        if (top.exact) {
+            std::cout << top.i << std::endl;
+            return;
+        }
+        std::cout << std::fixed << std::setprecision(6) << top.d << std::endl;
     };
     
     // Stack display that shows entire stack (useful for debugging)
@@ -60,7 +70,10 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
         bool first = true;
         while (!temp.empty()) {
             if (!first) std::cout << " ";
-            std::cout << std::fixed << std::setprecision(6) << temp.top().d;
+            const auto& v = temp.top();
+            if (v.is_array() || v.is_quotation()) std::cout << v.to_string();
+            else if (v.exact) std::cout << v.i;
+            else std::cout << std::fixed << std::setprecision(6) << v.d;
             temp.pop();
             first = false;
         }
@@ -69,23 +82,14 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     
     // Basic Stack Operations
     (*op_table)["dup"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.empty()) {
-            throw std::runtime_error("Stack underflow on dup");
-        }
         stack.push(stack.top());
     };
     
     (*op_table)["drop"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.empty()) {
-            throw std::runtime_error("Stack underflow on drop");
-        }
         stack.pop();
     };
     
     (*op_table)["swap"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.size() < 2) {
-            throw std::runtime_error("Stack underflow on swap");
-        }
         auto a = stack.top(); stack.pop();
         auto b = stack.top(); stack.pop();
         stack.push(a);
@@ -93,9 +97,6 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     };
     
     (*op_table)["over"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.size() < 2) {
-            throw std::runtime_error("Stack underflow on over");
-        }
         auto a = stack.top(); stack.pop();
         auto b = stack.top(); 
         stack.push(a);
@@ -103,9 +104,6 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     };
     
     (*op_table)["rot"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.size() < 3) {
-            throw std::runtime_error("Stack underflow on rot");
-        }
         auto a = stack.top(); stack.pop();
         auto b = stack.top(); stack.pop();
         auto c = stack.top(); stack.pop();
@@ -116,45 +114,49 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     
     // Arithmetic Operations
     (*op_table)["+"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.size() < 2) {
-            throw std::runtime_error("Stack underflow on +");
-        }
+        if (woflang::fuse_binary(stack, woflang::ElemOp::Add)) return;
         auto b = stack.top(); stack.pop();
         auto a = stack.top(); stack.pop();
         
         woflang::WofValue result;
+        if (woflang::int_binary(woflang::ElemOp::Add, a, b, result)) {
+            stack.push(result);
+            return;
+        }
         result.d = a.d + b.d;
         stack.push(result);
     };
     
     (*op_table)["-"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.size() < 2) {
-            throw std::runtime_error("Stack underflow on -");
-        }
+        if (woflang::fuse_binary(stack, woflang::ElemOp::Sub)) return;
         auto b = stack.top(); stack.pop();
         auto a = stack.top(); stack.pop();
         
         woflang::WofValue result;
+        if (woflang::int_binary(woflang::ElemOp::Sub, a, b, result)) {
+            stack.push(result);
+            return;
+        }
         result.d = a.d - b.d;
         stack.push(result);
     };
     
     (*op_table)["*"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.size() < 2) {
-            throw std::runtime_error("Stack underflow on *");
-        }
+        if (woflang::fuse_binary(stack, woflang::ElemOp::Mul)) return;
         auto b = stack.top(); stack.pop();
         auto a = stack.top(); stack.pop();
         
         woflang::WofValue result;
+        if (woflang::int_binary(woflang::ElemOp::Mul, a, b, result)) {
+            stack.push(result);
+            return;
+        }
         result.d = a.d * b.d;
         stack.push(result);
     };
     
     (*op_table)["/"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.size() < 2) {
-            throw std::runtime_error("Stack underflow on /");
-        }
+        if (woflang::fuse_binary(stack, woflang::ElemOp::Div)) return;
         auto b = stack.top(); stack.pop();
         auto a = stack.top(); stack.pop();
         
@@ -163,15 +165,17 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
         }
         
         woflang::WofValue result;
+        if (woflang::int_binary(woflang::ElemOp::Div, a, b, result)) {
+            stack.push(result);
+            return;
+        }
         result.d = a.d / b.d;
         stack.push(result);
     };
     
     // Modulo operation
     (*op_table)["mod"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.size() < 2) {
-            throw std::runtime_error("Stack underflow on mod");
-        }
+        if (woflang::fuse_binary(stack, woflang::ElemOp::Mod)) return;
         auto b = stack.top(); stack.pop();
         auto a = stack.top(); stack.pop();
         
@@ -180,27 +184,31 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
         }
         
         woflang::WofValue result;
+        if (woflang::int_binary(woflang::ElemOp::Mod, a, b, result)) {
+            stack.push(result);
+            return;
+        }
         result.d = std::fmod(a.d, b.d);
         stack.push(result);
     };
     
     // Power and roots
     (*op_table)["pow"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.size() < 2) {
-            throw std::runtime_error("Stack underflow on pow");
-        }
+        if (woflang::fuse_binary(stack, woflang::ElemOp::Pow)) return;
         auto b = stack.top(); stack.pop();
         auto a = stack.top(); stack.pop();
         
         woflang::WofValue result;
+        if (woflang::int_binary(woflang::ElemOp::Pow, a, b, result)) {
+            stack.push(result);
+            return;
+        }
         result.d = std::pow(a.d, b.d);
         stack.push(result);
     };
     
     (*op_table)["sqrt"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.empty()) {
-            throw std::runtime_error("Stack underflow on sqrt");
-        }
+        if (woflang::fuse_unary(stack, woflang::ElemOp::Sqrt)) return;
         auto a = stack.top(); stack.pop();
         
         if (a.d < 0.0) {
@@ -213,9 +221,7 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     };
     
     (*op_table)["cbrt"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.empty()) {
-            throw std::runtime_error("Stack underflow on cbrt");
-        }
+        if (woflang::fuse_unary(stack, woflang::ElemOp::Cbrt)) return;
         auto a = stack.top(); stack.pop();
         
         woflang::WofValue result;
@@ -225,9 +231,7 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     
     // Trigonometric functions (radians)
     (*op_table)["sin"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.empty()) {
-            throw std::runtime_error("Stack underflow on sin");
-        }
+        if (woflang::fuse_unary(stack, woflang::ElemOp::Sin)) return;
         auto a = stack.top(); stack.pop();
         
         woflang::WofValue result;
@@ -236,9 +240,7 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     };
     
     (*op_table)["cos"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.empty()) {
-            throw std::runtime_error("Stack underflow on cos");
-        }
+        if (woflang::fuse_unary(stack, woflang::ElemOp::Cos)) return;
         auto a = stack.top(); stack.pop();
         
         woflang::WofValue result;
@@ -247,9 +249,7 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     };
     
     (*op_table)["tan"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.empty()) {
-            throw std::runtime_error("Stack underflow on tan");
-        }
+        if (woflang::fuse_unary(stack, woflang::ElemOp::Tan)) return;
         auto a = stack.top(); stack.pop();
         
         woflang::WofValue result;
@@ -259,9 +259,7 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     
     // Inverse trigonometric functions
     (*op_table)["asin"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.empty()) {
-            throw std::runtime_error("Stack underflow on asin");
-        }
+        if (woflang::fuse_unary(stack, woflang::ElemOp::Asin)) return;
         auto a = stack.top(); stack.pop();
         
         if (a.d < -1.0 || a.d > 1.0) {
@@ -274,9 +272,7 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     };
     
     (*op_table)["acos"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.empty()) {
-            throw std::runtime_error("Stack underflow on acos");
-        }
+        if (woflang::fuse_unary(stack, woflang::ElemOp::Acos)) return;
         auto a = stack.top(); stack.pop();
         
         if (a.d < -1.0 || a.d > 1.0) {
@@ -289,9 +285,7 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     };
     
     (*op_table)["atan"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.empty()) {
-            throw std::runtime_error("Stack underflow on atan");
-        }
+        if (woflang::fuse_unary(stack, woflang::ElemOp::Atan)) return;
         auto a = stack.top(); stack.pop();
         
         woflang::WofValue result;
@@ -301,9 +295,7 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     
     // Degree conversion helpers
     (*op_table)["deg2rad"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.empty()) {
-            throw std::runtime_error("Stack underflow on deg2rad");
-        }
+        if (woflang::fuse_unary(stack, woflang::ElemOp::Deg2Rad)) return;
         auto a = stack.top(); stack.pop();
         
         woflang::WofValue result;
@@ -312,9 +304,7 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     };
     
     (*op_table)["rad2deg"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.empty()) {
-            throw std::runtime_error("Stack underflow on rad2deg");
-        }
+        if (woflang::fuse_unary(stack, woflang::ElemOp::Rad2Deg)) return;
         auto a = stack.top(); stack.pop();
         
         woflang::WofValue result;
@@ -324,9 +314,7 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     
     // Hyperbolic functions
     (*op_table)["sinh"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.empty()) {
-            throw std::runtime_error("Stack underflow on sinh");
-        }
+        if (woflang::fuse_unary(stack, woflang::ElemOp::Sinh)) return;
         auto a = stack.top(); stack.pop();
         
         woflang::WofValue result;
@@ -335,9 +323,7 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     };
     
     (*op_table)["cosh"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.empty()) {
-            throw std::runtime_error("Stack underflow on cosh");
-        }
+        if (woflang::fuse_unary(stack, woflang::ElemOp::Cosh)) return;
         auto a = stack.top(); stack.pop();
         
         woflang::WofValue result;
@@ -346,9 +332,7 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     };
     
     (*op_table)["tanh"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.empty()) {
-            throw std::runtime_error("Stack underflow on tanh");
-        }
+        if (woflang::fuse_unary(stack, woflang::ElemOp::Tanh)) return;
         auto a = stack.top(); stack.pop();
         
         woflang::WofValue result;
@@ -358,9 +342,7 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     
     // Logarithmic functions
     (*op_table)["ln"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.empty()) {
-            throw std::runtime_error("Stack underflow on ln");
-        }
+        if (woflang::fuse_unary(stack, woflang::ElemOp::Ln)) return;
         auto a = stack.top(); stack.pop();
         
         if (a.d <= 0.0) {
@@ -373,9 +355,7 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     };
     
     (*op_table)["log10"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.empty()) {
-            throw std::runtime_error("Stack underflow on log10");
-        }
+        if (woflang::fuse_unary(stack, woflang::ElemOp::Log10)) return;
         auto a = stack.top(); stack.pop();
         
         if (a.d <= 0.0) {
@@ -388,9 +368,7 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     };
     
     (*op_table)["log2"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.empty()) {
-            throw std::runtime_error("Stack underflow on log2");
-        }
+        if (woflang::fuse_unary(stack, woflang::ElemOp::Log2)) return;
         auto a = stack.top(); stack.pop();
         
         if (a.d <= 0.0) {
@@ -403,9 +381,7 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     };
     
     (*op_table)["exp"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.empty()) {
-            throw std::runtime_error("Stack underflow on exp");
-        }
+        if (woflang::fuse_unary(stack, woflang::ElemOp::Exp)) return;
         auto a = stack.top(); stack.pop();
         
         woflang::WofValue result;
@@ -415,20 +391,20 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     
     // Utility functions
     (*op_table)["abs"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.empty()) {
-            throw std::runtime_error("Stack underflow on abs");
-        }
+        if (woflang::fuse_unary(stack, woflang::ElemOp::Abs)) return;
         auto a = stack.top(); stack.pop();
         
+        if (a.exact && a.i != std::numeric_limits<int64_t>::min()) {
+            stack.push(woflang::WofValue::make_int(a.i < 0 ? -a.i : a.i));
+            return;
+        }
         woflang::WofValue result;
         result.d = std::abs(a.d);
         stack.push(result);
     };
     
     (*op_table)["floor"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.empty()) {
-            throw std::runtime_error("Stack underflow on floor");
-        }
+        if (woflang::fuse_unary(stack, woflang::ElemOp::Floor)) return;
         auto a = stack.top(); stack.pop();
         
         woflang::WofValue result;
@@ -437,9 +413,7 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     };
     
     (*op_table)["ceil"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.empty()) {
-            throw std::runtime_error("Stack underflow on ceil");
-        }
+        if (woflang::fuse_unary(stack, woflang::ElemOp::Ceil)) return;
         auto a = stack.top(); stack.pop();
         
         woflang::WofValue result;
@@ -448,9 +422,7 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     };
     
     (*op_table)["round"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.empty()) {
-            throw std::runtime_error("Stack underflow on round");
-        }
+        if (woflang::fuse_unary(stack, woflang::ElemOp::Round)) return;
         auto a = stack.top(); stack.pop();
         
         woflang::WofValue result;
@@ -459,9 +431,7 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     };
     
     (*op_table)["trunc"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.empty()) {
-            throw std::runtime_error("Stack underflow on trunc");
-        }
+        if (woflang::fuse_unary(stack, woflang::ElemOp::Trunc)) return;
         auto a = stack.top(); stack.pop();
         
         woflang::WofValue result;
@@ -471,9 +441,7 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     
     // Sign function
     (*op_table)["sign"] = [](std::stack<woflang::WofValue>& stack) {
-        if (stack.empty()) {
-            throw std::runtime_error("Stack underflow on sign");
-        }
+        if (woflang::fuse_unary(stack, woflang::ElemOp::Sign)) return;
         auto a = stack.top(); stack.pop();
         
         woflang::WofValue result;
@@ -483,25 +451,67 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     
     // Min/Max functions
     (*op_table)["min"] = [](std::stack<woflang::WofValue>& stack) {
+        // A sequence on top (with no array below it) is reduced instead.
+        if (!stack.empty() && stack.top().is_array()) {
+            woflang::WofValue top = stack.top(); stack.pop();
+            if (stack.empty() || !stack.top().is_array()) {
+                woflang::WofValue result;
+                try {
+                    result.d = woflang::reduce_min(top);
+                } catch (...) {
+                    stack.push(top);  // e.g. an unbounded sequence
+                    throw;
+                }
+                stack.push(result);
+                return;
+            }
+            stack.push(top);
+        }
         if (stack.size() < 2) {
             throw std::runtime_error("Stack underflow on min");
         }
+        if (woflang::fuse_binary(stack, woflang::ElemOp::Min)) return;
         auto b = stack.top(); stack.pop();
         auto a = stack.top(); stack.pop();
         
         woflang::WofValue result;
+        if (woflang::int_binary(woflang::ElemOp::Min, a, b, result)) {
+            stack.push(result);
+            return;
+        }
         result.d = std::min(a.d, b.d);
         stack.push(result);
     };
     
     (*op_table)["max"] = [](std::stack<woflang::WofValue>& stack) {
+        // A sequence on top (with no array below it) is reduced instead.
+        if (!stack.empty() && stack.top().is_array()) {
+            woflang::WofValue top = stack.top(); stack.pop();
+            if (stack.empty() || !stack.top().is_array()) {
+                woflang::WofValue result;
+                try {
+                    result.d = woflang::reduce_max(top);
+                } catch (...) {
+                    stack.push(top);  // e.g. an unbounded sequence
+                    throw;
+                }
+                stack.push(result);
+                return;
+            }
+            stack.push(top);
+        }
         if (stack.size() < 2) {
             throw std::runtime_error("Stack underflow on max");
         }
+        if (woflang::fuse_binary(stack, woflang::ElemOp::Max)) return;
         auto b = stack.top(); stack.pop();
         auto a = stack.top(); stack.pop();
         
         woflang::WofValue result;
+        if (woflang::int_binary(woflang::ElemOp::Max, a, b, result)) {
+            stack.push(result);
+            return;
+        }
         result.d = std::max(a.d, b.d);
         stack.push(result);
     };
@@ -531,3 +541,23 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
         stack.push(result);
     };
 }
+
+// Fixed stack effects; the interpreter checks depth before these handlers
+// run, so they no longer test for underflow themselves. min and max reduce
+// a sequence when one is on top, so their effect is not fixed.
+WOFLANG_PLUGIN_EXPORT void declare_stack_effects(woflang::StackEffectSink declare, void* ctx) {
+    declare(ctx, "dup", 1, 2);
+    declare(ctx, "drop", 1, 0);
+    declare(ctx, "swap", 2, 2);
+    declare(ctx, "over", 2, 3);
+    declare(ctx, "rot", 3, 3);
+    for (const char* op : {"+", "-", "*", "/", "mod", "pow"}) declare(ctx, op, 2, 1);
+    for (const char* op : {"sqrt", "cbrt", "sin", "cos", "tan", "asin", "acos", "atan",
+                           "deg2rad", "rad2deg", "sinh", "cosh", "tanh", "ln", "log10",
+                           "log2", "exp", "abs", "floor", "ceil", "round", "trunc", "sign"}) {
+        declare(ctx, op, 1, 1);
+    }
+    for (const char* op : {"pi", "e", "tau", "phi"}) declare(ctx, op, 0, 1);
+}
+
+} // extern "C"
@@ -1,5 +1,6 @@
 // plugins/modexp_ops.cpp
 #include <iostream>
+#include <stdexcept>
 
 #ifndef WOFLANG_PLUGIN_EXPORT
 #  ifdef _WIN32
@@ -9,16 +10,69 @@
 #  endif
 #endif
 
-WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_table) {
+#include "core/woflang.hpp"
+#include "core/int_math.hpp"
 
 namespace woflang {
 
+// (a*b) mod m for 0 <= a, b < m, without overflow for any 63-bit modulus.
+static int64_t mulmod(int64_t a,int64_t b,int64_t mod){
+    uint64_t x=static_cast<uint64_t>(a), y=static_cast<uint64_t>(b), m=static_cast<uint64_t>(mod);
+#if defined(__SIZEOF_INT128__)
+    return static_cast<int64_t>((static_cast<__uint128_t>(x)*y)%m);
+#else
+    // Operands stay below 2^63, so doubling one cannot wrap a uint64_t.
+    uint64_t res=0;
+    while(y>0){
+        if(y&1){ res+=x; if(res>=m) res-=m; }
+        y>>=1;
+        x+=x; if(x>=m) x-=m;
+    }
+    return static_cast<int64_t>(res);
+#endif
+}
+
 long long modexp(long long base,long long exp,long long mod){
-    long long res=1; base%=mod;
+    if(mod<=0) throw std::runtime_error("modexp: modulus must be positive");
+    if(exp<0) throw std::runtime_error("modexp: negative exponent");
+    long long res=1%mod; base%=mod; if(base<0) base+=mod;
     while(exp>0){
-        if(exp&1) res=(res*base)%mod;
+        if(exp&1) res=mulmod(res,base,mod);
         exp>>=1;
-        base=(base*base)%mod;
+        base=mulmod(base,base,mod);
     }
     return res;
 }
+
+static int64_t to_int(const WofValue& v,const char* op){
+    int64_t x=0;
+    if(!exact_int(v,&x)) throw std::runtime_error(std::string(op)+": integer argument required");
+    return x;
+}
+
+} // namespace woflang
+
+WOFLANG_PLUGIN_BIND_HOST()
+
+WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_table) {
+    // base exp mod modexp -> base^exp mod mod, computed on exact int64
+    (*op_table)["modexp"]=[](std::stack<woflang::WofValue>& st){
+        if(st.size()<3) throw std::runtime_error("Stack underflow on modexp");
+        // Off the stack while they are checked; back on it if one is bad.
+        woflang::WofValue args[3];  // base exp mod
+        for(size_t k=3;k-->0;){ args[k]=std::move(st.top()); st.pop(); }
+        try{
+            int64_t base=woflang::to_int(args[0],"modexp");
+            int64_t exp=woflang::to_int(args[1],"modexp");
+            int64_t mod=woflang::to_int(args[2],"modexp");
+            st.push(woflang::WofValue::make_int(woflang::modexp(base,exp,mod)));
+        }catch(...){
+            for(auto& v:args) st.push(std::move(v));
+            throw;
+        }
+    };
+}
+
+WOFLANG_PLUGIN_EXPORT void declare_pure_ops(woflang::PureOpSink declare, void* ctx) {
+    declare(ctx, "modexp", 3);
+}
@@ -11,14 +11,21 @@
 // Fixed prime_ops.cpp for current WofValue API
 #include "../../src/core/woflang.hpp"
 #include <iostream>
-#include <random>
-#include <chrono>
+#include <algorithm>
 #include <cmath>
+#include <iterator>
 
 namespace woflang {
 
 // Convert WofValue to uint64_t (assuming WofValue has .d field)
 uint64_t to_u64_throw(const WofValue& v, const char* context) {
+    if (v.exact) {
+        // Integers arrive unconverted, so inputs above 2^53 stay exact.
+        if (v.i < 0) {
+            throw std::runtime_error(std::string(context) + ": negative value");
+        }
+        return static_cast<uint64_t>(v.i);
+    }
     double d = v.d;
     if (d < 0) {
         throw std::runtime_error(std::string(context) + ": negative value");
@@ -31,23 +38,30 @@ uint64_t to_u64_throw(const WofValue& v, const char* context) {
 
 // Push boolean as integer
 void push_bool(std::stack<WofValue>& st, bool b) {
-    WofValue result;
-    result.d = b ? 1.0 : 0.0;
-    st.push(result);
+    st.push(WofValue::make_int(b ? 1 : 0));
 }
 
-// Push uint64_t as double
+// Push uint64_t as an exact integer, or as double past INT64_MAX
 void push_u64(std::stack<WofValue>& st, uint64_t x) {
+    if (x <= static_cast<uint64_t>(INT64_MAX)) {
+        st.push(WofValue::make_int(static_cast<int64_t>(x)));
+        return;
+    }
     WofValue result;
     result.d = static_cast<double>(x);
     st.push(result);
 }
 
-// Miller-Rabin primality test
-bool miller_rabin(uint64_t n, int rounds = 10) {
+// Miller-Rabin primality test. Witnesses are the first primes rather than
+// random bases: the first 12 make the test exact for every 64-bit n, and a
+// fixed set keeps prime_check pure (same answer every call), so its results
+// can be memoized.
+bool miller_rabin(uint64_t n, int rounds = 12) {
+    static constexpr uint64_t witnesses[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
     if (n < 2) return false;
-    if (n == 2 || n == 3) return true;
-    if (n % 2 == 0) return false;
+    for (uint64_t p : witnesses) {
+        if (n % p == 0) return n == p;
+    }
 
     // Write n-1 as d * 2^r
     uint64_t d = n - 1;
@@ -57,12 +71,9 @@ bool miller_rabin(uint64_t n, int rounds = 10) {
         r++;
     }
 
-    // Random number generator
-    static std::mt19937_64 gen(std::chrono::steady_clock::now().time_since_epoch().count());
-    
-    for (int i = 0; i < rounds; i++) {
-        std::uniform_int_distribution<uint64_t> dis(2, n - 2);
-        uint64_t a = dis(gen);
+    int count = std::clamp(rounds, 1, static_cast<int>(std::size(witnesses)));
+    for (int i = 0; i < count; i++) {
+        uint64_t a = witnesses[i];
         
         // Compute a^d mod n
         uint64_t x = 1;
@@ -118,7 +129,7 @@ void op_prime_check(std::stack<WofValue>& st) {
         if (n < 1000000) {
             is_prime = is_prime_simple(n);
         } else {
-            is_prime = miller_rabin(n, 10);
+            is_prime = miller_rabin(n);
         }
         
         push_bool(st, is_prime);
@@ -214,3 +225,12 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_
     (*op_table)["miller_rabin"] = woflang::op_miller_rabin;
     (*op_table)["prime_version"] = woflang::op_prime_version;
 }
+
+// prime_check and friends depend only on their arguments
+WOFLANG_PLUGIN_EXPORT void declare_pure_ops(woflang::PureOpSink declare, void* ctx) {
+    declare(ctx, "prime_check", 1);
+    declare(ctx, "prime_check_ultra", 1);
+    declare(ctx, "miller_rabin", 2);
+}
+
+} // extern "C"
@@ -5,6 +5,9 @@
 #include <tuple>
 #include <limits>
 #include <stdexcept>
+#include <stack>
+#include <string>
+#include <cmath>
 
 #ifndef WOFLANG_PLUGIN_EXPORT
 #  ifdef _WIN32
@@ -14,7 +17,7 @@
 #  endif
 #endif
 
-WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_table) {
+#include "core/woflang.hpp"
 
 namespace woflang {
 
@@ -39,14 +42,87 @@ std::vector<double> bellmanFord(const std::vector<Edge>& edges,int n,int start){
     std::vector<double> dist(n,std::numeric_limits<double>::infinity());
     dist[start]=0;
     for(int i=1;i<n;++i){
+        // O(V*E): give the resource governor a chance to stop us each round
+        if(should_yield()) throw BudgetExceeded("bellmanFord: interrupted by resource governor");
         for(auto [u,v,w]:edges){
             if(dist[u]!=std::numeric_limits<double>::infinity() && dist[u]+w<dist[v]) dist[v]=dist[u]+w;
         }
     }
     for(auto [u,v,w]:edges){
-        if(dist[u]!=std::numeric_limits<double>::infinity() && dist[u]+w<dist[v]) throw std::runtime_error("neg cycle");
+        if(dist[u]!=std::numeric_limits<double>::infinity() && dist[u]+w<dist[v]) throw std::runtime_error("bellmanFord: negative cycle reachable from start");
     }
     return dist;
 }
 
+// Operands of both ops: a flat array of directed edges "u v w ...", the
+// vertex count and the start vertex. Checked before anything is popped.
+struct Graph {
+    std::vector<Edge> edges;
+    int n;
+    int start;
+};
+
+static Graph peek_graph(const std::stack<WofValue>& S, const char* op) {
+    auto fail = [&](const std::string& why) { return std::runtime_error(std::string(op) + ": " + why); };
+    if (S.size() < 3) throw fail("expects edges vertex-count start");
+    auto copy = S;
+    WofValue start = copy.top(); copy.pop();
+    WofValue n = copy.top(); copy.pop();
+    const WofValue& edges = copy.top();
+    double nv = n.as_numeric(), sv = start.as_numeric();
+    if (!(nv >= 1 && nv <= 1e7) || nv != std::floor(nv)) throw fail("vertex count must be a positive integer");
+    if (!(sv >= 0 && sv < nv) || sv != std::floor(sv)) throw fail("start must be a vertex index");
+    if (!edges.is_array() || array_size(edges) == kUnbounded || array_size(edges) % 3 != 0) {
+        throw fail("edges must be an array of u v w triples");
+    }
+    Graph g{{}, static_cast<int>(nv), static_cast<int>(sv)};
+    auto values = edges.array();
+    for (size_t k = 0; k < values->size(); k += 3) {
+        double u = (*values)[k], v = (*values)[k + 1], w = (*values)[k + 2];
+        if (!(u >= 0 && u < nv && v >= 0 && v < nv) || u != std::floor(u) || v != std::floor(v)) {
+            throw fail("edge " + std::to_string(k / 3) + " names a vertex out of range");
+        }
+        if (std::isnan(w)) throw fail("edge " + std::to_string(k / 3) + " has no weight");
+        g.edges.emplace_back(static_cast<int>(u), static_cast<int>(v), w);
+    }
+    return g;
+}
+
+static void pop_graph(std::stack<WofValue>& S) {
+    for (int k = 0; k < 3; ++k) S.pop();
+}
+
+} // namespace woflang
 
+WOFLANG_PLUGIN_BIND_HOST()
+
+WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* op_table) {
+    using namespace woflang;
+    if (!op_table) return;
+
+    // edges n start dijkstra -> distances (inf where unreachable)
+    (*op_table)["dijkstra"] = [](std::stack<WofValue>& S) {
+        Graph g = peek_graph(S, "dijkstra");
+        std::vector<std::vector<std::pair<int,double>>> adj(g.n);
+        for (auto [u,v,w] : g.edges) {
+            if (w < 0) throw std::runtime_error("dijkstra: negative edge weight, use bellmanFord");
+            adj[u].push_back({v,w});
+        }
+        auto dist = dijkstra(adj, g.start);
+        pop_graph(S);
+        S.push(WofValue::make_array(WofArray(dist.begin(), dist.end())));
+    };
+
+    // edges n start bellmanFord -> distances; negative weights allowed
+    (*op_table)["bellmanFord"] = [](std::stack<WofValue>& S) {
+        Graph g = peek_graph(S, "bellmanFord");
+        auto dist = bellmanFord(g.edges, g.n, g.start);
+        pop_graph(S);
+        S.push(WofValue::make_array(WofArray(dist.begin(), dist.end())));
+    };
+}
+
+WOFLANG_PLUGIN_EXPORT void declare_stack_effects(woflang::StackEffectSink declare, void* ctx) {
+    declare(ctx, "dijkstra", 3, 1);
+    declare(ctx, "bellmanFord", 3, 1);
+}
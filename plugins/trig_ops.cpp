@@ -26,16 +26,21 @@ WOFLANG_PLUGIN_EXPORT void init_plugin(woflang::WoflangInterpreter::OpTable* ops
     using namespace woflang;
     if (!ops) return;
 
-    (*ops)["sin"]  = [](std::stack<WofValue>& S){ auto a=S.top(); S.pop(); S.push(WofValue(std::sin(need_num(a,"sin")))); };
-    (*ops)["cos"]  = [](std::stack<WofValue>& S){ auto a=S.top(); S.pop(); S.push(WofValue(std::cos(need_num(a,"cos")))); };
-    (*ops)["tan"]  = [](std::stack<WofValue>& S){ auto a=S.top(); S.pop(); S.push(WofValue(std::tan(need_num(a,"tan")))); };
-    (*ops)["asin"] = [](std::stack<WofValue>& S){ auto a=S.top(); S.pop(); double v=need_num(a,"asin"); if(v<-1||v>1) throw std::runtime_error("asin: domain"); S.push(WofValue(std::asin(v))); };
-    (*ops)["acos"] = [](std::stack<WofValue>& S){ auto a=S.top(); S.pop(); double v=need_num(a,"acos"); if(v<-1||v>1) throw std::runtime_error("acos: domain"); S.push(WofValue(std::acos(v))); };
-    (*ops)["atan"] = [](std::stack<WofValue>& S){ auto a=S.top(); S.pop(); S.push(WofValue(std::atan(need_num(a,"atan")))); };
-    (*ops)["atan2"]= [](std::stack<WofValue>& S){ auto x=S.top(); S.pop(); auto y=S.top(); S.pop(); S.push(WofValue(std::atan2(need_num(y,"atan2"),need_num(x,"atan2")))); };
-    (*ops)["sinh"] = [](std::stack<WofValue>& S){ auto a=S.top(); S.pop(); S.push(WofValue(std::sinh(need_num(a,"sinh")))); };
-    (*ops)["cosh"] = [](std::stack<WofValue>& S){ auto a=S.top(); S.pop(); S.push(WofValue(std::cosh(need_num(a,"cosh")))); };
-    (*ops)["tanh"] = [](std::stack<WofValue>& S){ auto a=S.top(); S.pop(); S.push(WofValue(std::tanh(need_num(a,"tanh")))); };
-    (*ops)["deg2rad"]= [](std::stack<WofValue>& S){ auto d=S.top(); S.pop(); S.push(WofValue(deg2rad(need_num(d,"deg2rad")))); };
-    (*ops)["rad2deg"]= [](std::stack<WofValue>& S){ auto r=S.top(); S.pop(); S.push(WofValue(rad2deg(need_num(r,"rad2deg")))); };
+    (*ops)["sin"]  = [](std::stack<WofValue>& S){ if (fuse_unary(S, ElemOp::Sin)) return; auto a=S.top(); S.pop(); S.push(WofValue(std::sin(need_num(a,"sin")))); };
+    (*ops)["cos"]  = [](std::stack<WofValue>& S){ if (fuse_unary(S, ElemOp::Cos)) return; auto a=S.top(); S.pop(); S.push(WofValue(std::cos(need_num(a,"cos")))); };
+    (*ops)["tan"]  = [](std::stack<WofValue>& S){ if (fuse_unary(S, ElemOp::Tan)) return; auto a=S.top(); S.pop(); S.push(WofValue(std::tan(need_num(a,"tan")))); };
+    (*ops)["asin"] = [](std::stack<WofValue>& S){ if (fuse_unary(S, ElemOp::Asin)) return; auto a=S.top(); S.pop(); double v=need_num(a,"asin"); if(v<-1||v>1) throw std::runtime_error("asin: domain"); S.push(WofValue(std::asin(v))); };
+    (*ops)["acos"] = [](std::stack<WofValue>& S){ if (fuse_unary(S, ElemOp::Acos)) return; auto a=S.top(); S.pop(); double v=need_num(a,"acos"); if(v<-1||v>1) throw std::runtime_error("acos: domain"); S.push(WofValue(std::acos(v))); };
+    (*ops)["atan"] = [](std::stack<WofValue>& S){ if (fuse_unary(S, ElemOp::Atan)) return; auto a=S.top(); S.pop(); S.push(WofValue(std::atan(need_num(a,"atan")))); };
+    (*ops)["atan2"]= [](std::stack<WofValue>& S){ if (fuse_binary(S, ElemOp::Atan2)) return; auto x=S.top(); S.pop(); auto y=S.top(); S.pop(); S.push(WofValue(std::atan2(need_num(y,"atan2"),need_num(x,"atan2")))); };
+    (*ops)["sinh"] = [](std::stack<WofValue>& S){ if (fuse_unary(S, ElemOp::Sinh)) return; auto a=S.top(); S.pop(); S.push(WofValue(std::sinh(need_num(a,"sinh")))); };
+    (*ops)["cosh"] = [](std::stack<WofValue>& S){ if (fuse_unary(S, ElemOp::Cosh)) return; auto a=S.top(); S.pop(); S.push(WofValue(std::cosh(need_num(a,"cosh")))); };
+    (*ops)["tanh"] = [](std::stack<WofValue>& S){ if (fuse_unary(S, ElemOp::Tanh)) return; auto a=S.top(); S.pop(); S.push(WofValue(std::tanh(need_num(a,"tanh")))); };
+    (*ops)["deg2rad"]= [](std::stack<WofValue>& S){ if (fuse_unary(S, ElemOp::Deg2Rad)) return; auto d=S.top(); S.pop(); S.push(WofValue(deg2rad(need_num(d,"deg2rad")))); };
+    (*ops)["rad2deg"]= [](std::stack<WofValue>& S){ if (fuse_unary(S, ElemOp::Rad2Deg)) return; auto r=S.top(); S.pop(); S.push(WofValue(rad2deg(need_num(r,"rad2deg")))); };
+}
+
+WOFLANG_PLUGIN_EXPORT void declare_stack_effects(woflang::StackEffectSink declare, void* ctx){
+    for (const char* op : {"sin","cos","tan","asin","acos","atan","sinh","cosh","tanh","deg2rad","rad2deg"}) declare(ctx, op, 1, 1);
+    declare(ctx, "atan2", 2, 1);
 }
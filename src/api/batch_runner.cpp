@@ -0,0 +1,213 @@
+#include "batch_runner.hpp"
+#include "../core/async.hpp"
+#include "../core/thread_pool.hpp"
+#include "../core/woflang.hpp"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace woflang {
+
+std::vector<std::filesystem::path> read_manifest(const std::filesystem::path& manifest) {
+    std::ifstream in(manifest);
+    if (!in) throw std::runtime_error("cannot read manifest " + manifest.string());
+    std::vector<std::filesystem::path> scripts;
+    auto base = manifest.parent_path();
+    for (std::string line; std::getline(in, line);) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos || line[start] == '#') continue;
+        std::filesystem::path path = line.substr(start, line.find_last_not_of(" \t") + 1 - start);
+        scripts.push_back(path.is_relative() ? base / path : path);
+    }
+    return scripts;
+}
+
+#ifdef _WIN32
+
+size_t run_batch(WoflangInterpreter&, const std::vector<std::filesystem::path>&, unsigned,
+                 const std::function<void(const BatchResult&)>&) {
+    throw std::runtime_error("--batch needs fork(), which this platform does not have");
+}
+
+#else
+
+namespace {
+
+constexpr size_t kMaxResultText = 4096 - 32;
+
+struct ResultSlot {
+    std::atomic<uint32_t> ready;  // set once the rest has been written
+    uint32_t status;
+    uint32_t micros;
+    uint32_t size;
+    char text[kMaxResultText];
+};
+
+// One result slot per running child, in an anonymous shared mapping so
+// children can write them. The parent gives each child a free slot before
+// forking and reads it only after reaping that child, then reuses it; a
+// child that dies before or while writing loses only its own result and
+// never blocks the others.
+class ResultSlots {
+public:
+    explicit ResultSlots(size_t slots) {
+        bytes_ = slots * sizeof(ResultSlot);
+        void* p = ::mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) throw std::runtime_error("batch: cannot map the result slots");
+        slot_ = static_cast<ResultSlot*>(p);
+        for (size_t k = 0; k < slots; ++k) new (&slot_[k].ready) std::atomic<uint32_t>(0);
+    }
+    ~ResultSlots() { ::munmap(slot_, bytes_); }
+
+    ResultSlots(const ResultSlots&) = delete;
+    ResultSlots& operator=(const ResultSlots&) = delete;
+
+    // Called in the parent before handing `slot` to a child.
+    void reset(size_t slot) { slot_[slot].ready.store(0, std::memory_order_relaxed); }
+
+    // Called in a child.
+    void publish(size_t slot, const BatchResult& r) {
+        ResultSlot& s = slot_[slot];
+        s.status = static_cast<uint32_t>(r.status);
+        s.micros = r.micros;
+        s.size = static_cast<uint32_t>(std::min(r.output.size(), kMaxResultText));
+        std::memcpy(s.text, r.output.data(), s.size);
+        s.ready.store(1, std::memory_order_release);
+    }
+
+    // Called in the parent once the child has been reaped; false if it
+    // published nothing.
+    bool take(size_t slot, BatchResult& r) const {
+        const ResultSlot& s = slot_[slot];
+        if (s.ready.load(std::memory_order_acquire) == 0) return false;
+        r.status = static_cast<BatchResult::Status>(s.status);
+        r.micros = s.micros;
+        r.output.assign(s.text, s.size);
+        return true;
+    }
+
+private:
+    size_t bytes_ = 0;
+    ResultSlot* slot_ = nullptr;
+};
+
+[[noreturn]] void run_child(WoflangInterpreter& interp, const std::filesystem::path& script, size_t index,
+                            ResultSlots& results, size_t slot) {
+    BatchResult r;
+    r.index = index;
+    std::ostringstream out;
+    auto* saved = std::cout.rdbuf(out.rdbuf());
+    auto start = std::chrono::steady_clock::now();
+    try {
+        if (!interp.execute_file(script)) r.status = BatchResult::Status::Error;
+    } catch (const std::exception& e) {
+        out << "Error: " << e.what() << "\n";
+        r.status = BatchResult::Status::Error;
+    }
+    r.micros = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                         std::chrono::steady_clock::now() - start).count());
+    std::cout.rdbuf(saved);
+    r.output = out.str();
+    if (r.output.size() > kMaxResultText) {
+        std::string note = "\n... (" + std::to_string(r.output.size()) + " bytes of output)\n";
+        r.output.resize(kMaxResultText - note.size());
+        r.output += note;
+    }
+    results.publish(slot, r);
+    std::_Exit(0);  // skip the parent's atexit handlers and stdio buffers
+}
+
+} // namespace
+
+size_t run_batch(WoflangInterpreter& interp, const std::vector<std::filesystem::path>& scripts, unsigned jobs,
+                 const std::function<void(const BatchResult&)>& report) {
+    // A child gets only the forking thread: the pool's or a Scheduler's
+    // threads would be gone, with their locks possibly held.
+    if (ThreadPool::shared_started() || Scheduler::live() > 0) {
+        throw std::runtime_error("batch: worker threads are already running (e.g. pmap or an async op in the "
+                                 "setup script); scripts cannot be forked from this process");
+    }
+    if (jobs == 0) jobs = std::max(1u, std::thread::hardware_concurrency());
+    jobs = static_cast<unsigned>(std::min<size_t>(jobs, std::max<size_t>(1, scripts.size())));
+    ResultSlots results(jobs);
+    std::vector<size_t> free_slots;
+    for (size_t k = jobs; k-- > 0;) free_slots.push_back(k);
+    struct Child {
+        size_t index;
+        size_t slot;
+    };
+    std::unordered_map<pid_t, Child> running;
+    size_t failures = 0;
+    size_t next = 0;
+
+    auto crashed = [&](size_t index, std::string why) {
+        BatchResult r;
+        r.index = index;
+        r.status = BatchResult::Status::Crashed;
+        r.output = std::move(why);
+        ++failures;
+        report(r);
+    };
+
+    while (next < scripts.size() || !running.empty()) {
+        while (!free_slots.empty() && next < scripts.size()) {
+            size_t slot = free_slots.back();
+            results.reset(slot);
+            std::cout.flush();
+            pid_t pid = ::fork();
+            if (pid == 0) run_child(interp, scripts[next], next, results, slot);
+            if (pid < 0) {
+                if (running.empty()) throw std::runtime_error("batch: fork failed");
+                break;  // try again when a child exits
+            }
+            free_slots.pop_back();
+            running.emplace(pid, Child{next++, slot});
+        }
+        int status = 0;
+        pid_t pid = ::waitpid(-1, &status, 0);
+        if (pid < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        auto it = running.find(pid);
+        if (it == running.end()) continue;
+        Child child = it->second;
+        running.erase(it);
+        free_slots.push_back(child.slot);
+
+        BatchResult r;
+        r.index = child.index;
+        bool published = results.take(child.slot, r);
+        if (published && WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+            if (r.status != BatchResult::Status::Ok) ++failures;
+            report(r);
+        } else if (WIFSIGNALED(status)) {
+            crashed(child.index, std::string("killed by signal ") + std::to_string(WTERMSIG(status)) + " (" +
+                                     strsignal(WTERMSIG(status)) + ")\n");
+        } else if (WIFEXITED(status) && WEXITSTATUS(status) != 0) {
+            crashed(child.index, "exited with status " + std::to_string(WEXITSTATUS(status)) + "\n");
+        } else {
+            crashed(child.index, "no result received\n");
+        }
+    }
+    // Only if waitpid failed outright: the children left were never reaped.
+    for (const auto& [pid, child] : running) crashed(child.index, "no result received\n");
+    return failures;
+}
+
+#endif
+
+} // namespace woflang
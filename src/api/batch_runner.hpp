@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace woflang {
+
+class WoflangInterpreter;
+
+struct BatchResult {
+    enum class Status { Ok, Error, Crashed };
+
+    size_t index = 0;  // position in the script list
+    Status status = Status::Ok;
+    uint32_t micros = 0;
+    std::string output;  // what the script printed, or why it failed
+};
+
+// Runs independent scripts in parallel from one warmed-up interpreter (its
+// plugins loaded and words defined once). Each script runs in a child
+// forked from the calling process, so it starts from that state
+// copy-on-write and cannot disturb the parent or other scripts; a script
+// that crashes (e.g. in a plugin) is reported and the run goes on. Up to
+// `jobs` children run at once (0: one per core).
+//
+// Children send their results back through a slot of shared memory each:
+// the first 4 KB of output, the status and the run time. `report` is
+// called in the parent as results arrive, in completion order. Returns the
+// number of scripts that did not finish with Status::Ok.
+//
+// Throws if the parent has started ThreadPool::shared() or a Scheduler,
+// since forked children do not inherit their threads. Needs fork();
+// elsewhere it throws.
+size_t run_batch(WoflangInterpreter& interp, const std::vector<std::filesystem::path>& scripts, unsigned jobs,
+                 const std::function<void(const BatchResult&)>& report);
+
+// Script paths from a manifest: one per line, blank lines and lines
+// starting with '#' skipped, relative paths taken from the manifest's
+// directory. Throws if the manifest cannot be read.
+std::vector<std::filesystem::path> read_manifest(const std::filesystem::path& manifest);
+
+} // namespace woflang
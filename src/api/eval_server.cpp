@@ -0,0 +1,292 @@
+#include "eval_server.hpp"
+#include "woflang_c.h"
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace woflang {
+
+uint64_t ServerStats::quantile_micros(double q) const {
+    uint64_t need = static_cast<uint64_t>(q * static_cast<double>(requests) + 0.5);
+    uint64_t seen = 0;
+    for (size_t b = 0; b < std::size(buckets); ++b) {
+        seen += buckets[b];
+        if (seen >= need && seen > 0) return uint64_t(1) << b;
+    }
+    return max_micros;
+}
+
+#ifdef _WIN32
+
+EvalServer::EvalServer(std::filesystem::path socket_path, size_t workers, const std::filesystem::path& plugin_dir)
+    : socket_path_(std::move(socket_path)), pool_(workers, plugin_dir) {}
+EvalServer::~EvalServer() = default;
+void EvalServer::run() { throw std::runtime_error("--serve: UNIX domain sockets are not supported on this platform"); }
+void EvalServer::stop() {}
+EvalClient::EvalClient(const std::filesystem::path&) {
+    throw std::runtime_error("--client: UNIX domain sockets are not supported on this platform");
+}
+EvalClient::~EvalClient() = default;
+void EvalClient::send(uint32_t, std::string_view) {}
+bool EvalClient::receive(ResponseHeader&, std::string&) { return false; }
+
+#else
+
+namespace {
+
+bool read_all(int fd, void* buf, size_t size) {
+    auto* p = static_cast<char*>(buf);
+    while (size > 0) {
+        ssize_t n = ::read(fd, p, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool write_all(int fd, const void* buf, size_t size) {
+#ifdef MSG_NOSIGNAL
+    constexpr int kFlags = MSG_NOSIGNAL;  // a vanished client is not fatal
+#else
+    constexpr int kFlags = 0;
+#endif
+    auto* p = static_cast<const char*>(buf);
+    while (size > 0) {
+        ssize_t n = ::send(fd, p, size, kFlags);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+sockaddr_un socket_address(const std::filesystem::path& path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::string s = path.string();
+    if (s.size() >= sizeof(addr.sun_path)) throw std::runtime_error("socket path too long: " + s);
+    std::memcpy(addr.sun_path, s.c_str(), s.size() + 1);
+    return addr;
+}
+
+// Removes a socket left behind by a server that was killed. Anything that
+// is not a socket, or a socket a server still answers on, is left alone and
+// the bind fails.
+void remove_stale_socket(const sockaddr_un& addr, const std::filesystem::path& path) {
+    struct stat st;
+    if (::lstat(addr.sun_path, &st) != 0) return;
+    if (!S_ISSOCK(st.st_mode)) {
+        throw std::runtime_error("serve: " + path.string() + " exists and is not a socket");
+    }
+    int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    bool live = probe >= 0 && ::connect(probe, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0;
+    if (probe >= 0) ::close(probe);
+    if (live) throw std::runtime_error("serve: a server is already listening on " + path.string());
+    ::unlink(addr.sun_path);
+}
+
+} // namespace
+
+struct EvalServer::Connection {
+    explicit Connection(int fd) : fd(fd) {}
+    ~Connection() { ::close(fd); }
+
+    int fd;
+    std::mutex write_mutex;  // workers finishing at once interleave whole responses
+};
+
+EvalServer::EvalServer(std::filesystem::path socket_path, size_t workers, const std::filesystem::path& plugin_dir)
+    : socket_path_(std::move(socket_path)), pool_(std::max<size_t>(workers, 1), plugin_dir) {
+    if (::pipe(wake_fds_) != 0) throw std::runtime_error("serve: cannot create wake-up pipe");
+}
+
+EvalServer::~EvalServer() {
+    if (listen_fd_ >= 0) ::close(listen_fd_);
+    ::close(wake_fds_[0]);
+    ::close(wake_fds_[1]);
+}
+
+void EvalServer::stop() {
+    char c = 0;
+    [[maybe_unused]] ssize_t n = ::write(wake_fds_[1], &c, 1);
+}
+
+void EvalServer::run() {
+    sockaddr_un addr = socket_address(socket_path_);
+    remove_stale_socket(addr, socket_path_);
+    listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd_ < 0 || ::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listen_fd_, 64) != 0) {
+        throw std::runtime_error("serve: cannot listen on " + socket_path_.string() + ": " + std::strerror(errno));
+    }
+    for (size_t k = 0; k < pool_.size(); ++k) workers_.emplace_back([this] { work(); });
+
+    size_t readers = 0;
+    std::condition_variable readers_done;
+    for (;;) {
+        pollfd fds[2] = {{listen_fd_, POLLIN, 0}, {wake_fds_[0], POLLIN, 0}};
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents) break;
+        int fd = ::accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) continue;
+        auto conn = std::make_shared<Connection>(fd);
+        std::lock_guard<std::mutex> lock(conns_mutex_);
+        std::erase_if(conns_, [](const auto& c) { return c.expired(); });
+        conns_.push_back(conn);
+        ++readers;
+        std::thread([this, conn, &readers, &readers_done] {
+            serve_connection(conn);
+            std::lock_guard<std::mutex> lock(conns_mutex_);
+            --readers;
+            readers_done.notify_all();
+        }).detach();
+    }
+
+    // Unblock the readers, let the workers drain what was already queued.
+    {
+        std::unique_lock<std::mutex> lock(conns_mutex_);
+        for (const auto& c : conns_) {
+            if (auto conn = c.lock()) ::shutdown(conn->fd, SHUT_RD);
+        }
+        readers_done.wait(lock, [&] { return readers == 0; });
+    }
+    {
+        std::lock_guard<std::mutex> lock(jobs_mutex_);
+        stopping_ = true;
+    }
+    jobs_cv_.notify_all();
+    for (auto& t : workers_) t.join();
+    workers_.clear();
+    ::close(listen_fd_);
+    listen_fd_ = -1;
+    ::unlink(addr.sun_path);
+}
+
+void EvalServer::serve_connection(std::shared_ptr<Connection> conn) {
+    RequestHeader h;
+    while (read_all(conn->fd, &h, sizeof(h)) && h.size <= kMaxRequestSize) {
+        Job job{conn, h.id, std::string(h.size, '\0'), {}};
+        if (!read_all(conn->fd, job.source.data(), h.size)) break;
+        job.received = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> lock(jobs_mutex_);
+            jobs_.push_back(std::move(job));
+        }
+        jobs_cv_.notify_one();
+    }
+}
+
+void EvalServer::work() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(jobs_mutex_);
+            jobs_cv_.wait(lock, [&] { return stopping_ || !jobs_.empty(); });
+            if (jobs_.empty()) return;
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+        WoflangInterpreter& interp = pool_.acquire();
+        // Op errors are reported to the request that caused them, not
+        // printed by the server.
+        interp.capture_errors(true);
+        interp.take_errors();
+        uint64_t errors = interp.op_errors();
+        uint64_t words = interp.words_defined();
+        uint32_t status = WOF_OK;
+        std::string text;
+        try {
+            interp.execute(pool_.compile_shared(job.source));
+            if (interp.op_errors() != errors) {
+                status = WOF_ERROR;
+                text = interp.take_errors();
+            } else {
+                for (auto& st = interp.stack; !st.empty(); st.pop()) {
+                    text += st.top().to_string();
+                    text += '\n';
+                }
+            }
+        } catch (const BudgetExceeded& e) {
+            status = WOF_BUDGET_EXCEEDED;
+            text = e.what();
+        } catch (const std::exception& e) {
+            status = WOF_ERROR;
+            text = e.what();
+        }
+        // Requests are independent: one that defined words hands back a
+        // fresh interpreter so they do not leak into the next client's.
+        if (interp.words_defined() != words) {
+            pool_.renew(interp);
+        } else {
+            pool_.release(interp);
+        }
+
+        auto micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                          std::chrono::steady_clock::now() - job.received).count();
+        ResponseHeader r{static_cast<uint32_t>(text.size()), job.id, status, static_cast<uint32_t>(micros)};
+        {
+            std::lock_guard<std::mutex> lock(job.conn->write_mutex);
+            if (write_all(job.conn->fd, &r, sizeof(r))) write_all(job.conn->fd, text.data(), text.size());
+        }
+        record(static_cast<uint64_t>(micros), status != WOF_OK);
+    }
+}
+
+EvalClient::EvalClient(const std::filesystem::path& socket_path) {
+    sockaddr_un addr = socket_address(socket_path);
+    fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd_ < 0 || ::connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        if (fd_ >= 0) ::close(fd_);
+        throw std::runtime_error("cannot connect to " + socket_path.string() + ": " + std::strerror(errno));
+    }
+}
+
+EvalClient::~EvalClient() {
+    ::close(fd_);
+}
+
+void EvalClient::send(uint32_t id, std::string_view source) {
+    RequestHeader h{static_cast<uint32_t>(source.size()), id};
+    if (source.size() > kMaxRequestSize || !write_all(fd_, &h, sizeof(h)) ||
+        !write_all(fd_, source.data(), source.size())) {
+        throw std::runtime_error("client: cannot send request " + std::to_string(id));
+    }
+}
+
+bool EvalClient::receive(ResponseHeader& header, std::string& text) {
+    if (!read_all(fd_, &header, sizeof(header))) return false;
+    text.resize(header.size);
+    return read_all(fd_, text.data(), text.size());
+}
+
+#endif
+
+void EvalServer::record(uint64_t micros, bool error) {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    ++stats_.requests;
+    stats_.errors += error;
+    stats_.total_micros += micros;
+    stats_.max_micros = std::max(stats_.max_micros, micros);
+    ++stats_.buckets[std::min<size_t>(std::bit_width(micros), std::size(stats_.buckets) - 1)];
+}
+
+ServerStats EvalServer::stats() const {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    return stats_;
+}
+
+} // namespace woflang
@@ -0,0 +1,126 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../core/interp_pool.hpp"
+
+namespace woflang {
+
+// Wire format of `woflang --serve`, in host byte order (the socket is local).
+// A request is a RequestHeader followed by `size` bytes of source; the
+// response is a ResponseHeader followed by `size` bytes of text: the stack
+// after the run, top first, one value per line, or the error message. A run
+// in which any op failed is WOF_ERROR, with that request's op error
+// messages, one per line.
+// Clients may send any number of requests before reading; responses carry
+// the request's id and come back as runs finish, not necessarily in order.
+struct RequestHeader {
+    uint32_t size;
+    uint32_t id;
+};
+
+struct ResponseHeader {
+    uint32_t size;
+    uint32_t id;
+    uint32_t status;  // WOF_OK, WOF_ERROR or WOF_BUDGET_EXCEEDED (woflang_c.h)
+    uint32_t micros;  // from receipt of the request to its response
+};
+
+inline constexpr uint32_t kMaxRequestSize = 16u << 20;
+
+// Latency of served requests, in power-of-two microsecond buckets.
+struct ServerStats {
+    uint64_t requests = 0;
+    uint64_t errors = 0;
+    uint64_t total_micros = 0;
+    uint64_t max_micros = 0;
+    uint64_t buckets[32] = {};  // bucket b counts latencies below 2^b us
+
+    // Upper bound of the bucket holding the q-quantile (0 < q <= 1).
+    uint64_t quantile_micros(double q) const;
+};
+
+// Serves eval requests on a UNIX domain socket from a pool of pre-warmed
+// interpreters. One thread per connection reads requests; `size()` worker
+// threads run them, each on an interpreter of its own, so requests from one
+// connection run in parallel. Each request starts from an empty stack, no
+// variables and only the builtin and plugin ops: words a request defines
+// are not seen by later ones.
+class EvalServer {
+public:
+    EvalServer(std::filesystem::path socket_path, size_t workers, const std::filesystem::path& plugin_dir);
+    ~EvalServer();
+
+    EvalServer(const EvalServer&) = delete;
+    EvalServer& operator=(const EvalServer&) = delete;
+
+    void set_limits(const ExecutionLimits& limits) { pool_.set_limits(limits); }
+
+    // Accepts connections until stop(); throws if the socket cannot be
+    // bound.
+    void run();
+    // Safe to call from a signal handler.
+    void stop();
+
+    ServerStats stats() const;
+
+private:
+    struct Connection;
+    struct Job {
+        std::shared_ptr<Connection> conn;
+        uint32_t id;
+        std::string source;
+        std::chrono::steady_clock::time_point received;
+    };
+
+    void serve_connection(std::shared_ptr<Connection> conn);
+    void work();
+    void record(uint64_t micros, bool error);
+
+    std::filesystem::path socket_path_;
+    InterpreterPool pool_;
+    int listen_fd_ = -1;
+    int wake_fds_[2] = {-1, -1};
+
+    std::mutex jobs_mutex_;
+    std::condition_variable jobs_cv_;
+    std::deque<Job> jobs_;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+
+    std::mutex conns_mutex_;
+    std::vector<std::thread> readers_;
+    std::vector<std::weak_ptr<Connection>> conns_;
+
+    mutable std::mutex stats_mutex_;
+    ServerStats stats_;
+};
+
+// Minimal blocking client for the protocol above, used by `woflang --client`
+// and tests.
+class EvalClient {
+public:
+    // Throws if the server cannot be reached.
+    explicit EvalClient(const std::filesystem::path& socket_path);
+    ~EvalClient();
+
+    EvalClient(const EvalClient&) = delete;
+    EvalClient& operator=(const EvalClient&) = delete;
+
+    void send(uint32_t id, std::string_view source);
+    // False once the server has closed the connection.
+    bool receive(ResponseHeader& header, std::string& text);
+
+private:
+    int fd_ = -1;
+};
+
+} // namespace woflang
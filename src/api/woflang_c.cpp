@@ -0,0 +1,105 @@
+#include "woflang_c.h"
+#include "../core/interp_pool.hpp"
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+struct wof_interp {
+    wof_pool* pool = nullptr;
+    woflang::WoflangInterpreter* interp = nullptr;
+    std::string error;
+    std::string text;
+};
+
+struct wof_pool {
+    wof_pool(unsigned size, const char* plugin_dir)
+        : pool(size, plugin_dir ? std::filesystem::path(plugin_dir) : std::filesystem::path()) {}
+
+    woflang::InterpreterPool pool;
+    // One handle per pooled interpreter, created on its first acquire.
+    std::mutex handles_mutex;
+    std::unordered_map<woflang::WoflangInterpreter*, std::unique_ptr<wof_interp>> handles;
+};
+
+extern "C" {
+
+wof_pool* wof_pool_create(unsigned size, const char* plugin_dir) {
+    try {
+        return new wof_pool(size, plugin_dir);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void wof_pool_destroy(wof_pool* pool) {
+    delete pool;
+}
+
+void wof_pool_set_limits(wof_pool* pool, uint64_t max_instructions, uint32_t timeout_ms) {
+    woflang::ExecutionLimits limits;
+    limits.max_instructions = max_instructions;
+    limits.timeout = std::chrono::milliseconds(timeout_ms);
+    pool->pool.set_limits(limits);
+}
+
+wof_interp* wof_acquire(wof_pool* pool) {
+    woflang::WoflangInterpreter& interp = pool->pool.acquire();
+    std::lock_guard<std::mutex> lock(pool->handles_mutex);
+    auto& handle = pool->handles[&interp];
+    if (!handle) {
+        handle = std::make_unique<wof_interp>();
+        handle->pool = pool;
+        handle->interp = &interp;
+    }
+    handle->error.clear();
+    return handle.get();
+}
+
+void wof_release(wof_interp* interp) {
+    interp->pool->pool.release(*interp->interp);
+}
+
+int wof_eval(wof_interp* interp, const char* source) {
+    try {
+        interp->interp->execute(interp->pool->pool.compile_shared(source));
+        return WOF_OK;
+    } catch (const woflang::BudgetExceeded& e) {
+        interp->error = e.what();
+        return WOF_BUDGET_EXCEEDED;
+    } catch (const std::exception& e) {
+        interp->error = e.what();
+        return WOF_ERROR;
+    }
+}
+
+const char* wof_last_error(const wof_interp* interp) {
+    return interp->error.c_str();
+}
+
+size_t wof_stack_depth(const wof_interp* interp) {
+    return interp->interp->stack.size();
+}
+
+void wof_push_number(wof_interp* interp, double value) {
+    interp->interp->stack.push(woflang::WofValue(value));
+}
+
+int wof_pop_number(wof_interp* interp, double* value) {
+    auto& st = interp->interp->stack;
+    if (st.empty() || st.top().is_array() || st.top().is_quotation() || st.top().is_string()) {
+        return WOF_EMPTY;
+    }
+    *value = st.top().as_numeric();
+    st.pop();
+    return WOF_OK;
+}
+
+const char* wof_pop_string(wof_interp* interp) {
+    auto& st = interp->interp->stack;
+    if (st.empty()) return nullptr;
+    interp->text = st.top().to_string();
+    st.pop();
+    return interp->text.c_str();
+}
+
+} // extern "C"
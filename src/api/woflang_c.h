@@ -0,0 +1,57 @@
+/* woflang_c.h - C API for embedding woflang.
+ *
+ * Interpreters come from a pool built once (builtins registered, plugins
+ * loaded), so a request only acquires an instance, evaluates and releases
+ * it. Release clears the stack and variables; words and plugins persist.
+ * An acquired interpreter must be used by one thread at a time.
+ */
+#ifndef WOFLANG_C_H
+#define WOFLANG_C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct wof_pool wof_pool;
+typedef struct wof_interp wof_interp;
+
+enum {
+    WOF_OK = 0,
+    WOF_ERROR = 1,            /* exception outside an op; see wof_last_error */
+    WOF_BUDGET_EXCEEDED = 2,  /* instruction/time/stack limit hit; line aborted */
+    WOF_EMPTY = 3             /* stack empty or top of the wrong type */
+};
+
+/* size interpreters; plugin_dir may be NULL to load no plugins.
+ * Returns NULL on failure. */
+wof_pool* wof_pool_create(unsigned size, const char* plugin_dir);
+void wof_pool_destroy(wof_pool* pool);
+
+/* Limits applied to every request; 0 means unlimited. */
+void wof_pool_set_limits(wof_pool* pool, uint64_t max_instructions, uint32_t timeout_ms);
+
+/* Blocks while all interpreters are in use. */
+wof_interp* wof_acquire(wof_pool* pool);
+void wof_release(wof_interp* interp);
+
+/* Compiles source once per pool (shared by all instances) and runs it.
+ * Errors inside ops are reported on stdout as in the REPL and do not fail
+ * the call. */
+int wof_eval(wof_interp* interp, const char* source);
+const char* wof_last_error(const wof_interp* interp);
+
+size_t wof_stack_depth(const wof_interp* interp);
+void wof_push_number(wof_interp* interp, double value);
+int wof_pop_number(wof_interp* interp, double* value);
+/* Text form of the popped value, valid until the next call on interp;
+ * NULL if the stack is empty. */
+const char* wof_pop_string(wof_interp* interp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WOFLANG_C_H */
@@ -0,0 +1,50 @@
+#include "arena.hpp"
+#include <algorithm>
+#include <cstdint>
+
+namespace woflang {
+
+Arena::Arena(size_t initial_bytes)
+    : primary_(new std::byte[initial_bytes]),
+      primary_size_(initial_bytes),
+      cursor_(primary_.get()),
+      end_(primary_.get() + initial_bytes) {}
+
+void* Arena::do_allocate(size_t bytes, size_t alignment) {
+    auto addr = reinterpret_cast<std::uintptr_t>(cursor_);
+    auto aligned = (addr + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+    auto* p = reinterpret_cast<std::byte*>(aligned);
+    if (p + bytes > end_ || p < cursor_) {
+        // Spill: a fresh block, at least double the last one, big enough for
+        // this request at any alignment.
+        size_t last = spill_.empty() ? primary_size_ : spill_.back().size;
+        size_t size = std::max(last * 2, bytes + alignment);
+        spill_.push_back({std::unique_ptr<std::byte[]>(new std::byte[size]), size});
+        cursor_ = spill_.back().data.get();
+        end_ = cursor_ + size;
+        addr = reinterpret_cast<std::uintptr_t>(cursor_);
+        aligned = (addr + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+        p = reinterpret_cast<std::byte*>(aligned);
+    }
+    cursor_ = p + bytes;
+    used_ += bytes;
+    return p;
+}
+
+void Arena::reset() {
+    if (!spill_.empty()) {
+        size_t total = primary_size_;
+        for (const auto& b : spill_) total += b.size;
+        spill_.clear();
+        total = std::min(total, kMaxPrimary);
+        if (total > primary_size_) {
+            primary_.reset(new std::byte[total]);
+            primary_size_ = total;
+        }
+    }
+    cursor_ = primary_.get();
+    end_ = cursor_ + primary_size_;
+    used_ = 0;
+}
+
+} // namespace woflang
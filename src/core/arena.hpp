@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace woflang {
+
+// Bump allocator for data that lives no longer than one top-level execution:
+// token arrays and op scratch buffers. Deallocation is a no-op; reset()
+// rewinds everything at once. When an execution spills past the primary
+// block, reset() folds the spill into a larger primary block (up to
+// kMaxPrimary), so steady-state executions never reach malloc.
+class Arena : public std::pmr::memory_resource {
+public:
+    explicit Arena(size_t initial_bytes = 64 * 1024);
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void reset();
+
+    size_t capacity() const { return primary_size_; }
+    size_t bytes_used() const { return used_; }
+
+private:
+    static constexpr size_t kMaxPrimary = 16 * 1024 * 1024;
+
+    struct Block {
+        std::unique_ptr<std::byte[]> data;
+        size_t size;
+    };
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    std::unique_ptr<std::byte[]> primary_;
+    size_t primary_size_;
+    std::vector<Block> spill_;
+    std::byte* cursor_;
+    std::byte* end_;
+    size_t used_ = 0;
+};
+
+} // namespace woflang
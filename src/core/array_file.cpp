@@ -0,0 +1,88 @@
+#include "array_file.hpp"
+#include "woflang.hpp"
+#include <cstring>
+#include <functional>
+#include <numeric>
+
+namespace woflang {
+
+namespace {
+
+constexpr char kArrayMagic[4] = {'W', 'O', 'F', 'A'};
+constexpr uint32_t kArrayFormat = 1;
+constexpr uint32_t kByteOrderMark = 0x01020304;
+constexpr uint32_t kFloat64 = 1;
+constexpr uint32_t kDataAlignment = 64;
+
+struct ArrayHeader {
+    char magic[4];
+    uint32_t format;
+    uint32_t byte_order;
+    uint32_t dtype;
+    uint32_t rank;
+    uint32_t alignment;
+    uint64_t data_offset;
+    uint64_t shape[kMaxArrayRank];
+};
+static_assert(sizeof(ArrayHeader) == kDataAlignment);
+
+std::runtime_error bad_file(const std::filesystem::path& path, const char* why) {
+    return std::runtime_error("load_array: " + path.string() + ": " + why);
+}
+
+} // namespace
+
+ArrayFile load_array_file(const std::filesystem::path& path) {
+    ArrayFile f;
+    f.map = MappedFile::open(path);
+    if (!f.map) throw std::runtime_error("load_array: cannot read " + path.string());
+    ArrayHeader h;
+    if (f.map->size() < sizeof(h)) throw bad_file(path, "not an array file");
+    std::memcpy(&h, f.map->data(), sizeof(h));
+    if (std::memcmp(h.magic, kArrayMagic, sizeof(kArrayMagic)) != 0 || h.format != kArrayFormat) {
+        throw bad_file(path, "not an array file");
+    }
+    if (h.byte_order != kByteOrderMark) throw bad_file(path, "written with the other byte order");
+    if (h.dtype != kFloat64) throw bad_file(path, "unsupported element type");
+    if (h.rank == 0 || h.rank > kMaxArrayRank || h.alignment == 0 || h.data_offset % h.alignment != 0 ||
+        h.data_offset % alignof(double) != 0 || h.data_offset < sizeof(h) || h.data_offset > f.map->size()) {
+        throw bad_file(path, "corrupt header");
+    }
+    uint64_t count = 1;
+    for (uint32_t k = 0; k < h.rank; ++k) {
+        if (h.shape[k] != 0 && count > UINT64_MAX / h.shape[k]) throw bad_file(path, "corrupt header");
+        count *= h.shape[k];
+        f.shape.push_back(h.shape[k]);
+    }
+    if (count > (f.map->size() - h.data_offset) / sizeof(double)) throw bad_file(path, "truncated");
+    f.count = static_cast<size_t>(count);
+    f.data = reinterpret_cast<const double*>(f.map->data() + h.data_offset);
+    return f;
+}
+
+void save_array_file(const std::filesystem::path& path, const WofValue& value, std::vector<uint64_t> shape) {
+    size_t n = array_size(value);
+    if (n == kUnbounded) throw std::runtime_error("save_array: cannot save an unbounded sequence");
+    if (shape.empty()) shape.push_back(n);
+    if (shape.size() > kMaxArrayRank ||
+        std::accumulate(shape.begin(), shape.end(), uint64_t(1), std::multiplies<>()) != n) {
+        throw std::runtime_error("save_array: shape does not match " + std::to_string(n) + " elements");
+    }
+
+    ArrayHeader h{};
+    std::memcpy(h.magic, kArrayMagic, sizeof(kArrayMagic));
+    h.format = kArrayFormat;
+    h.byte_order = kByteOrderMark;
+    h.dtype = kFloat64;
+    h.rank = static_cast<uint32_t>(shape.size());
+    h.alignment = kDataAlignment;
+    h.data_offset = sizeof(h);
+    std::copy(shape.begin(), shape.end(), h.shape);
+
+    AtomicFile out(path);
+    out.write(&h, sizeof(h));
+    for_each_chunk(value, [&](std::span<const double> c) { out.write(c.data(), c.size_bytes()); });
+    if (!out.commit()) throw std::runtime_error("save_array: cannot write " + path.string());
+}
+
+} // namespace woflang
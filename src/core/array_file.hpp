@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <vector>
+#include "../io/mapped_file.hpp"
+
+namespace woflang {
+
+struct WofValue;
+
+// Binary array files: a 64-byte header (magic, format, byte order mark,
+// dtype, rank, data alignment, data offset, up to four dimensions), then the
+// elements as raw float64 in row-major order, starting at an offset aligned
+// to 64 bytes. The data is the host's layout; files from a host of the other
+// byte order are rejected rather than swapped.
+//
+// Loading maps the file and hands out a view of the elements (see
+// make_view), so it costs the same for any size and pages are read only when
+// touched.
+
+inline constexpr size_t kMaxArrayRank = 4;
+
+struct ArrayFile {
+    std::shared_ptr<const MappedFile> map;  // owns the elements
+    const double* data = nullptr;
+    std::vector<uint64_t> shape;            // row-major; its product is the count
+    size_t count = 0;
+};
+
+// Throws std::runtime_error if the file cannot be read or is not an array
+// file.
+ArrayFile load_array_file(const std::filesystem::path& path);
+
+// Streams the elements of `value` (stored or deferred) to `path` through an
+// AtomicFile. An empty `shape` means one dimension. Throws
+// for unbounded sequences, a shape that does not match the element count, or
+// a failed write.
+void save_array_file(const std::filesystem::path& path, const WofValue& value,
+                     std::vector<uint64_t> shape = {});
+
+} // namespace woflang
@@ -0,0 +1,198 @@
+#include "async.hpp"
+#include <iostream>
+#include <stdexcept>
+
+namespace woflang {
+
+namespace {
+thread_local Scheduler* tls_scheduler = nullptr;
+std::atomic<size_t> g_live_schedulers{0};
+
+// Fire-and-forget coroutine frame: starts immediately and frees itself.
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+Detached run_detached(Task task, std::function<void()> on_done) {
+    try {
+        co_await task;
+    } catch (const std::exception& e) {
+        std::cerr << "Async task failed: " << e.what() << "\n";
+    } catch (...) {
+        std::cerr << "Async task failed with unknown error\n";
+    }
+    on_done();
+}
+}
+
+Scheduler* Scheduler::current() {
+    return tls_scheduler;
+}
+
+size_t Scheduler::live() {
+    return g_live_schedulers.load(std::memory_order_relaxed);
+}
+
+Scheduler::Scheduler(unsigned event_threads, unsigned blocking_threads) {
+    if (event_threads == 0) event_threads = 1;
+    if (blocking_threads == 0) blocking_threads = 1;
+    for (unsigned i = 0; i < event_threads; ++i) threads_.emplace_back([this] { event_loop(); });
+    for (unsigned i = 0; i < blocking_threads; ++i) threads_.emplace_back([this] { blocking_loop(); });
+    threads_.emplace_back([this] { timer_loop(); });
+    g_live_schedulers.fetch_add(1, std::memory_order_relaxed);
+}
+
+Scheduler::~Scheduler() {
+    wait_idle();
+    {
+        std::scoped_lock lock(ready_mutex_, timer_mutex_, blocking_mutex_);
+        stopping_ = true;
+    }
+    ready_cv_.notify_all();
+    timer_cv_.notify_all();
+    blocking_cv_.notify_all();
+    for (auto& t : threads_) t.join();
+    g_live_schedulers.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void Scheduler::spawn(Task task) {
+    active_.fetch_add(1, std::memory_order_acq_rel);
+    // Hop onto an event thread before starting, so the caller never runs
+    // interpreter code and tasks start in spawn order.
+    struct Start {
+        Scheduler* self;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) const { self->schedule(h); }
+        void await_resume() const noexcept {}
+    };
+    auto hop = [](Scheduler* self, Task inner) -> Task {
+        co_await Start{self};
+        co_await inner;
+    };
+    run_detached(hop(this, std::move(task)), [this] { task_finished(); });
+}
+
+void Scheduler::task_finished() {
+    if (active_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+        idle_cv_.notify_all();
+    }
+}
+
+void Scheduler::wait_idle() {
+    std::unique_lock<std::mutex> lock(idle_mutex_);
+    idle_cv_.wait(lock, [this] { return active_.load(std::memory_order_acquire) == 0; });
+}
+
+void Scheduler::schedule(std::coroutine_handle<> h) {
+    {
+        std::lock_guard<std::mutex> lock(ready_mutex_);
+        ready_.push_back(h);
+    }
+    ready_cv_.notify_one();
+}
+
+void Scheduler::schedule_at(Clock::time_point when, std::coroutine_handle<> h) {
+    bool earliest;
+    {
+        std::lock_guard<std::mutex> lock(timer_mutex_);
+        earliest = timers_.empty() || when < timers_.top().when;
+        timers_.push({when, h});
+    }
+    if (earliest) timer_cv_.notify_one();
+}
+
+void Scheduler::run_blocking(std::function<void()> job, std::coroutine_handle<> resume) {
+    {
+        std::lock_guard<std::mutex> lock(blocking_mutex_);
+        blocking_jobs_.push_back([this, job = std::move(job), resume] {
+            job();
+            schedule(resume);
+        });
+    }
+    blocking_cv_.notify_one();
+}
+
+void Scheduler::event_loop() {
+    tls_scheduler = this;
+    for (;;) {
+        std::coroutine_handle<> h;
+        {
+            std::unique_lock<std::mutex> lock(ready_mutex_);
+            ready_cv_.wait(lock, [this] { return stopping_ || !ready_.empty(); });
+            if (ready_.empty()) return;
+            h = ready_.front();
+            ready_.pop_front();
+        }
+        h.resume();
+    }
+}
+
+void Scheduler::timer_loop() {
+    std::unique_lock<std::mutex> lock(timer_mutex_);
+    for (;;) {
+        if (stopping_) return;
+        if (timers_.empty()) {
+            timer_cv_.wait(lock);
+            continue;
+        }
+        auto when = timers_.top().when;
+        if (Clock::now() < when) {
+            timer_cv_.wait_until(lock, when);
+            continue;
+        }
+        auto h = timers_.top().handle;
+        timers_.pop();
+        lock.unlock();
+        schedule(h);
+        lock.lock();
+    }
+}
+
+void Scheduler::blocking_loop() {
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(blocking_mutex_);
+            blocking_cv_.wait(lock, [this] { return stopping_ || !blocking_jobs_.empty(); });
+            if (blocking_jobs_.empty()) return;
+            job = std::move(blocking_jobs_.front());
+            blocking_jobs_.pop_front();
+        }
+        job();
+    }
+}
+
+void sync_wait(Task task) {
+    if (Scheduler::current()) {
+        throw std::logic_error("sync_wait on a Scheduler thread would deadlock; co_await the task");
+    }
+    std::mutex m;
+    std::condition_variable cv;
+    bool done = false;
+    std::exception_ptr error;
+
+    auto wrap = [](Task inner, std::exception_ptr& err) -> Task {
+        try {
+            co_await inner;
+        } catch (...) {
+            err = std::current_exception();
+        }
+    };
+    run_detached(wrap(std::move(task), error), [&] {
+        std::lock_guard<std::mutex> lock(m);
+        done = true;
+        cv.notify_one();
+    });
+    std::unique_lock<std::mutex> lock(m);
+    cv.wait(lock, [&] { return done; });
+    if (error) std::rethrow_exception(error);
+}
+
+} // namespace woflang
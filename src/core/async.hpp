@@ -0,0 +1,185 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace woflang {
+
+// Lazily started coroutine used by async ops and execute_line_async. Awaiting
+// a Task starts it and resumes the awaiter when it finishes; exceptions thrown
+// inside the coroutine are rethrown at the co_await.
+class Task {
+public:
+    struct promise_type {
+        std::coroutine_handle<> continuation = std::noop_coroutine();
+        std::exception_ptr error;
+
+        Task get_return_object() {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                return h.promise().continuation;
+            }
+            void await_resume() noexcept {}
+        };
+        FinalAwaiter final_suspend() noexcept { return {}; }
+
+        void return_void() {}
+        void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    Task() = default;
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() { if (handle_) handle_.destroy(); }
+
+    bool await_ready() const noexcept { return !handle_ || handle_.done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+        handle_.promise().continuation = awaiter;
+        return handle_;
+    }
+    void await_resume() {
+        if (handle_ && handle_.promise().error) std::rethrow_exception(handle_.promise().error);
+    }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> h) : handle_(h) {}
+    std::coroutine_handle<promise_type> handle_;
+};
+
+// Multiplexes suspended coroutines (typically one execute_line_async per
+// interpreter session) onto a few event threads. Timers are kept in a heap on
+// a dedicated thread, and blocking work (file I/O, long plugin computations)
+// runs on a separate pool so it never stalls the event threads.
+class Scheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit Scheduler(unsigned event_threads = 2, unsigned blocking_threads = 4);
+    ~Scheduler();
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    // Run a task to completion in the background. Errors escaping the task
+    // are reported on stderr; use wait_idle() to join.
+    void spawn(Task task);
+    // Block until every spawned task has finished.
+    void wait_idle();
+
+    void schedule(std::coroutine_handle<> h);
+    void schedule_at(Clock::time_point when, std::coroutine_handle<> h);
+    void run_blocking(std::function<void()> job, std::coroutine_handle<> resume);
+
+    size_t active_tasks() const { return active_.load(std::memory_order_acquire); }
+
+    // Scheduler owning the calling thread, or null outside its threads.
+    static Scheduler* current();
+    // Schedulers alive in this process, i.e. whose threads are running.
+    static size_t live();
+
+private:
+    struct Timer {
+        Clock::time_point when;
+        std::coroutine_handle<> handle;
+        bool operator>(const Timer& other) const { return when > other.when; }
+    };
+
+    void event_loop();
+    void timer_loop();
+    void blocking_loop();
+    void task_finished();
+
+    std::mutex ready_mutex_;
+    std::condition_variable ready_cv_;
+    std::deque<std::coroutine_handle<>> ready_;
+
+    std::mutex timer_mutex_;
+    std::condition_variable timer_cv_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+
+    std::mutex blocking_mutex_;
+    std::condition_variable blocking_cv_;
+    std::deque<std::function<void()>> blocking_jobs_;
+
+    std::mutex idle_mutex_;
+    std::condition_variable idle_cv_;
+    std::atomic<size_t> active_{0};
+
+    bool stopping_ = false;
+    std::vector<std::thread> threads_;
+};
+
+// co_await sleep_for(d): suspends on the timer heap when running under a
+// Scheduler, otherwise falls back to a plain blocking sleep.
+struct SleepAwaiter {
+    Scheduler::Clock::duration delay;
+
+    bool await_ready() const {
+        if (delay <= Scheduler::Clock::duration::zero()) return true;
+        if (Scheduler::current()) return false;
+        std::this_thread::sleep_for(delay);
+        return true;
+    }
+    void await_suspend(std::coroutine_handle<> h) const {
+        Scheduler::current()->schedule_at(Scheduler::Clock::now() + delay, h);
+    }
+    void await_resume() const noexcept {}
+};
+
+inline SleepAwaiter sleep_for(Scheduler::Clock::duration delay) { return {delay}; }
+
+// co_await offload(fn): runs fn on the blocking pool and resumes the caller
+// on an event thread. Exceptions from fn are rethrown at the co_await. Without
+// a Scheduler, fn simply runs inline.
+template <typename Fn>
+struct OffloadAwaiter {
+    Fn fn;
+    std::exception_ptr error;
+
+    bool await_ready() {
+        if (Scheduler::current()) return false;
+        fn();
+        return true;
+    }
+    void await_suspend(std::coroutine_handle<> h) {
+        Scheduler::current()->run_blocking([this] {
+            try { fn(); } catch (...) { error = std::current_exception(); }
+        }, h);
+    }
+    void await_resume() {
+        if (error) std::rethrow_exception(error);
+    }
+};
+
+template <typename Fn>
+OffloadAwaiter<Fn> offload(Fn fn) { return {std::move(fn), nullptr}; }
+
+// Drive a task to completion from synchronous code, blocking the caller.
+// Throws std::logic_error on a Scheduler thread: the task would resume on
+// the event threads the caller is blocking, so co_await it instead.
+void sync_wait(Task task);
+
+} // namespace woflang
@@ -0,0 +1,210 @@
+#include "bytecode.hpp"
+#include "woflang.hpp"
+#include "../io/tokenizer.hpp"
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace woflang {
+
+namespace {
+
+constexpr char kCacheMagic[4] = {'W', 'O', 'F', 'C'};
+constexpr uint32_t kCacheFormat = 3;
+constexpr uint32_t kByteOrderMark = 0x01020304;
+
+struct CacheHeader {
+    char magic[4];
+    uint32_t format;
+    uint32_t byte_order;
+    uint32_t instr_size;
+    uint64_t source_hash;
+    uint64_t version_hash;
+    uint64_t op_table_fingerprint;
+    uint32_t code_count;
+    uint32_t symbol_count;
+    uint32_t text_bytes;
+    uint32_t reserved;
+};
+static_assert(sizeof(CacheHeader) % alignof(Instr) == 0);
+
+class Builder {
+public:
+    explicit Builder(Program& prog, std::pmr::memory_resource* mr) : prog_(prog), index_(mr) {}
+
+    uint32_t intern(std::string_view s) {
+        auto it = index_.find(s);
+        if (it != index_.end()) return it->second;
+        auto k = static_cast<uint32_t>(prog_.symbols.size());
+        prog_.symbols.push_back({static_cast<uint32_t>(prog_.text.size()),
+                                 static_cast<uint32_t>(s.size())});
+        prog_.text.append(s);
+        index_.emplace(s, k);  // keys view the source, which outlives compile()
+        return k;
+    }
+
+    void emit(OpCode op, std::string_view sym, uint32_t line) {
+        prog_.code.push_back({op, intern(sym), 0, line, 0, 0.0});
+    }
+
+private:
+    Program& prog_;
+    std::pmr::unordered_map<std::string_view, uint32_t> index_;
+};
+
+} // namespace
+
+Program compile(std::string_view source, std::pmr::memory_resource* mr) {
+    Program prog(mr);
+    Builder b(prog, mr);
+    auto tokens = tokenize_views(source, mr);
+    prog.code.reserve(tokens.size());
+
+    std::pmr::vector<uint32_t> open_quotes(mr);
+    uint32_t line = 1;
+    const char* scanned = source.data();
+    for (auto tok : tokens) {
+        for (const char* p = scanned; p < tok.data(); ++p) line += (*p == '\n');
+        scanned = tok.data();
+
+        if (tok == "{") {
+            open_quotes.push_back(static_cast<uint32_t>(prog.code.size()));
+            b.emit(OpCode::Quote, tok, line);
+        } else if (tok == "}") {
+            if (open_quotes.empty()) {
+                b.emit(OpCode::Fail, "unmatched }", line);
+                continue;
+            }
+            uint32_t at = open_quotes.back();
+            open_quotes.pop_back();
+            prog.code[at].arg = static_cast<uint32_t>(prog.code.size()) - at - 1;
+        } else if (tok == "[") {
+            b.emit(OpCode::Mark, tok, line);
+        } else if (tok == "]") {
+            b.emit(OpCode::Collect, tok, line);
+        } else if (tok.size() > 1 && tok[0] == '\'') {
+            b.emit(OpCode::Name, tok.substr(1), line);
+        } else if (is_number(tok)) {
+            WofValue v = parse_number(tok);
+            b.emit(OpCode::Push, tok, line);
+            prog.code.back().arg = v.exact ? 1 : 0;
+            prog.code.back().i = v.i;
+            prog.code.back().d = v.d;
+        } else {
+            b.emit(OpCode::Call, tok, line);
+        }
+    }
+    if (!open_quotes.empty()) {
+        // Everything from the outermost unclosed brace on is dropped.
+        uint32_t at = open_quotes.front();
+        uint32_t at_line = prog.code[at].line;
+        prog.code.resize(at);
+        b.emit(OpCode::Fail, "unterminated {", at_line);
+    }
+    return prog;
+}
+
+std::shared_ptr<const Program> extract(const ProgramView& prog, uint32_t begin, uint32_t end) {
+    auto out = std::make_shared<Program>();
+    out->code.assign(prog.code.begin() + begin, prog.code.begin() + end);
+    // Keep only the symbols the range uses, renumbered densely.
+    std::unordered_map<uint32_t, uint32_t> remap;
+    for (Instr& in : out->code) {
+        auto [it, fresh] = remap.try_emplace(in.sym, static_cast<uint32_t>(out->symbols.size()));
+        if (fresh) {
+            std::string_view s = prog.symbol(in.sym);
+            out->symbols.push_back({static_cast<uint32_t>(out->text.size()),
+                                    static_cast<uint32_t>(s.size())});
+            out->text.append(s);
+        }
+        in.sym = it->second;
+    }
+    return out;
+}
+
+std::string decompile(const ProgramView& prog, uint32_t begin, uint32_t end) {
+    std::string out;
+    std::vector<uint32_t> closes;
+    for (uint32_t pc = begin; pc < end; ++pc) {
+        while (!closes.empty() && closes.back() == pc) {
+            out += "} ";
+            closes.pop_back();
+        }
+        const Instr& in = prog.code[pc];
+        if (in.op == OpCode::Fail) continue;
+        if (in.op == OpCode::Name) out += '\'';
+        out += prog.symbol(in.sym);
+        out += ' ';
+        if (in.op == OpCode::Quote) closes.push_back(pc + 1 + in.arg);
+    }
+    for (; !closes.empty(); closes.pop_back()) out += "} ";
+    return out;
+}
+
+uint64_t fnv1a(std::string_view bytes, uint64_t seed) {
+    uint64_t h = seed;
+    for (unsigned char c : bytes) {
+        h ^= c;
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+std::string serialize(const ProgramView& prog, const CacheKey& key) {
+    CacheHeader h{};
+    std::memcpy(h.magic, kCacheMagic, sizeof(kCacheMagic));
+    h.format = kCacheFormat;
+    h.byte_order = kByteOrderMark;
+    h.instr_size = sizeof(Instr);
+    h.source_hash = key.source_hash;
+    h.version_hash = key.version_hash;
+    h.op_table_fingerprint = key.op_table_fingerprint;
+    h.code_count = static_cast<uint32_t>(prog.code.size());
+    h.symbol_count = static_cast<uint32_t>(prog.symbols.size());
+    h.text_bytes = static_cast<uint32_t>(prog.text.size());
+
+    std::string out;
+    out.reserve(sizeof(h) + prog.code.size_bytes() + prog.symbols.size_bytes() + prog.text.size());
+    out.append(reinterpret_cast<const char*>(&h), sizeof(h));
+    out.append(reinterpret_cast<const char*>(prog.code.data()), prog.code.size_bytes());
+    out.append(reinterpret_cast<const char*>(prog.symbols.data()), prog.symbols.size_bytes());
+    out.append(prog.text);
+    return out;
+}
+
+std::optional<ProgramView> deserialize(std::string_view bytes, const CacheKey& expected) {
+    CacheHeader h;
+    if (bytes.size() < sizeof(h)) return std::nullopt;
+    std::memcpy(&h, bytes.data(), sizeof(h));
+    if (std::memcmp(h.magic, kCacheMagic, sizeof(kCacheMagic)) != 0 || h.format != kCacheFormat ||
+        h.byte_order != kByteOrderMark || h.instr_size != sizeof(Instr)) {
+        return std::nullopt;
+    }
+    if (h.source_hash != expected.source_hash || h.version_hash != expected.version_hash ||
+        h.op_table_fingerprint != expected.op_table_fingerprint) {
+        return std::nullopt;
+    }
+    size_t code_bytes = size_t(h.code_count) * sizeof(Instr);
+    size_t symbol_bytes = size_t(h.symbol_count) * sizeof(Symbol);
+    if (bytes.size() != sizeof(h) + code_bytes + symbol_bytes + h.text_bytes) return std::nullopt;
+    if (reinterpret_cast<std::uintptr_t>(bytes.data()) % alignof(Instr) != 0) return std::nullopt;
+
+    const char* p = bytes.data() + sizeof(h);
+    ProgramView view;
+    view.code = {reinterpret_cast<const Instr*>(p), h.code_count};
+    view.symbols = {reinterpret_cast<const Symbol*>(p + code_bytes), h.symbol_count};
+    view.text = bytes.substr(sizeof(h) + code_bytes + symbol_bytes, h.text_bytes);
+
+    // Reject anything that would index out of bounds at run time.
+    for (const Symbol& s : view.symbols) {
+        if (size_t(s.offset) + s.length > view.text.size()) return std::nullopt;
+    }
+    for (size_t pc = 0; pc < view.code.size(); ++pc) {
+        const Instr& in = view.code[pc];
+        if (in.sym >= view.symbols.size() || in.op > OpCode::Fail) return std::nullopt;
+        if (in.op == OpCode::Quote && pc + 1 + in.arg > view.code.size()) return std::nullopt;
+    }
+    return view;
+}
+
+} // namespace woflang
@@ -0,0 +1,93 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace woflang {
+
+// Compiled form of a line or script. Ops are referenced by name (symbol) and
+// bound to handlers when the code runs, so compiled code stays valid when
+// plugins are loaded later and can be cached on disk.
+enum class OpCode : uint8_t {
+    Push,     // numeric literal; i/d exactly as parse_number produced them
+    Call,     // op named by sym
+    Quote,    // `{`: the next `arg` instructions are the quotation body
+    Mark,     // `[`
+    Collect,  // `]`
+    Name,     // `'name`: pushes sym as a string, e.g. a variable or word name
+    Fail,     // compile error; sym is the message, reported when reached
+};
+
+struct Instr {
+    OpCode op;
+    uint32_t sym;   // op name, literal text or error message
+    uint32_t arg;   // Quote: body length in instructions; Push: 1 for an exact integer
+    uint32_t line;  // 1-based source line
+    int64_t i;
+    double d;
+};
+static_assert(std::is_trivially_copyable_v<Instr> && sizeof(Instr) == 32,
+              "Instr is stored verbatim in .wofc files");
+
+struct Symbol {
+    uint32_t offset;
+    uint32_t length;
+};
+
+// Read-only code; the storage is a Program or a mapped .wofc file.
+struct ProgramView {
+    std::span<const Instr> code;
+    std::span<const Symbol> symbols;
+    std::string_view text;
+
+    std::string_view symbol(uint32_t k) const {
+        return text.substr(symbols[k].offset, symbols[k].length);
+    }
+};
+
+struct Program {
+    explicit Program(std::pmr::memory_resource* mr = std::pmr::get_default_resource())
+        : code(mr), symbols(mr), text(mr) {}
+
+    ProgramView view() const { return {code, symbols, text}; }
+
+    std::pmr::vector<Instr> code;
+    std::pmr::vector<Symbol> symbols;
+    std::pmr::string text;
+};
+
+// Compile source text. Newlines are plain whitespace, so `{ ... }` may span
+// lines; `#` at the start of a token comments out the rest of its line.
+Program compile(std::string_view source, std::pmr::memory_resource* mr);
+
+// Heap copy of code[begin, end) (with its symbols) for quotations that must
+// outlive a line compiled into the scratch arena.
+std::shared_ptr<const Program> extract(const ProgramView& prog, uint32_t begin, uint32_t end);
+
+// Source-like text of code[begin, end), used to print quotations.
+std::string decompile(const ProgramView& prog, uint32_t begin, uint32_t end);
+
+// --- .wofc cache files -------------------------------------------------------
+
+uint64_t fnv1a(std::string_view bytes, uint64_t seed = 0xcbf29ce484222325ull);
+
+// Any component changing invalidates a cached compilation.
+struct CacheKey {
+    uint64_t source_hash = 0;
+    uint64_t version_hash = 0;
+    uint64_t op_table_fingerprint = 0;
+};
+
+std::string serialize(const ProgramView& prog, const CacheKey& key);
+
+// View into `bytes` if it is a well-formed cache for `expected`; the caller
+// keeps `bytes` (normally a MappedFile) alive while the view is used.
+std::optional<ProgramView> deserialize(std::string_view bytes, const CacheKey& expected);
+
+} // namespace woflang
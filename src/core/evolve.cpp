@@ -0,0 +1,325 @@
+#include "woflang.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <utility>
+
+namespace woflang {
+
+namespace {
+
+constexpr size_t kPopulation = 512;
+constexpr uint32_t kMaxGenes = 24;
+constexpr size_t kCandidatesPerChunk = 8;
+constexpr int kTournament = 3;
+constexpr double kMutationRate = 0.3;
+constexpr double kInvalid = std::numeric_limits<double>::infinity();
+
+// A gene is one literal or op call from the primitives quotation.
+struct Gene {
+    Instr instr;
+    StackEffect effect;
+};
+
+// One generation, stored flat: candidate k is code[k * kMaxGenes, + length[k]).
+// Breeding writes the next generation into a second Population and swaps, so
+// the search allocates nothing per candidate.
+struct Population {
+    explicit Population(size_t n) : code(n * kMaxGenes), length(n), effects(n * kMaxGenes), error(n) {}
+
+    std::span<const Instr> genes(size_t k) const { return {code.data() + k * kMaxGenes, length[k]}; }
+
+    std::vector<Instr> code;
+    std::vector<uint32_t> length;
+    std::vector<StackEffect> effects;  // parallel to code
+    std::vector<double> error;
+};
+
+// Candidates start with x on the stack and must leave a result. Only genes
+// with a declared effect are used, so the check is exact and evaluation
+// never underflows.
+bool well_formed(const StackEffect* effects, uint32_t n) {
+    size_t depth = 1;
+    for (uint32_t k = 0; k < n; ++k) {
+        if (depth < effects[k].in) return false;
+        depth = depth - effects[k].in + effects[k].out;
+    }
+    return depth >= 1;
+}
+
+// Straight-line code of Push and Call only; op errors propagate.
+void run_genes(std::span<const Instr> code, const std::pmr::vector<const WoflangInterpreter::OpHandler*>& handlers,
+               std::stack<WofValue>& st) {
+    for (const Instr& in : code) {
+        if (in.op == OpCode::Push) {
+            WofValue v;
+            v.i = in.i;
+            v.d = in.d;
+            v.exact = in.arg != 0;
+            st.push(std::move(v));
+        } else {
+            (*handlers[in.sym])(st);
+        }
+    }
+}
+
+bool numeric_top(const std::stack<WofValue>& st, double& out) {
+    if (st.empty() || st.top().is_array() || st.top().is_quotation() || st.top().is_string()) return false;
+    out = st.top().as_numeric();
+    return true;
+}
+
+// Source text for a candidate; literals print their (possibly mutated) value.
+std::string to_source(std::span<const Instr> code, const ProgramView& symbols) {
+    std::string out;
+    for (const Instr& in : code) {
+        if (in.op == OpCode::Push) {
+            char buf[32];
+            auto r = in.arg ? std::to_chars(buf, buf + sizeof(buf), in.i)
+                            : std::to_chars(buf, buf + sizeof(buf), in.d);
+            out.append(buf, r.ptr);
+        } else {
+            out += symbols.symbol(in.sym);
+        }
+        out += ' ';
+    }
+    return out;
+}
+
+} // namespace
+
+void WoflangInterpreter::register_evolve_ops() {
+    // xs ys { primitives } generations evolve  ->  { best } error
+    //
+    // Genetic programming over op sequences: evolves a program mapping each
+    // x in xs to its y, minimising the mean squared error. In place of ys a
+    // fitness quotation `( x y -- score )` may be given, where y is the
+    // candidate's output; the mean score is minimised. Primitives are
+    // literals and ops with a declared stack effect, e.g.
+    // { + - * dup swap over 1 2 }.
+    //
+    // The op takes the operands off the stack for run(), which returns
+    // { best } and its error, and puts them back if it throws.
+    auto run = [this](const WofValue& xs_value, const WofValue& target, const WofValue& prims_value,
+                      const WofValue& generations_value) -> std::pair<WofValue, double> {
+        auto generations = static_cast<long long>(generations_value.as_numeric());
+        if (!prims_value.is_quotation()) throw std::runtime_error("evolve: expects { primitives } below the generation count");
+        auto prims = prims_value.quote;
+        if (!xs_value.is_array() || !(target.is_array() || target.is_quotation())) {
+            throw std::runtime_error("evolve: expects xs and ys (or a { fitness } quotation)");
+        }
+        auto xs = xs_value.array();
+        std::shared_ptr<const WofArray> ys;
+        if (target.is_array()) {
+            ys = target.array();
+            if (ys->size() != xs->size()) throw std::runtime_error("evolve: xs and ys differ in length");
+        }
+        if (xs->empty()) throw std::runtime_error("evolve: no data points");
+
+        const ProgramView& gp = prims->program;
+        Bindings bound = bind(gp, std::pmr::get_default_resource());
+        std::vector<Gene> genes;
+        for (uint32_t pc = prims->begin; pc < prims->end; ++pc) {
+            const Instr& in = gp.code[pc];
+            if (in.op == OpCode::Push) {
+                genes.push_back({in, {0, 1}});
+            } else if (in.op == OpCode::Call && bound.handlers[in.sym] && bound.effects[in.sym].known()) {
+                genes.push_back({in, bound.effects[in.sym]});
+            } else {
+                throw std::runtime_error("evolve: primitive '" + std::string(gp.symbol(in.sym)) +
+                                         "' is not a literal or an op with a declared stack effect");
+            }
+        }
+        if (genes.empty()) throw std::runtime_error("evolve: no primitives");
+
+        // The fitness body runs the same way, entered with x and y.
+        Bindings fit_bound;
+        std::span<const Instr> fit_code;
+        if (target.is_quotation()) {
+            const Quotation& fq = *target.quote;
+            fit_bound = bind(fq.program, std::pmr::get_default_resource());
+            fit_code = fq.program.code.subspan(fq.begin, fq.end - fq.begin);
+            bool straight = std::all_of(fit_code.begin(), fit_code.end(), [&](const Instr& in) {
+                return in.op == OpCode::Push || (in.op == OpCode::Call && fit_bound.handlers[in.sym]);
+            });
+            if (!straight || !verified_at(fq.program, fq.begin, fq.end, fit_bound, 2)) {
+                throw std::runtime_error("evolve: fitness must be ops with declared stack effects taking x y");
+            }
+        }
+
+        std::mt19937_64 rng(0x5eed);  // fixed: runs are reproducible
+        auto pick = [&](size_t n) { return static_cast<size_t>(rng() % n); };
+        auto chance = [&](double p) { return std::uniform_real_distribution<double>(0, 1)(rng) < p; };
+
+        auto random_candidate = [&](Population& pop, size_t k) {
+            Instr* code = &pop.code[k * kMaxGenes];
+            StackEffect* effects = &pop.effects[k * kMaxGenes];
+            uint32_t want = 1 + static_cast<uint32_t>(pick(kMaxGenes / 2));
+            uint32_t n = 0;
+            size_t depth = 1;
+            for (int attempts = 0; n < want && attempts < 64; ++attempts) {
+                const Gene& g = genes[pick(genes.size())];
+                if (depth < g.effect.in) continue;
+                depth = depth - g.effect.in + g.effect.out;
+                code[n] = g.instr;
+                effects[n++] = g.effect;
+            }
+            pop.length[k] = n;
+            if (!well_formed(effects, n)) pop.length[k] = 0;  // the bare input
+        };
+
+        auto evaluate = [&](Population& pop, size_t k, std::stack<WofValue>& local) -> uint64_t {
+            auto code = pop.genes(k);
+            double total = 0;
+            try {
+                for (size_t p = 0; p < xs->size() && std::isfinite(total); ++p) {
+                    while (!local.empty()) local.pop();
+                    local.push(WofValue((*xs)[p]));
+                    run_genes(code, bound.handlers, local);
+                    double y;
+                    if (!numeric_top(local, y)) {
+                        total = kInvalid;
+                        break;
+                    }
+                    if (ys) {
+                        total += (y - (*ys)[p]) * (y - (*ys)[p]);
+                        continue;
+                    }
+                    while (!local.empty()) local.pop();
+                    local.push(WofValue((*xs)[p]));
+                    local.push(WofValue(y));
+                    run_genes(fit_code, fit_bound.handlers, local);
+                    double score;
+                    total = numeric_top(local, score) ? total + score : kInvalid;
+                }
+            } catch (const std::exception&) {
+                total = kInvalid;
+            }
+            pop.error[k] = std::isfinite(total) ? total / static_cast<double>(xs->size()) : kInvalid;
+            return (code.size() + fit_code.size()) * xs->size();
+        };
+
+        auto evaluate_all = [&](Population& pop) {
+            run_chunks(kPopulation, kCandidatesPerChunk, [&](size_t c) {
+                std::stack<WofValue> local;
+                uint64_t steps = 0;
+                size_t end = std::min(kPopulation, (c + 1) * kCandidatesPerChunk);
+                for (size_t k = c * kCandidatesPerChunk; k < end; ++k) steps += evaluate(pop, k, local);
+                return steps;
+            });
+        };
+
+        // Lower error wins; shorter programs break ties.
+        auto better = [](const Population& pop, size_t a, size_t b) {
+            if (pop.error[a] != pop.error[b]) return pop.error[a] < pop.error[b];
+            return pop.length[a] < pop.length[b];
+        };
+        auto tournament = [&](const Population& pop) {
+            size_t best = pick(kPopulation);
+            for (int t = 1; t < kTournament; ++t) {
+                size_t c = pick(kPopulation);
+                if (better(pop, c, best)) best = c;
+            }
+            return best;
+        };
+        auto copy_candidate = [](const Population& from, size_t a, Population& to, size_t k) {
+            std::copy_n(&from.code[a * kMaxGenes], from.length[a], &to.code[k * kMaxGenes]);
+            std::copy_n(&from.effects[a * kMaxGenes], from.length[a], &to.effects[k * kMaxGenes]);
+            to.length[k] = from.length[a];
+        };
+
+        auto breed = [&](const Population& pop, Population& next, size_t k) {
+            size_t a = tournament(pop), b = tournament(pop);
+            // One-point crossover: a prefix of a and a suffix of b.
+            uint32_t cut_a = static_cast<uint32_t>(pick(pop.length[a] + 1));
+            uint32_t cut_b = static_cast<uint32_t>(pick(pop.length[b] + 1));
+            uint32_t n = std::min(kMaxGenes, cut_a + (pop.length[b] - cut_b));
+            Instr* code = &next.code[k * kMaxGenes];
+            StackEffect* effects = &next.effects[k * kMaxGenes];
+            std::copy_n(&pop.code[a * kMaxGenes], cut_a, code);
+            std::copy_n(&pop.effects[a * kMaxGenes], cut_a, effects);
+            std::copy_n(&pop.code[b * kMaxGenes + cut_b], n - cut_a, code + cut_a);
+            std::copy_n(&pop.effects[b * kMaxGenes + cut_b], n - cut_a, effects + cut_a);
+            next.length[k] = n;
+            if (!well_formed(effects, n)) copy_candidate(pop, a, next, k);
+
+            if (next.length[k] == 0 || !chance(kMutationRate)) return;
+            uint32_t at = static_cast<uint32_t>(pick(next.length[k]));
+            if (code[at].op == OpCode::Push && chance(0.5)) {
+                // Nudge a constant; it becomes inexact.
+                code[at].d += std::normal_distribution<double>(0, 0.1 * std::abs(code[at].d) + 0.1)(rng);
+                code[at].i = 0;
+                code[at].arg = 0;
+                return;
+            }
+            // Swap in another gene with the same effect, which keeps the
+            // candidate well formed.
+            for (int attempts = 0; attempts < 16; ++attempts) {
+                const Gene& g = genes[pick(genes.size())];
+                if (g.effect.in == effects[at].in && g.effect.out == effects[at].out) {
+                    code[at] = g.instr;
+                    return;
+                }
+            }
+        };
+
+        Population pop(kPopulation), next(kPopulation);
+        for (size_t k = 0; k < kPopulation; ++k) random_candidate(pop, k);
+
+        auto start = std::chrono::steady_clock::now();
+        evaluate_all(pop);
+        uint64_t evaluations = kPopulation;
+        for (long long g = 0; g < generations; ++g) {
+            size_t elite = 0;
+            for (size_t k = 1; k < kPopulation; ++k) {
+                if (better(pop, k, elite)) elite = k;
+            }
+            copy_candidate(pop, elite, next, 0);
+            for (size_t k = 1; k < kPopulation; ++k) breed(pop, next, k);
+            std::swap(pop, next);
+            evaluate_all(pop);
+            evaluations += kPopulation;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        size_t best = 0;
+        for (size_t k = 1; k < kPopulation; ++k) {
+            if (better(pop, k, best)) best = k;
+        }
+        std::cout << "evolve: " << generations << " generations, " << evaluations << " evaluations in "
+                  << seconds << " s (" << static_cast<uint64_t>(evaluations / std::max(seconds, 1e-9))
+                  << " evals/s)\n";
+
+        auto program = std::make_shared<Program>();
+        *program = compile(to_source(pop.genes(best), gp), std::pmr::get_default_resource());
+        auto q = std::make_shared<Quotation>();
+        q->program = program->view();
+        q->end = static_cast<uint32_t>(program->code.size());
+        q->owner = std::move(program);
+        WofValue result;
+        result.quote = std::move(q);
+        return {std::move(result), pop.error[best]};
+    };
+
+    register_op("evolve", [run](std::stack<WofValue>& st) {
+        WofValue operands[4];  // xs ys-or-fitness primitives generations
+        for (size_t k = 4; k-- > 0;) {
+            operands[k] = std::move(st.top());
+            st.pop();
+        }
+        try {
+            auto [best, error] = run(operands[0], operands[1], operands[2], operands[3]);
+            st.push(std::move(best));
+            st.push(WofValue(error));
+        } catch (...) {
+            for (auto& v : operands) st.push(std::move(v));
+            throw;
+        }
+    }, {4, 2});
+}
+
+} // namespace woflang
@@ -0,0 +1,104 @@
+#include "history.hpp"
+#include "woflang.hpp"
+#include <algorithm>
+#include <bit>
+#include <vector>
+
+namespace woflang {
+
+struct StackHistory::Node {
+    WofValue value;
+    mutable NodePtr below;  // moved out by release()
+};
+
+namespace {
+
+struct StackPeek : std::stack<WofValue> {
+    static const container_type& of(const std::stack<WofValue>& s) {
+        return s.*(&StackPeek::c);
+    }
+};
+
+bool same(const WofValue& a, const WofValue& b) {
+    return a.exact == b.exact && a.i == b.i &&
+           std::bit_cast<uint64_t>(a.d) == std::bit_cast<uint64_t>(b.d) &&
+           a.arr == b.arr && a.lazy == b.lazy && a.quote == b.quote && a.cols == b.cols &&
+           a.s == b.s;
+}
+
+} // namespace
+
+StackHistory::StackHistory(const std::stack<WofValue>& st, size_t capacity)
+    : capacity_(std::max<size_t>(capacity, 1)) {
+    const auto& values = StackPeek::of(st);
+    State initial;
+    for (const auto& v : values) initial.top = std::make_shared<const Node>(Node{v, std::move(initial.top)});
+    initial.depth = values.size();
+    states_.push_back(std::move(initial));
+}
+
+StackHistory::~StackHistory() {
+    for (auto& s : states_) release(std::move(s.top));
+}
+
+void StackHistory::record(const std::stack<WofValue>& st, StackEffect hint) {
+    const auto& values = StackPeek::of(st);
+    const State& base = states_[pos_];
+    size_t keep;
+    if (hint.known() && base.depth >= hint.in && base.depth - hint.in + hint.out == values.size()) {
+        if (hint.in == 0 && hint.out == 0) return;
+        keep = base.depth - hint.in;
+    } else {
+        std::vector<const Node*> chain(base.depth);
+        size_t k = base.depth;
+        for (const Node* n = base.top.get(); n; n = n->below.get()) chain[--k] = n;
+        size_t limit = std::min(base.depth, values.size());
+        keep = 0;
+        while (keep < limit && same(chain[keep]->value, values[keep])) ++keep;
+        if (keep == base.depth && keep == values.size()) return;
+    }
+
+    State next{base.top, values.size()};
+    for (size_t d = base.depth; d > keep; --d) next.top = next.top->below;
+    for (size_t k = keep; k < values.size(); ++k) {
+        next.top = std::make_shared<const Node>(Node{values[k], std::move(next.top)});
+    }
+    push_state(std::move(next));
+}
+
+void StackHistory::push_state(State s) {
+    while (states_.size() > pos_ + 1) {
+        release(std::move(states_.back().top));
+        states_.pop_back();
+    }
+    states_.push_back(std::move(s));
+    if (states_.size() > capacity_) {
+        release(std::move(states_.front().top));
+        states_.pop_front();
+        ++first_;
+    }
+    pos_ = states_.size() - 1;
+}
+
+bool StackHistory::restore(uint64_t step, std::stack<WofValue>& st) {
+    if (step < first() || step > last()) return false;
+    pos_ = static_cast<size_t>(step - first_);
+    const State& s = states_[pos_];
+    std::vector<const WofValue*> values(s.depth);
+    size_t k = s.depth;
+    for (const Node* n = s.top.get(); n; n = n->below.get()) values[--k] = &n->value;
+    while (!st.empty()) st.pop();
+    for (const WofValue* v : values) st.push(*v);
+    return true;
+}
+
+void StackHistory::release(NodePtr p) {
+    // Unlink nodes owned only by this chain one at a time; the default
+    // destructor would recurse once per node.
+    while (p && p.use_count() == 1) {
+        NodePtr below = std::move(p->below);
+        p = std::move(below);
+    }
+}
+
+} // namespace woflang
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <stack>
+#include "stack_effect.hpp"
+
+namespace woflang {
+
+struct WofValue;
+
+// Stack states recorded for time-travel debugging. Each state is a
+// persistent stack: an immutable list of nodes from the top down, where a
+// step that replaces the top k values allocates k nodes and shares the rest
+// with the previous state. Recording a step therefore costs memory for what
+// it changed, not for the whole stack.
+//
+// Steps are numbered from 0 (the stack when recording started). Steps that
+// leave the stack unchanged are not recorded. At most `capacity` states are
+// kept; the oldest are dropped first.
+class StackHistory {
+public:
+    explicit StackHistory(const std::stack<WofValue>& st, size_t capacity);
+    ~StackHistory();
+
+    StackHistory(const StackHistory&) = delete;
+    StackHistory& operator=(const StackHistory&) = delete;
+
+    // Record `st` after an instruction with stack effect `hint` (unknown
+    // when it has none). Ops with a declared effect only touch their top
+    // `in` values, so when the depth agrees only `out` nodes are built;
+    // otherwise the state is diffed against the previous one from the
+    // bottom up. Recording after travelling back discards the redo steps.
+    void record(const std::stack<WofValue>& st, StackEffect hint = {});
+
+    uint64_t first() const { return first_; }
+    uint64_t last() const { return first_ + states_.size() - 1; }
+    uint64_t position() const { return first_ + pos_; }
+
+    // Rebuild `st` as it was at `step`; false if that step is not retained.
+    bool restore(uint64_t step, std::stack<WofValue>& st);
+
+private:
+    struct Node;
+    using NodePtr = std::shared_ptr<const Node>;
+    struct State {
+        NodePtr top;
+        size_t depth = 0;
+    };
+
+    void push_state(State s);
+    // Drops a state without recursing down long chains of nodes.
+    static void release(NodePtr p);
+
+    std::deque<State> states_;
+    size_t pos_ = 0;
+    uint64_t first_ = 0;
+    size_t capacity_;
+};
+
+} // namespace woflang
@@ -0,0 +1,264 @@
+#include "woflang.hpp"
+#include "../io/mapped_file.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace woflang {
+
+namespace {
+
+constexpr char kImageMagic[4] = {'W', 'O', 'F', 'I'};
+constexpr uint32_t kImageFormat = 1;
+constexpr uint32_t kByteOrderMark = 0x01020304;
+
+// Followed by the plugin paths, words, variables and the stack (bottom
+// first). Every record starts 8-byte aligned so compiled code can be used
+// straight from the mapping.
+struct ImageHeader {
+    char magic[4];
+    uint32_t format;
+    uint32_t byte_order;
+    uint32_t plugin_count;
+    uint64_t version_hash;
+    uint32_t word_count;
+    uint32_t variable_count;
+    uint32_t stack_count;
+    uint32_t reserved;
+};
+static_assert(sizeof(ImageHeader) % 8 == 0);
+
+enum class ValueKind : uint32_t { Number, String, Array, Quotation };
+
+class ImageWriter {
+public:
+    template <class T>
+    void put(const T& v) {
+        out.append(reinterpret_cast<const char*>(&v), sizeof(T));
+    }
+
+    void bytes(std::string_view b) {
+        put(static_cast<uint64_t>(b.size()));
+        out.append(b);
+        out.resize((out.size() + 7) & ~size_t(7), '\0');
+    }
+
+    void code(const ProgramView& program, uint32_t begin, uint32_t end) {
+        auto copy = extract(program, begin, end);
+        bytes(serialize(copy->view(), CacheKey{}));
+    }
+
+    void value(const WofValue& v) {
+        if (v.quote) {
+            put(ValueKind::Quotation);
+            put(uint32_t{0});
+            code(v.quote->program, v.quote->begin, v.quote->end);
+        } else if (v.is_array()) {
+            if (array_size(v) == kUnbounded) {
+                throw std::runtime_error("image save: cannot save an unbounded sequence");
+            }
+            auto values = v.array();
+            put(ValueKind::Array);
+            put(v.cols);
+            bytes({reinterpret_cast<const char*>(values->data()), values->size() * sizeof(double)});
+        } else if (v.is_string()) {
+            put(ValueKind::String);
+            put(uint32_t{0});
+            bytes(v.s);
+        } else {
+            put(ValueKind::Number);
+            put(static_cast<uint32_t>(v.exact));
+            put(v.i);
+            put(v.d);
+        }
+    }
+
+    std::string out;
+};
+
+class ImageReader {
+public:
+    ImageReader(std::string_view data, std::shared_ptr<const void> owner)
+        : data_(data), owner_(std::move(owner)) {}
+
+    template <class T>
+    bool get(T& v) {
+        if (sizeof(T) > data_.size() - pos_) return false;
+        std::memcpy(&v, data_.data() + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return true;
+    }
+
+    bool bytes(std::string_view& out) {
+        uint64_t n;
+        if (!get(n) || n > data_.size() - pos_) return false;
+        out = data_.substr(pos_, n);
+        pos_ = std::min(data_.size(), (pos_ + n + 7) & ~size_t(7));
+        return true;
+    }
+
+    bool string(std::string& out) {
+        std::string_view b;
+        if (!bytes(b)) return false;
+        out.assign(b);
+        return true;
+    }
+
+    // Views into the mapping; the quotation keeps it alive.
+    std::shared_ptr<const Quotation> code() {
+        std::string_view blob;
+        if (!bytes(blob)) return nullptr;
+        auto view = deserialize(blob, CacheKey{});
+        if (!view) return nullptr;
+        auto q = std::make_shared<Quotation>();
+        q->owner = owner_;
+        q->program = *view;
+        q->end = static_cast<uint32_t>(view->code.size());
+        return q;
+    }
+
+    bool value(WofValue& v) {
+        ValueKind kind;
+        uint32_t detail;  // Number: exact flag, Array: matrix columns
+        if (!get(kind) || !get(detail)) return false;
+        switch (kind) {
+        case ValueKind::Number:
+            v.exact = detail != 0;
+            return get(v.i) && get(v.d);
+        case ValueKind::String:
+            v.text = true;
+            return string(v.s);
+        case ValueKind::Array: {
+            std::string_view b;
+            if (!bytes(b) || b.size() % sizeof(double) != 0) return false;
+            WofArray values(b.size() / sizeof(double));
+            std::memcpy(values.data(), b.data(), b.size());
+            if (detail != 0 && values.size() % detail != 0) return false;
+            v = WofValue::make_matrix(std::move(values), detail);
+            return true;
+        }
+        case ValueKind::Quotation:
+            v.quote = code();
+            return v.quote != nullptr;
+        }
+        return false;
+    }
+
+private:
+    std::string_view data_;
+    size_t pos_ = 0;
+    std::shared_ptr<const void> owner_;
+};
+
+} // namespace
+
+void WoflangInterpreter::save_image(const std::filesystem::path& path) const {
+    ImageHeader h{};
+    std::memcpy(h.magic, kImageMagic, sizeof(kImageMagic));
+    h.format = kImageFormat;
+    h.byte_order = kByteOrderMark;
+    h.version_hash = fnv1a(WOFLANG_VERSION);
+    h.plugin_count = static_cast<uint32_t>(plugins_.size());
+    h.word_count = static_cast<uint32_t>(words_.size());
+    h.variable_count = static_cast<uint32_t>(variables_.size());
+    h.stack_count = static_cast<uint32_t>(stack.size());
+
+    ImageWriter w;
+    w.put(h);
+    for (const auto& plugin : plugins_) w.bytes(plugin);
+    for (const auto& [name, body] : words_) {
+        w.bytes(name);
+        w.code(body->program, body->begin, body->end);
+    }
+    for (const auto& [name, value] : variables_) {
+        w.bytes(name);
+        w.value(value);
+    }
+    std::stack<WofValue> copy = stack;
+    std::vector<WofValue> bottom_up;
+    for (; !copy.empty(); copy.pop()) bottom_up.push_back(copy.top());
+    std::for_each(bottom_up.rbegin(), bottom_up.rend(), [&](const WofValue& v) { w.value(v); });
+
+    if (!write_file_atomic(path, w.out)) {
+        throw std::runtime_error("image save: cannot write " + path.string());
+    }
+}
+
+bool WoflangInterpreter::load_image(const std::filesystem::path& path) {
+    auto file = MappedFile::open(path);
+    if (!file) {
+        std::cout << "Error: cannot read image " << path.string() << "\n";
+        return false;
+    }
+    ImageReader r(file->text(), file);
+    ImageHeader h;
+    if (!r.get(h) || std::memcmp(h.magic, kImageMagic, sizeof(kImageMagic)) != 0 ||
+        h.format != kImageFormat || h.byte_order != kByteOrderMark ||
+        h.version_hash != fnv1a(WOFLANG_VERSION)) {
+        std::cout << "Error: " << path.string() << " is not an image for this woflang version\n";
+        return false;
+    }
+
+    // Every record takes at least 8 bytes, which bounds the counts.
+    uint64_t records = uint64_t(h.plugin_count) + h.word_count + h.variable_count + h.stack_count;
+    if (records > file->size() / 8) {
+        std::cout << "Error: image " << path.string() << " is corrupt\n";
+        return false;
+    }
+
+    // Decode everything before touching the interpreter.
+    std::vector<std::string> plugins(h.plugin_count);
+    std::vector<std::pair<std::string, std::shared_ptr<const Quotation>>> words(h.word_count);
+    std::vector<std::pair<std::string, WofValue>> variables(h.variable_count);
+    std::vector<WofValue> values(h.stack_count);
+    bool ok = true;
+    for (auto& plugin : plugins) ok = ok && r.string(plugin);
+    for (auto& [name, body] : words) ok = ok && r.string(name) && (body = r.code()) != nullptr;
+    for (auto& [name, value] : variables) ok = ok && r.string(name) && r.value(value);
+    for (auto& value : values) ok = ok && r.value(value);
+    if (!ok) {
+        std::cout << "Error: image " << path.string() << " is corrupt\n";
+        return false;
+    }
+
+    for (const auto& plugin : plugins) {
+        if (std::find(plugins_.begin(), plugins_.end(), plugin) == plugins_.end()) loadPlugin(plugin);
+    }
+    for (auto& [name, body] : words) define_word(name, std::move(body));
+    for (auto& [name, value] : variables) set_variable(name, std::move(value));
+    clear_stack();
+    for (auto& value : values) stack.push(std::move(value));
+    return true;
+}
+
+void WoflangInterpreter::register_image_ops() {
+    // Both work on the interpreter's own stack, so they are refused inside
+    // pmap and the other parallel ops, which run on private stacks.
+    auto need_path = [this](std::stack<WofValue>& st, const char* op) {
+        if (&st != &stack) throw std::runtime_error(std::string(op) + ": not available in a parallel op");
+        if (st.empty() || st.top().s.empty()) throw std::runtime_error(std::string(op) + ": expects a 'path");
+        return st.top().s;
+    };
+
+    // 'path save_image  ->   (saves the stack below the path)
+    register_op("save_image", [this, need_path](std::stack<WofValue>& st) {
+        std::string path = need_path(st, "save_image");
+        WofValue name = std::move(st.top());
+        st.pop();
+        try {
+            save_image(path);
+        } catch (...) {
+            st.push(std::move(name));
+            throw;
+        }
+    }, {1, 0});
+
+    // 'path load_image  ->  the saved stack, words and variables
+    // No declared effect: the depth afterwards is whatever was saved.
+    register_op("load_image", [this, need_path](std::stack<WofValue>& st) {
+        std::string path = need_path(st, "load_image");
+        if (!load_image(path)) throw std::runtime_error("load_image: cannot load '" + path + "'");
+    });
+}
+
+} // namespace woflang
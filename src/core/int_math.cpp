@@ -0,0 +1,71 @@
+#include "int_math.hpp"
+#include "woflang.hpp"
+#include <cmath>
+
+namespace woflang {
+
+bool int_binary(ElemOp op, const WofValue& a, const WofValue& b, WofValue& out) {
+    if (!a.exact || !b.exact) return false;
+    const int64_t x = a.i, y = b.i;
+    int64_t r = 0;
+    switch (op) {
+    case ElemOp::Add:
+        if (add_overflow(x, y, &r)) return false;
+        break;
+    case ElemOp::Sub:
+        if (sub_overflow(x, y, &r)) return false;
+        break;
+    case ElemOp::Mul:
+        if (mul_overflow(x, y, &r)) return false;
+        break;
+    case ElemOp::Div:
+        // Only exact quotients stay integers: 7 2 / is still 3.5.
+        if (y == 0 || (y == -1 && x == std::numeric_limits<int64_t>::min()) || x % y != 0) {
+            return false;
+        }
+        r = x / y;
+        break;
+    case ElemOp::Mod:
+        // Truncated like fmod, so the sign follows the dividend either way.
+        if (y == 0) return false;
+        r = y == -1 ? 0 : x % y;
+        break;
+    case ElemOp::Pow: {
+        if (y < 0) return false;
+        int64_t base = x, e = y;
+        r = 1;
+        while (e > 0) {
+            if ((e & 1) && mul_overflow(r, base, &r)) return false;
+            e >>= 1;
+            if (e > 0 && mul_overflow(base, base, &base)) return false;
+        }
+        break;
+    }
+    case ElemOp::Min:
+        r = x < y ? x : y;
+        break;
+    case ElemOp::Max:
+        r = x > y ? x : y;
+        break;
+    default:
+        return false;
+    }
+    out = WofValue::make_int(r);
+    return true;
+}
+
+bool exact_int(const WofValue& v, int64_t* out) {
+    if (v.exact) {
+        *out = v.i;
+        return true;
+    }
+    if (v.is_array() || v.is_quotation() || v.is_string()) return false;
+    double x = v.as_numeric();
+    // -2^63 is exact in a double; 2^63 is the first value past the range.
+    constexpr double kLimit = 9223372036854775808.0;
+    if (!(x >= -kLimit && x < kLimit) || x != std::trunc(x)) return false;
+    *out = static_cast<int64_t>(x);
+    return true;
+}
+
+} // namespace woflang
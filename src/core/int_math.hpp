@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#include "lazy.hpp"
+
+namespace woflang {
+
+// Overflow-checked int64 arithmetic: true (and *r unset) when the exact
+// result does not fit, so callers can promote to double instead.
+inline bool add_overflow(int64_t a, int64_t b, int64_t* r) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_add_overflow(a, b, r);
+#else
+    if ((b > 0 && a > std::numeric_limits<int64_t>::max() - b) ||
+        (b < 0 && a < std::numeric_limits<int64_t>::min() - b)) {
+        return true;
+    }
+    *r = a + b;
+    return false;
+#endif
+}
+
+inline bool sub_overflow(int64_t a, int64_t b, int64_t* r) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_sub_overflow(a, b, r);
+#else
+    if ((b < 0 && a > std::numeric_limits<int64_t>::max() + b) ||
+        (b > 0 && a < std::numeric_limits<int64_t>::min() + b)) {
+        return true;
+    }
+    *r = a - b;
+    return false;
+#endif
+}
+
+inline bool mul_overflow(int64_t a, int64_t b, int64_t* r) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_mul_overflow(a, b, r);
+#else
+    int64_t high;
+    int64_t low = _mul128(a, b, &high);
+    if (high != (low >> 63)) return true;
+    *r = low;
+    return false;
+#endif
+}
+
+// Integer lane for binary arithmetic: when both operands are exact integers
+// and the result is an exact int64, store it in `out` and return true.
+// Otherwise (mixed operands, overflow, inexact quotient, division by zero)
+// return false and the caller takes its double path, which is the
+// promotion. Handles Add, Sub, Mul, Div, Mod, Pow, Min and Max.
+bool int_binary(ElemOp op, const WofValue& a, const WofValue& b, WofValue& out);
+
+// The int64 a value stands for: an exact int, or an integral double in
+// [-2^63, 2^63). False for fractions, NaN, infinities and anything out of
+// range, where a plain cast would be undefined.
+bool exact_int(const WofValue& v, int64_t* out);
+
+} // namespace woflang
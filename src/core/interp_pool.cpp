@@ -0,0 +1,86 @@
+#include "interp_pool.hpp"
+#include <algorithm>
+
+namespace woflang {
+
+InterpreterPool::InterpreterPool(size_t size, const std::filesystem::path& plugin_dir) {
+    size = std::max<size_t>(size, 1);
+    for (size_t k = 0; k < size; ++k) {
+        std::unique_ptr<WoflangInterpreter> interp;
+        if (k == 0) {
+            interp = std::make_unique<WoflangInterpreter>();
+            interp->set_plugin_messages(false);
+            if (!plugin_dir.empty() && std::filesystem::exists(plugin_dir)) {
+                interp->load_plugins(plugin_dir);
+            }
+            plugin_paths_ = interp->plugins();
+        } else {
+            interp = build();
+        }
+        free_.push_back(interp.get());
+        all_.push_back(std::move(interp));
+    }
+}
+
+std::unique_ptr<WoflangInterpreter> InterpreterPool::build() const {
+    auto interp = std::make_unique<WoflangInterpreter>();
+    interp->set_plugin_messages(false);
+    // dlopen of an already loaded library only bumps its refcount.
+    for (const auto& path : plugin_paths_) interp->loadPlugin(path);
+    return interp;
+}
+
+InterpreterPool::~InterpreterPool() = default;
+
+WoflangInterpreter& InterpreterPool::acquire() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    available_.wait(lock, [this] { return !free_.empty(); });
+    WoflangInterpreter* interp = free_.back();
+    free_.pop_back();
+    interp->set_limits(limits_);
+    return *interp;
+}
+
+void InterpreterPool::release(WoflangInterpreter& interp) {
+    interp.clear_stack();
+    interp.clear_variables();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.push_back(&interp);
+    }
+    available_.notify_one();
+}
+
+void InterpreterPool::renew(WoflangInterpreter& interp) {
+    auto fresh = build();
+    std::unique_ptr<WoflangInterpreter> old;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::find_if(all_.begin(), all_.end(), [&](const auto& p) { return p.get() == &interp; });
+        old = std::move(*it);
+        *it = std::move(fresh);
+        free_.push_back(it->get());
+    }
+    available_.notify_one();
+}
+
+std::shared_ptr<const Program> InterpreterPool::compile_shared(std::string_view source) {
+    {
+        std::shared_lock<std::shared_mutex> lock(code_mutex_);
+        if (auto it = code_.find(source); it != code_.end()) return it->second;
+    }
+    auto program = std::make_shared<Program>();
+    *program = compile(source, std::pmr::get_default_resource());
+    std::unique_lock<std::shared_mutex> lock(code_mutex_);
+    // Running programs hold their own reference, so dropping the whole
+    // cache when it fills up is safe.
+    if (code_.size() >= kMaxCachedPrograms) code_.clear();
+    return code_.try_emplace(std::string(source), std::move(program)).first->second;
+}
+
+void InterpreterPool::set_limits(const ExecutionLimits& limits) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    limits_ = limits;
+}
+
+} // namespace woflang
@@ -0,0 +1,70 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "woflang.hpp"
+
+namespace woflang {
+
+// Fixed set of interpreters built up front (builtins registered, plugins
+// loaded), handed out one request at a time. Releasing an interpreter clears
+// its stack, variables and limits; words and plugins persist. Sources are
+// compiled once and the bytecode is shared by every instance, since it binds
+// ops by name only when run.
+class InterpreterPool {
+public:
+    // An empty plugin_dir loads no plugins. The directory is scanned once;
+    // the other instances load the same plugin paths directly.
+    explicit InterpreterPool(size_t size, const std::filesystem::path& plugin_dir = {});
+    ~InterpreterPool();
+
+    InterpreterPool(const InterpreterPool&) = delete;
+    InterpreterPool& operator=(const InterpreterPool&) = delete;
+
+    // Blocks while every interpreter is in use.
+    WoflangInterpreter& acquire();
+    void release(WoflangInterpreter& interp);
+    // Like release(), but `interp` is destroyed and a newly built instance
+    // (same plugins) takes its place, for callers that must not leak words
+    // or redefined ops into the next user. The build runs on the calling
+    // thread, outside the pool lock.
+    void renew(WoflangInterpreter& interp);
+
+    // Compiled form of `source`, shared across instances and calls.
+    std::shared_ptr<const Program> compile_shared(std::string_view source);
+
+    // Limits applied to each interpreter when it is handed out.
+    void set_limits(const ExecutionLimits& limits);
+
+    size_t size() const { return all_.size(); }
+
+private:
+    struct SourceHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+    };
+
+    static constexpr size_t kMaxCachedPrograms = 4096;
+
+    std::unique_ptr<WoflangInterpreter> build() const;
+
+    std::vector<std::string> plugin_paths_;
+    std::vector<std::unique_ptr<WoflangInterpreter>> all_;
+    std::vector<WoflangInterpreter*> free_;
+    ExecutionLimits limits_;
+    std::mutex mutex_;
+    std::condition_variable available_;
+
+    std::shared_mutex code_mutex_;
+    std::unordered_map<std::string, std::shared_ptr<const Program>, SourceHash, std::equal_to<>> code_;
+};
+
+} // namespace woflang
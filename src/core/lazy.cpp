@@ -0,0 +1,534 @@
+#include "lazy.hpp"
+#include "woflang.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace woflang {
+
+namespace {
+
+// Elements per chunk: each node of an expression owns one chunk buffer, so
+// the intermediates of a pass stay in L1 instead of becoming full arrays.
+constexpr size_t kBlock = 512;
+// Expressions larger than this are materialized before growing further, so a
+// loop that keeps adding to the same array cannot build an unbounded DAG.
+constexpr size_t kMaxFusedNodes = 64;
+
+bool is_binary(ElemOp op) { return op <= ElemOp::Atan2; }
+
+// Simple loops over contiguous chunks: the compiler vectorizes the
+// arithmetic ones, the libm ones at least avoid per-element dispatch.
+template <class F>
+void each(const double* a, double* out, size_t n, F f) {
+    for (size_t k = 0; k < n; ++k) out[k] = f(a[k]);
+}
+
+template <class F>
+void each(const double* a, const double* b, double* out, size_t n, F f) {
+    for (size_t k = 0; k < n; ++k) out[k] = f(a[k], b[k]);
+}
+
+void apply(ElemOp op, const double* a, double* out, size_t n) {
+    constexpr double to_rad = std::numbers::pi / 180.0;
+    constexpr double to_deg = 180.0 / std::numbers::pi;
+    switch (op) {
+    case ElemOp::Sqrt:    each(a, out, n, [](double x) { return std::sqrt(x); }); break;
+    case ElemOp::Cbrt:    each(a, out, n, [](double x) { return std::cbrt(x); }); break;
+    case ElemOp::Exp:     each(a, out, n, [](double x) { return std::exp(x); }); break;
+    case ElemOp::Ln:      each(a, out, n, [](double x) { return std::log(x); }); break;
+    case ElemOp::Log10:   each(a, out, n, [](double x) { return std::log10(x); }); break;
+    case ElemOp::Log2:    each(a, out, n, [](double x) { return std::log2(x); }); break;
+    case ElemOp::Abs:     each(a, out, n, [](double x) { return std::abs(x); }); break;
+    case ElemOp::Floor:   each(a, out, n, [](double x) { return std::floor(x); }); break;
+    case ElemOp::Ceil:    each(a, out, n, [](double x) { return std::ceil(x); }); break;
+    case ElemOp::Round:   each(a, out, n, [](double x) { return std::round(x); }); break;
+    case ElemOp::Trunc:   each(a, out, n, [](double x) { return std::trunc(x); }); break;
+    case ElemOp::Sign:    each(a, out, n, [](double x) { return double(x > 0) - double(x < 0); }); break;
+    case ElemOp::Sin:     each(a, out, n, [](double x) { return std::sin(x); }); break;
+    case ElemOp::Cos:     each(a, out, n, [](double x) { return std::cos(x); }); break;
+    case ElemOp::Tan:     each(a, out, n, [](double x) { return std::tan(x); }); break;
+    case ElemOp::Asin:    each(a, out, n, [](double x) { return std::asin(x); }); break;
+    case ElemOp::Acos:    each(a, out, n, [](double x) { return std::acos(x); }); break;
+    case ElemOp::Atan:    each(a, out, n, [](double x) { return std::atan(x); }); break;
+    case ElemOp::Sinh:    each(a, out, n, [](double x) { return std::sinh(x); }); break;
+    case ElemOp::Cosh:    each(a, out, n, [](double x) { return std::cosh(x); }); break;
+    case ElemOp::Tanh:    each(a, out, n, [](double x) { return std::tanh(x); }); break;
+    case ElemOp::Deg2Rad: each(a, out, n, [=](double x) { return x * to_rad; }); break;
+    case ElemOp::Rad2Deg: each(a, out, n, [=](double x) { return x * to_deg; }); break;
+    default: break;
+    }
+}
+
+void apply(ElemOp op, const double* a, const double* b, double* out, size_t n) {
+    switch (op) {
+    case ElemOp::Add:   each(a, b, out, n, [](double x, double y) { return x + y; }); break;
+    case ElemOp::Sub:   each(a, b, out, n, [](double x, double y) { return x - y; }); break;
+    case ElemOp::Mul:   each(a, b, out, n, [](double x, double y) { return x * y; }); break;
+    case ElemOp::Div:   each(a, b, out, n, [](double x, double y) { return x / y; }); break;
+    case ElemOp::Mod:   each(a, b, out, n, [](double x, double y) { return std::fmod(x, y); }); break;
+    case ElemOp::Pow:   each(a, b, out, n, [](double x, double y) { return std::pow(x, y); }); break;
+    case ElemOp::Min:   each(a, b, out, n, [](double x, double y) { return std::min(x, y); }); break;
+    case ElemOp::Max:   each(a, b, out, n, [](double x, double y) { return std::max(x, y); }); break;
+    case ElemOp::Atan2: each(a, b, out, n, [](double x, double y) { return std::atan2(x, y); }); break;
+    default: break;
+    }
+}
+
+// Pull-based evaluation state for one pass over an expression. next(n)
+// returns exactly n elements (n <= kBlock and within the node's size); the
+// view stays valid until the following call.
+class Cursor {
+public:
+    virtual ~Cursor() = default;
+    virtual std::span<const double> next(size_t n) = 0;
+};
+
+// Opens a pass over `e`. Nodes the pass reads more than once share one
+// cursor (see SharedCursor).
+std::unique_ptr<Cursor> open(const LazyExpr& e);
+
+class ArrayCursor : public Cursor {
+public:
+    explicit ArrayCursor(const double* data) : p_(data) {}
+    std::span<const double> next(size_t n) override {
+        std::span<const double> out(p_, n);
+        p_ += n;
+        return out;
+    }
+private:
+    const double* p_;
+};
+
+class ScalarCursor : public Cursor {
+public:
+    explicit ScalarCursor(double v) { std::fill_n(buf_, kBlock, v); }
+    std::span<const double> next(size_t n) override { return {buf_, n}; }
+private:
+    double buf_[kBlock];
+};
+
+class RangeCursor : public Cursor {
+public:
+    RangeCursor(double first, double step) : first_(first), step_(step) {}
+    std::span<const double> next(size_t n) override {
+        // first + i*step rather than accumulating, so long ranges don't drift.
+        for (size_t k = 0; k < n; ++k) buf_[k] = first_ + static_cast<double>(i_ + k) * step_;
+        i_ += n;
+        return {buf_, n};
+    }
+private:
+    double first_, step_;
+    size_t i_ = 0;
+    double buf_[kBlock];
+};
+
+class UnaryCursor : public Cursor {
+public:
+    UnaryCursor(ElemOp op, std::unique_ptr<Cursor> in) : op_(op), in_(std::move(in)) {}
+    std::span<const double> next(size_t n) override {
+        apply(op_, in_->next(n).data(), buf_, n);
+        return {buf_, n};
+    }
+private:
+    ElemOp op_;
+    std::unique_ptr<Cursor> in_;
+    double buf_[kBlock];
+};
+
+class BinaryCursor : public Cursor {
+public:
+    BinaryCursor(ElemOp op, std::unique_ptr<Cursor> a, std::unique_ptr<Cursor> b)
+        : op_(op), a_(std::move(a)), b_(std::move(b)) {}
+    std::span<const double> next(size_t n) override {
+        const double* a = a_->next(n).data();
+        apply(op_, a, b_->next(n).data(), buf_, n);
+        return {buf_, n};
+    }
+private:
+    ElemOp op_;
+    std::unique_ptr<Cursor> a_, b_;
+    double buf_[kBlock];
+};
+
+// Interleaves a0 b0 a1 b1 ...; an odd request leaves one b pending.
+class ZipCursor : public Cursor {
+public:
+    ZipCursor(std::unique_ptr<Cursor> a, std::unique_ptr<Cursor> b)
+        : a_(std::move(a)), b_(std::move(b)) {}
+    std::span<const double> next(size_t n) override {
+        size_t out = 0;
+        if (has_pending_ && n > 0) {
+            buf_[out++] = pending_;
+            has_pending_ = false;
+        }
+        size_t pairs = (n - out + 1) / 2;
+        if (pairs > 0) {
+            auto a = a_->next(pairs);
+            auto b = b_->next(pairs);
+            for (size_t k = 0; k < pairs; ++k) {
+                buf_[out++] = a[k];
+                if (out < n) buf_[out++] = b[k];
+                else { pending_ = b[k]; has_pending_ = true; }
+            }
+        }
+        return {buf_, n};
+    }
+private:
+    std::unique_ptr<Cursor> a_, b_;
+    double pending_ = 0.0;
+    bool has_pending_ = false;
+    double buf_[kBlock];
+};
+
+// A computed node read more than once in one pass (`x dup *` reads x
+// twice) is evaluated once: its readers share one cursor over it and copy
+// from the chunk it produced last. A reader that falls behind that chunk,
+// because the readers advance at different rates (e.g. through zip),
+// reopens the node privately and skips ahead.
+struct SharedNode {
+    const LazyExpr* expr = nullptr;
+    std::unique_ptr<Cursor> in;
+    std::span<const double> chunk;
+    size_t start = 0;  // position of chunk[0]
+};
+
+class SharedCursor : public Cursor {
+public:
+    explicit SharedCursor(std::shared_ptr<SharedNode> node) : node_(std::move(node)) {}
+    std::span<const double> next(size_t n) override {
+        if (own_) return own_->next(n);
+        SharedNode& s = *node_;
+        if (pos_ < s.start) {
+            own_ = open(*s.expr);
+            for (size_t left = pos_; left > 0;) {
+                size_t k = std::min(left, kBlock);
+                own_->next(k);
+                left -= k;
+            }
+            return own_->next(n);
+        }
+        // The chunk ends at the furthest position any reader has reached.
+        size_t end = s.start + s.chunk.size();
+        size_t have = std::min(n, end - pos_);
+        std::copy_n(s.chunk.begin() + static_cast<std::ptrdiff_t>(pos_ - s.start), have, buf_);
+        if (have < n) {
+            s.chunk = s.in->next(n - have);
+            s.start = end;
+            std::copy(s.chunk.begin(), s.chunk.end(), buf_ + have);
+        }
+        pos_ += n;
+        return {buf_, n};
+    }
+private:
+    std::shared_ptr<SharedNode> node_;
+    std::unique_ptr<Cursor> own_;
+    size_t pos_ = 0;
+    double buf_[kBlock];
+};
+
+using SharedNodes = std::unordered_map<const LazyExpr*, std::shared_ptr<SharedNode>>;
+
+void count_reads(const LazyExpr& e, std::unordered_map<const LazyExpr*, unsigned>& reads) {
+    if (e.result) return;
+    switch (e.kind) {
+    case LazyExpr::Kind::Unary:
+    case LazyExpr::Kind::Take:
+        if (++reads[&e] == 1) count_reads(*e.lhs, reads);
+        break;
+    case LazyExpr::Kind::Binary:
+    case LazyExpr::Kind::Zip:
+        if (++reads[&e] == 1) {
+            count_reads(*e.lhs, reads);
+            count_reads(*e.rhs, reads);
+        }
+        break;
+    default:
+        break;  // leaves are as cheap to read twice as to share
+    }
+}
+
+std::unique_ptr<Cursor> open_node(const LazyExpr& e, SharedNodes& shared);
+
+std::unique_ptr<Cursor> open_cursor(const LazyExpr& e, SharedNodes& shared) {
+    if (e.result) return std::make_unique<ArrayCursor>(e.result->data());
+    switch (e.kind) {
+    case LazyExpr::Kind::Array:  return std::make_unique<ArrayCursor>(e.data->data());
+    case LazyExpr::Kind::View:   return std::make_unique<ArrayCursor>(e.view);
+    case LazyExpr::Kind::Scalar: return std::make_unique<ScalarCursor>(e.scalar);
+    case LazyExpr::Kind::Range:  return std::make_unique<RangeCursor>(e.scalar, e.step);
+    case LazyExpr::Kind::Unary:  return std::make_unique<UnaryCursor>(e.op, open_node(*e.lhs, shared));
+    case LazyExpr::Kind::Binary:
+        return std::make_unique<BinaryCursor>(e.op, open_node(*e.lhs, shared), open_node(*e.rhs, shared));
+    case LazyExpr::Kind::Take:   return open_node(*e.lhs, shared);  // the consumer stops at e.size
+    case LazyExpr::Kind::Zip:
+        return std::make_unique<ZipCursor>(open_node(*e.lhs, shared), open_node(*e.rhs, shared));
+    }
+    return nullptr;
+}
+
+std::unique_ptr<Cursor> open_node(const LazyExpr& e, SharedNodes& shared) {
+    auto it = shared.find(&e);
+    if (it == shared.end()) return open_cursor(e, shared);
+    SharedNode& node = *it->second;
+    if (!node.in) {
+        node.expr = &e;
+        node.in = open_cursor(e, shared);
+    }
+    return std::make_unique<SharedCursor>(it->second);
+}
+
+std::unique_ptr<Cursor> open(const LazyExpr& e) {
+    std::unordered_map<const LazyExpr*, unsigned> reads;
+    count_reads(e, reads);
+    SharedNodes shared;
+    for (const auto& [node, count] : reads) {
+        if (count > 1) shared.emplace(node, std::make_shared<SharedNode>());
+    }
+    return open_node(e, shared);
+}
+
+void stream(const LazyExpr& e, const std::function<void(std::span<const double>)>& chunk) {
+    if (e.size == kUnbounded) {
+        throw std::runtime_error("unbounded sequence; use take to bound it first");
+    }
+    auto cursor = open(e);
+    for (size_t done = 0; done < e.size;) {
+        size_t n = std::min(kBlock, e.size - done);
+        chunk(cursor->next(n));
+        done += n;
+    }
+}
+
+std::shared_ptr<const LazyExpr> leaf(const WofValue& v) {
+    if (v.lazy) {
+        if (v.lazy->nodes < kMaxFusedNodes || v.lazy->size == kUnbounded) return v.lazy;
+        auto e = std::make_shared<LazyExpr>();
+        e->data = materialize(*v.lazy);
+        e->size = e->data->size();
+        return e;
+    }
+    auto e = std::make_shared<LazyExpr>();
+    if (v.arr) {
+        e->data = v.arr;
+        e->size = v.arr->size();
+    } else {
+        e->kind = LazyExpr::Kind::Scalar;
+        e->scalar = v.as_numeric();
+        e->size = kUnbounded;
+    }
+    return e;
+}
+
+WofValue wrap(std::shared_ptr<const LazyExpr> e) {
+    WofValue v;
+    v.lazy = std::move(e);
+    return v;
+}
+
+// Σ without visiting elements, where the shape of the expression allows it.
+std::optional<double> closed_sum(const LazyExpr& e) {
+    double n = static_cast<double>(e.size);
+    if (e.size == kUnbounded) return std::nullopt;
+    switch (e.kind) {
+    case LazyExpr::Kind::Scalar:
+        return n * e.scalar;
+    case LazyExpr::Kind::Range:
+        return n * e.scalar + e.step * n * (n - 1) / 2;
+    case LazyExpr::Kind::Binary: {
+        const LazyExpr& a = *e.lhs;
+        const LazyExpr& b = *e.rhs;
+        auto sized = [&](const LazyExpr& x) -> std::optional<double> {
+            if (x.kind == LazyExpr::Kind::Scalar) return n * x.scalar;
+            if (x.size != e.size) return std::nullopt;
+            return closed_sum(x);
+        };
+        if (e.op == ElemOp::Add || e.op == ElemOp::Sub) {
+            auto sa = sized(a), sb = sized(b);
+            if (!sa || !sb) return std::nullopt;
+            return e.op == ElemOp::Add ? *sa + *sb : *sa - *sb;
+        }
+        if (e.op == ElemOp::Mul && a.kind == LazyExpr::Kind::Scalar) {
+            if (auto sb = sized(b)) return a.scalar * *sb;
+        }
+        if ((e.op == ElemOp::Mul || e.op == ElemOp::Div) && b.kind == LazyExpr::Kind::Scalar) {
+            if (auto sa = sized(a)) return e.op == ElemOp::Mul ? *sa * b.scalar : *sa / b.scalar;
+        }
+        return std::nullopt;
+    }
+    default:
+        return std::nullopt;
+    }
+}
+
+} // namespace
+
+std::shared_ptr<const LazyExpr> make_view(const double* data, size_t count, std::shared_ptr<const void> owner) {
+    auto e = std::make_shared<LazyExpr>();
+    e->kind = LazyExpr::Kind::View;
+    e->view = data;
+    e->owner = std::move(owner);
+    e->size = count;
+    return e;
+}
+
+std::shared_ptr<const LazyExpr> make_range(double first, double step, size_t count) {
+    auto e = std::make_shared<LazyExpr>();
+    e->kind = LazyExpr::Kind::Range;
+    e->scalar = first;
+    e->step = step;
+    e->size = count;
+    return e;
+}
+
+std::shared_ptr<const LazyExpr> make_repeat(double value, size_t count) {
+    auto e = std::make_shared<LazyExpr>();
+    e->kind = LazyExpr::Kind::Scalar;
+    e->scalar = value;
+    e->size = count;
+    return e;
+}
+
+std::shared_ptr<const LazyExpr> make_take(const WofValue& v, size_t count) {
+    count = std::min(count, array_size(v));
+    if (v.lazy && v.lazy->kind == LazyExpr::Kind::Range) {
+        return make_range(v.lazy->scalar, v.lazy->step, count);
+    }
+    if (v.lazy && v.lazy->kind == LazyExpr::Kind::Scalar) return make_repeat(v.lazy->scalar, count);
+    auto e = std::make_shared<LazyExpr>();
+    e->kind = LazyExpr::Kind::Take;
+    e->lhs = leaf(v);
+    e->size = count;
+    e->nodes = e->lhs->nodes + 1;
+    return e;
+}
+
+std::shared_ptr<const LazyExpr> make_zip(const WofValue& a, const WofValue& b) {
+    auto e = std::make_shared<LazyExpr>();
+    e->kind = LazyExpr::Kind::Zip;
+    e->lhs = leaf(a);
+    e->rhs = leaf(b);
+    size_t pairs = std::min(e->lhs->size, e->rhs->size);
+    e->size = pairs == kUnbounded ? kUnbounded : 2 * pairs;
+    e->nodes = e->lhs->nodes + e->rhs->nodes + 1;
+    return e;
+}
+
+std::shared_ptr<const WofArray> materialize(const LazyExpr& expr) {
+    if (expr.kind == LazyExpr::Kind::Array) return expr.data;
+    if (expr.size == kUnbounded) {
+        throw std::runtime_error("unbounded sequence; use take to bound it first");
+    }
+    std::call_once(expr.once, [&] {
+        auto out = std::make_shared<WofArray>();
+        out->reserve(expr.size);
+        stream(expr, [&](std::span<const double> c) { out->insert(out->end(), c.begin(), c.end()); });
+        expr.result = std::move(out);
+    });
+    return expr.result;
+}
+
+size_t array_size(const WofValue& v) {
+    if (v.lazy) return v.lazy->size;
+    return v.arr ? v.arr->size() : 0;
+}
+
+void for_each_chunk(const WofValue& v, const std::function<void(std::span<const double>)>& chunk) {
+    if (v.lazy) {
+        stream(*v.lazy, chunk);
+    } else if (v.arr) {
+        chunk(*v.arr);
+    }
+}
+
+WofArray head(const WofValue& v, size_t n) {
+    if (!v.lazy) {
+        if (!v.arr) return {};
+        return WofArray(v.arr->begin(), v.arr->begin() + std::min(n, v.arr->size()));
+    }
+    n = std::min({n, v.lazy->size, kBlock});
+    auto cursor = open(*v.lazy);
+    auto chunk = cursor->next(n);
+    return WofArray(chunk.begin(), chunk.end());
+}
+
+double reduce_sum(const WofValue& v) {
+    if (v.lazy && !v.lazy->result) {
+        if (auto s = closed_sum(*v.lazy)) return *s;
+    }
+    double sum = 0.0;
+    for_each_chunk(v, [&](std::span<const double> c) {
+        for (double x : c) sum += x;
+    });
+    return sum;
+}
+
+double reduce_product(const WofValue& v) {
+    double product = 1.0;
+    for_each_chunk(v, [&](std::span<const double> c) {
+        for (double x : c) product *= x;
+    });
+    return product;
+}
+
+double reduce_max(const WofValue& v) {
+    double best = -std::numeric_limits<double>::infinity();
+    for_each_chunk(v, [&](std::span<const double> c) {
+        for (double x : c) best = std::max(best, x);
+    });
+    return best;
+}
+
+double reduce_min(const WofValue& v) {
+    double best = std::numeric_limits<double>::infinity();
+    for_each_chunk(v, [&](std::span<const double> c) {
+        for (double x : c) best = std::min(best, x);
+    });
+    return best;
+}
+
+bool fuse_unary(std::stack<WofValue>& st, ElemOp op) {
+    if (st.empty() || !st.top().is_array()) return false;
+    auto e = std::make_shared<LazyExpr>();
+    e->kind = LazyExpr::Kind::Unary;
+    e->op = op;
+    e->lhs = leaf(st.top());
+    e->size = e->lhs->size;
+    e->nodes = e->lhs->nodes + 1;
+    st.pop();
+    st.push(wrap(std::move(e)));
+    return true;
+}
+
+bool fuse_binary(std::stack<WofValue>& st, ElemOp op) {
+    if (st.size() < 2 || !is_binary(op)) return false;
+    WofValue b = st.top();
+    st.pop();
+    if (!b.is_array() && !st.top().is_array()) {
+        st.push(std::move(b));
+        return false;
+    }
+    WofValue a = st.top();
+    auto e = std::make_shared<LazyExpr>();
+    e->kind = LazyExpr::Kind::Binary;
+    e->op = op;
+    e->lhs = leaf(a);
+    e->rhs = leaf(b);
+    // Scalars and unbounded sequences adapt to the other operand's length.
+    size_t sa = e->lhs->size, sb = e->rhs->size;
+    if (sa != kUnbounded && sb != kUnbounded && sa != sb) {
+        st.push(std::move(b));
+        throw std::runtime_error("array length mismatch: " + std::to_string(sa) + " vs " +
+                                 std::to_string(sb));
+    }
+    st.pop();
+    e->size = std::min(sa, sb);
+    e->nodes = e->lhs->nodes + e->rhs->nodes + 1;
+    st.push(wrap(std::move(e)));
+    return true;
+}
+
+} // namespace woflang
@@ -0,0 +1,93 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stack>
+#include <vector>
+
+namespace woflang {
+
+using WofArray = std::vector<double>;
+struct WofValue;
+
+// Elementwise operations that can be deferred when an operand is an array.
+enum class ElemOp : uint8_t {
+    // binary
+    Add, Sub, Mul, Div, Mod, Pow, Min, Max, Atan2,
+    // unary
+    Sqrt, Cbrt, Exp, Ln, Log10, Log2, Abs, Floor, Ceil, Round, Trunc, Sign,
+    Sin, Cos, Tan, Asin, Acos, Atan, Sinh, Cosh, Tanh, Deg2Rad, Rad2Deg,
+};
+
+// Length of sequences with no end (`x repeat`); only prefixes of these can
+// be materialized.
+inline constexpr size_t kUnbounded = std::numeric_limits<size_t>::max();
+
+// Node of a deferred array: a stored array, a view of doubles owned
+// elsewhere (e.g. a mapped file), a generator (range, repeated value) or an
+// elementwise/zip/take expression over other nodes.
+// Arithmetic on arrays builds these instead of allocating a result per op.
+// Values are produced on demand in L1-sized chunks, so consumers such as
+// sums stream a million-element range in constant memory, and
+// materialize() evaluates a whole expression in one pass.
+//
+// Out-of-domain inputs follow IEEE rules (NaN/inf) rather than throwing,
+// since one bad element should not abort a million-element expression.
+struct LazyExpr {
+    enum class Kind : uint8_t { Array, View, Scalar, Range, Unary, Binary, Take, Zip };
+
+    Kind kind = Kind::Array;
+    ElemOp op = ElemOp::Add;
+    size_t size = 0;    // elements produced, or kUnbounded
+    size_t nodes = 1;   // nodes in this subtree, bounds DAG growth
+    std::shared_ptr<const WofArray> data;
+    double scalar = 0.0;  // Scalar: the value; Range: first element
+    double step = 0.0;    // Range: increment
+    std::shared_ptr<const LazyExpr> lhs, rhs;
+    const double* view = nullptr;       // View: the elements
+    std::shared_ptr<const void> owner;  // View: keeps them alive
+
+    // Result, filled by the first materialize() so re-reading a value
+    // (e.g. after dup) does not evaluate it again.
+    mutable std::once_flag once;
+    mutable std::shared_ptr<const WofArray> result;
+};
+
+// Streams read the elements in place; materialize() copies them once.
+std::shared_ptr<const LazyExpr> make_view(const double* data, size_t count, std::shared_ptr<const void> owner);
+std::shared_ptr<const LazyExpr> make_range(double first, double step, size_t count);
+std::shared_ptr<const LazyExpr> make_repeat(double value, size_t count = kUnbounded);
+std::shared_ptr<const LazyExpr> make_take(const WofValue& v, size_t count);
+std::shared_ptr<const LazyExpr> make_zip(const WofValue& a, const WofValue& b);
+
+// Throws for unbounded sequences.
+std::shared_ptr<const WofArray> materialize(const LazyExpr& expr);
+
+// Length of an array value (stored or deferred).
+size_t array_size(const WofValue& v);
+
+// Call `chunk` with consecutive runs of the elements of an array value,
+// without materializing deferred ones. Throws for unbounded sequences.
+void for_each_chunk(const WofValue& v, const std::function<void(std::span<const double>)>& chunk);
+
+// First min(n, size) elements, for display.
+WofArray head(const WofValue& v, size_t n);
+
+// Streaming reductions; sums of ranges and repeats (and of those shifted or
+// scaled by constants) use the closed form instead of visiting elements.
+double reduce_sum(const WofValue& v);
+double reduce_product(const WofValue& v);
+double reduce_max(const WofValue& v);
+double reduce_min(const WofValue& v);
+
+// Record `op` on the top one/two stack values if any operand is an array
+// and return true; return false (stack untouched) for plain scalars, so the
+// caller falls through to its scalar code.
+bool fuse_unary(std::stack<WofValue>& st, ElemOp op);
+bool fuse_binary(std::stack<WofValue>& st, ElemOp op);
+
+} // namespace woflang
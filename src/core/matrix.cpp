@@ -0,0 +1,459 @@
+#include "matrix.hpp"
+#include "thread_pool.hpp"
+#include "woflang.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define WOFLANG_AVX2_GEMM 1
+#endif
+
+namespace woflang {
+
+namespace {
+
+constexpr size_t MR = 6;     // micro-tile rows: 6 x 2 accumulators of 4 doubles
+constexpr size_t NR = 8;     // micro-tile columns
+constexpr size_t KC = 256;   // depth of a packed panel; a B sliver is 16 KB
+constexpr size_t MC = 96;    // rows of a packed A block (~192 KB)
+constexpr size_t NC = 2048;  // columns of a packed B panel (~4 MB)
+constexpr size_t kParallelFlops = size_t(1) << 21;  // m * n * k below this stays on one thread
+constexpr size_t kTile = 32;
+
+// C[0..MR, 0..NR) (row stride ldc) += packed A sliver * packed B sliver.
+using MicroKernel = void (*)(size_t kc, const double* a, const double* b, double* c, size_t ldc);
+
+void kernel_portable(size_t kc, const double* a, const double* b, double* c, size_t ldc) {
+    double acc[MR][NR] = {};
+    for (size_t p = 0; p < kc; ++p, a += MR, b += NR) {
+        for (size_t r = 0; r < MR; ++r) {
+            for (size_t j = 0; j < NR; ++j) acc[r][j] += a[r] * b[j];
+        }
+    }
+    for (size_t r = 0; r < MR; ++r) {
+        for (size_t j = 0; j < NR; ++j) c[r * ldc + j] += acc[r][j];
+    }
+}
+
+#ifdef WOFLANG_AVX2_GEMM
+__attribute__((target("avx2,fma"))) void kernel_avx2(size_t kc, const double* a, const double* b, double* c,
+                                                     size_t ldc) {
+    __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+    __m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+    __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+    __m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+    __m256d c40 = _mm256_setzero_pd(), c41 = _mm256_setzero_pd();
+    __m256d c50 = _mm256_setzero_pd(), c51 = _mm256_setzero_pd();
+    for (size_t p = 0; p < kc; ++p, a += MR, b += NR) {
+        __m256d b0 = _mm256_loadu_pd(b);
+        __m256d b1 = _mm256_loadu_pd(b + 4);
+        __m256d ai = _mm256_broadcast_sd(a);
+        c00 = _mm256_fmadd_pd(ai, b0, c00);
+        c01 = _mm256_fmadd_pd(ai, b1, c01);
+        ai = _mm256_broadcast_sd(a + 1);
+        c10 = _mm256_fmadd_pd(ai, b0, c10);
+        c11 = _mm256_fmadd_pd(ai, b1, c11);
+        ai = _mm256_broadcast_sd(a + 2);
+        c20 = _mm256_fmadd_pd(ai, b0, c20);
+        c21 = _mm256_fmadd_pd(ai, b1, c21);
+        ai = _mm256_broadcast_sd(a + 3);
+        c30 = _mm256_fmadd_pd(ai, b0, c30);
+        c31 = _mm256_fmadd_pd(ai, b1, c31);
+        ai = _mm256_broadcast_sd(a + 4);
+        c40 = _mm256_fmadd_pd(ai, b0, c40);
+        c41 = _mm256_fmadd_pd(ai, b1, c41);
+        ai = _mm256_broadcast_sd(a + 5);
+        c50 = _mm256_fmadd_pd(ai, b0, c50);
+        c51 = _mm256_fmadd_pd(ai, b1, c51);
+    }
+    __m256d acc[MR][2] = {{c00, c01}, {c10, c11}, {c20, c21}, {c30, c31}, {c40, c41}, {c50, c51}};
+    for (size_t r = 0; r < MR; ++r) {
+        double* row = c + r * ldc;
+        _mm256_storeu_pd(row, _mm256_add_pd(_mm256_loadu_pd(row), acc[r][0]));
+        _mm256_storeu_pd(row + 4, _mm256_add_pd(_mm256_loadu_pd(row + 4), acc[r][1]));
+    }
+}
+#endif
+
+MicroKernel micro_kernel() {
+#ifdef WOFLANG_AVX2_GEMM
+    static const bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    if (avx2) return kernel_avx2;
+#endif
+    return kernel_portable;
+}
+
+// mc x kc block of A (row stride lda) into MR-tall slivers, zero-padded.
+void pack_a(size_t mc, size_t kc, const double* a, size_t lda, double* out) {
+    for (size_t i0 = 0; i0 < mc; i0 += MR) {
+        for (size_t p = 0; p < kc; ++p) {
+            for (size_t r = 0; r < MR; ++r) *out++ = i0 + r < mc ? a[(i0 + r) * lda + p] : 0.0;
+        }
+    }
+}
+
+// kc x nc panel of B (row stride ldb) into NR-wide slivers, zero-padded.
+void pack_b(size_t kc, size_t nc, const double* b, size_t ldb, double* out) {
+    for (size_t j0 = 0; j0 < nc; j0 += NR) {
+        size_t w = std::min(NR, nc - j0);
+        for (size_t p = 0; p < kc; ++p) {
+            const double* row = b + p * ldb + j0;
+            for (size_t j = 0; j < NR; ++j) *out++ = j < w ? row[j] : 0.0;
+        }
+    }
+}
+
+// C block (mc x nc, row stride ldc) += packed A block * packed B panel.
+void macro_kernel(MicroKernel kernel, size_t mc, size_t nc, size_t kc, const double* a, const double* b,
+                  double* c, size_t ldc) {
+    for (size_t j0 = 0; j0 < nc; j0 += NR) {
+        size_t w = std::min(NR, nc - j0);
+        const double* bs = b + j0 * kc;
+        for (size_t i0 = 0; i0 < mc; i0 += MR) {
+            size_t h = std::min(MR, mc - i0);
+            const double* as = a + i0 * kc;
+            double* ct = c + i0 * ldc + j0;
+            if (h == MR && w == NR) {
+                kernel(kc, as, bs, ct, ldc);
+                continue;
+            }
+            double edge[MR * NR] = {};
+            kernel(kc, as, bs, edge, NR);
+            for (size_t r = 0; r < h; ++r) {
+                for (size_t j = 0; j < w; ++j) ct[r * ldc + j] += edge[r * NR + j];
+            }
+        }
+    }
+}
+
+} // namespace
+
+void gemm(size_t m, size_t n, size_t k, const double* a, const double* b, double* c) {
+    std::fill(c, c + m * n, 0.0);
+    if (m == 0 || n == 0 || k == 0) return;
+    MicroKernel kernel = micro_kernel();
+    ThreadPool& pool = ThreadPool::shared();
+    bool parallel = pool.size() > 1 && m * n * k >= kParallelFlops;
+    // Enough row blocks to keep every worker busy, in whole micro-tiles.
+    size_t mc_block = MC;
+    if (parallel) mc_block = std::clamp((m + pool.size() - 1) / pool.size() / MR * MR, MR, MC);
+    size_t blocks = (m + mc_block - 1) / mc_block;
+
+    std::vector<double> packed_b(std::min(KC, k) * ((std::min(NC, n) + NR - 1) / NR * NR));
+    for (size_t jc = 0; jc < n; jc += NC) {
+        size_t nc = std::min(NC, n - jc);
+        for (size_t pc = 0; pc < k; pc += KC) {
+            size_t kc = std::min(KC, k - pc);
+            pack_b(kc, nc, b + pc * n + jc, n, packed_b.data());
+            auto block = [&](size_t blk) {
+                thread_local std::vector<double> packed_a;
+                size_t ic = blk * mc_block;
+                size_t mc = std::min(mc_block, m - ic);
+                packed_a.resize(MC * KC);
+                pack_a(mc, kc, a + ic * k + pc, k, packed_a.data());
+                macro_kernel(kernel, mc, nc, kc, packed_a.data(), packed_b.data(), c + ic * n + jc, n);
+            };
+            if (parallel && blocks > 1) {
+                pool.parallel_for(blocks, block);
+            } else {
+                for (size_t blk = 0; blk < blocks; ++blk) block(blk);
+            }
+        }
+    }
+}
+
+void transpose(size_t rows, size_t cols, const double* a, double* at) {
+    for (size_t i0 = 0; i0 < rows; i0 += kTile) {
+        for (size_t j0 = 0; j0 < cols; j0 += kTile) {
+            size_t i1 = std::min(rows, i0 + kTile);
+            size_t j1 = std::min(cols, j0 + kTile);
+            for (size_t i = i0; i < i1; ++i) {
+                for (size_t j = j0; j < j1; ++j) at[j * rows + i] = a[i * cols + j];
+            }
+        }
+    }
+}
+
+int lu_factor(size_t n, double* a, std::vector<size_t>& perm) {
+    perm.resize(n);
+    for (size_t i = 0; i < n; ++i) perm[i] = i;
+    ThreadPool& pool = ThreadPool::shared();
+    int sign = 1;
+    for (size_t j = 0; j < n; ++j) {
+        size_t pivot = j;
+        for (size_t i = j + 1; i < n; ++i) {
+            if (std::abs(a[i * n + j]) > std::abs(a[pivot * n + j])) pivot = i;
+        }
+        if (a[pivot * n + j] == 0.0) return 0;
+        if (pivot != j) {
+            std::swap_ranges(a + j * n, a + (j + 1) * n, a + pivot * n);
+            std::swap(perm[j], perm[pivot]);
+            sign = -sign;
+        }
+        const double* top = a + j * n;
+        size_t below = n - j - 1;
+        // Rank-one update of the trailing rows, a band of rows per job.
+        auto update = [&](size_t band) {
+            size_t i1 = std::min(n, j + 1 + (band + 1) * kTile);
+            for (size_t i = j + 1 + band * kTile; i < i1; ++i) {
+                double* row = a + i * n;
+                double l = row[j] /= top[j];
+                for (size_t c = j + 1; c < n; ++c) row[c] -= l * top[c];
+            }
+        };
+        size_t bands = (below + kTile - 1) / kTile;
+        if (pool.size() > 1 && bands > 1 && below * below >= kParallelFlops / kTile) {
+            pool.parallel_for(bands, update);
+        } else {
+            for (size_t band = 0; band < bands; ++band) update(band);
+        }
+    }
+    return sign;
+}
+
+void lu_solve(size_t n, const double* lu, const std::vector<size_t>& perm, size_t nrhs, double* b) {
+    std::vector<double> x(n * nrhs);
+    for (size_t i = 0; i < n; ++i) std::copy_n(b + perm[i] * nrhs, nrhs, x.data() + i * nrhs);
+    // L y = P b, then U x = y, a row of right-hand sides at a time.
+    for (size_t i = 0; i < n; ++i) {
+        double* xi = x.data() + i * nrhs;
+        for (size_t j = 0; j < i; ++j) {
+            double l = lu[i * n + j];
+            const double* xj = x.data() + j * nrhs;
+            for (size_t c = 0; c < nrhs; ++c) xi[c] -= l * xj[c];
+        }
+    }
+    for (size_t i = n; i-- > 0;) {
+        double* xi = x.data() + i * nrhs;
+        for (size_t j = i + 1; j < n; ++j) {
+            double u = lu[i * n + j];
+            const double* xj = x.data() + j * nrhs;
+            for (size_t c = 0; c < nrhs; ++c) xi[c] -= u * xj[c];
+        }
+        double d = lu[i * n + i];
+        for (size_t c = 0; c < nrhs; ++c) xi[c] /= d;
+    }
+    std::copy(x.begin(), x.end(), b);
+}
+
+namespace {
+
+// Elements and shape of a matrix argument.
+struct Dense {
+    std::shared_ptr<const WofArray> values;
+    size_t rows = 0;
+    size_t cols = 0;
+
+    const double* data() const { return values->data(); }
+};
+
+Dense dense(const WofValue& v) {
+    Dense m;
+    m.values = v.array();
+    m.cols = v.cols;
+    m.rows = m.values->size() / m.cols;
+    return m;
+}
+
+// Ops read their matrices in place and pop only once the result is ready,
+// so a bad shape or a singular matrix leaves the stack as it was.
+Dense matrix_arg(const WofValue& v, const char* op) {
+    if (!v.is_matrix()) throw std::runtime_error(std::string(op) + ": expects a matrix");
+    return dense(v);
+}
+
+Dense square_arg(const WofValue& v, const char* op) {
+    Dense m = matrix_arg(v, op);
+    if (m.rows != m.cols) throw std::runtime_error(std::string(op) + ": expects a square matrix");
+    return m;
+}
+
+uint32_t checked_cols(size_t cols, const char* op) {
+    if (cols == 0 || cols > std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error(std::string(op) + ": bad column count");
+    }
+    return static_cast<uint32_t>(cols);
+}
+
+// Factors of a square matrix; throws if it is singular.
+struct Factors {
+    WofArray lu;
+    std::vector<size_t> perm;
+};
+
+Factors factor(const Dense& a, const char* op) {
+    Factors f{WofArray(a.values->begin(), a.values->end()), {}};
+    if (lu_factor(a.rows, f.lu.data(), f.perm) == 0) {
+        throw std::runtime_error(std::string(op) + ": matrix is singular");
+    }
+    return f;
+}
+
+} // namespace
+
+void WoflangInterpreter::register_matrix_ops() {
+    // Matrices are arrays with a shape (see WofValue::cols); vectors are
+    // plain arrays and act as columns.
+
+    // arr rows cols matrix  ->  M
+    register_op("matrix", [](std::stack<WofValue>& st) {
+        WofValue counts[2];  // rows cols
+        for (size_t k = 2; k-- > 0;) {
+            counts[k] = std::move(st.top());
+            st.pop();
+        }
+        try {
+            double r = counts[0].as_numeric();
+            double c = counts[1].as_numeric();
+            if (!st.top().is_array() || r < 1 || c < 1 || r != std::floor(r) || c != std::floor(c)) {
+                throw std::runtime_error("matrix: expects an array and positive row and column counts");
+            }
+            auto values = st.top().array();
+            if (static_cast<double>(values->size()) != r * c) {
+                throw std::runtime_error("matrix: " + std::to_string(values->size()) + " elements do not fill " +
+                                         std::to_string(static_cast<size_t>(r)) + "x" +
+                                         std::to_string(static_cast<size_t>(c)));
+            }
+            WofValue m = st.top();
+            m.arr = std::move(values);
+            m.lazy.reset();
+            m.cols = checked_cols(static_cast<size_t>(c), "matrix");
+            st.pop();
+            st.push(std::move(m));
+        } catch (...) {
+            for (auto& v : counts) st.push(std::move(v));
+            throw;
+        }
+    }, {3, 1});
+
+    // n identity  ->  I
+    register_op("identity", [](std::stack<WofValue>& st) {
+        double n = st.top().as_numeric();
+        if (st.top().is_array() || n < 1 || n != std::floor(n)) {
+            throw std::runtime_error("identity: expects a positive size");
+        }
+        st.pop();
+        size_t size = static_cast<size_t>(n);
+        WofArray values(size * size, 0.0);
+        for (size_t i = 0; i < size; ++i) values[i * size + i] = 1.0;
+        st.push(WofValue::make_matrix(std::move(values), checked_cols(size, "identity")));
+    }, {1, 1});
+
+    // M shape  ->  rows cols
+    register_op("shape", [](std::stack<WofValue>& st) {
+        Dense m = matrix_arg(st.top(), "shape");
+        st.pop();
+        st.push(WofValue::make_int(static_cast<int64_t>(m.rows)));
+        st.push(WofValue::make_int(static_cast<int64_t>(m.cols)));
+    }, {1, 2});
+
+    // A B matmul  ->  A*B   (an array B is a column; the result is an array)
+    register_op("matmul", [](std::stack<WofValue>& st) {
+        WofValue rhs = std::move(st.top());
+        st.pop();
+        try {
+            if (!rhs.is_array()) throw std::runtime_error("matmul: expects a matrix or vector on top");
+            Dense a = matrix_arg(st.top(), "matmul");
+            Dense b;
+            if (rhs.is_matrix()) {
+                b = dense(rhs);
+            } else {
+                b.values = rhs.array();
+                b.rows = b.values->size();
+                b.cols = 1;
+            }
+            if (a.cols != b.rows) {
+                throw std::runtime_error("matmul: " + std::to_string(a.rows) + "x" + std::to_string(a.cols) +
+                                         " times " + std::to_string(b.rows) + "x" + std::to_string(b.cols));
+            }
+            WofArray c(a.rows * b.cols);
+            gemm(a.rows, b.cols, a.cols, a.data(), b.data(), c.data());
+            st.pop();
+            st.push(rhs.is_matrix() ? WofValue::make_matrix(std::move(c), rhs.cols)
+                                    : WofValue::make_array(std::move(c)));
+        } catch (...) {
+            st.push(std::move(rhs));
+            throw;
+        }
+    }, {2, 1});
+
+    // A transpose  ->  Aᵀ
+    register_op("transpose", [](std::stack<WofValue>& st) {
+        Dense a = matrix_arg(st.top(), "transpose");
+        WofArray t(a.values->size());
+        transpose(a.rows, a.cols, a.data(), t.data());
+        st.pop();
+        st.push(WofValue::make_matrix(std::move(t), checked_cols(a.rows, "transpose")));
+    }, {1, 1});
+
+    // A lu  ->  L U P   with P A = L U
+    register_op("lu", [](std::stack<WofValue>& st) {
+        Dense a = square_arg(st.top(), "lu");
+        size_t n = a.rows;
+        Factors f = factor(a, "lu");
+        WofArray l(n * n, 0.0), u(n * n, 0.0), p(n * n, 0.0);
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < n; ++j) (j < i ? l : u)[i * n + j] = f.lu[i * n + j];
+            l[i * n + i] = 1.0;
+            p[i * n + f.perm[i]] = 1.0;
+        }
+        uint32_t cols = checked_cols(n, "lu");
+        st.pop();
+        st.push(WofValue::make_matrix(std::move(l), cols));
+        st.push(WofValue::make_matrix(std::move(u), cols));
+        st.push(WofValue::make_matrix(std::move(p), cols));
+    }, {1, 3});
+
+    // A b solve  ->  x   with A x = b   (b an array, or a matrix of columns)
+    register_op("solve", [](std::stack<WofValue>& st) {
+        WofValue rhs = std::move(st.top());
+        st.pop();
+        try {
+            if (!rhs.is_array()) throw std::runtime_error("solve: expects a matrix or vector on top");
+            Dense a = square_arg(st.top(), "solve");
+            auto values = rhs.array();
+            size_t nrhs = rhs.is_matrix() ? rhs.cols : 1;
+            if (values->size() != a.rows * nrhs) {
+                throw std::runtime_error("solve: right-hand side does not have " + std::to_string(a.rows) +
+                                         " rows");
+            }
+            Factors f = factor(a, "solve");
+            WofArray x(values->begin(), values->end());
+            lu_solve(a.rows, f.lu.data(), f.perm, nrhs, x.data());
+            st.pop();
+            st.push(rhs.is_matrix() ? WofValue::make_matrix(std::move(x), rhs.cols)
+                                    : WofValue::make_array(std::move(x)));
+        } catch (...) {
+            st.push(std::move(rhs));
+            throw;
+        }
+    }, {2, 1});
+
+    // A inv  ->  A⁻¹
+    register_op("inv", [](std::stack<WofValue>& st) {
+        Dense a = square_arg(st.top(), "inv");
+        size_t n = a.rows;
+        Factors f = factor(a, "inv");
+        WofArray x(n * n, 0.0);
+        for (size_t i = 0; i < n; ++i) x[i * n + i] = 1.0;
+        lu_solve(n, f.lu.data(), f.perm, n, x.data());
+        st.pop();
+        st.push(WofValue::make_matrix(std::move(x), checked_cols(n, "inv")));
+    }, {1, 1});
+
+    // A det  ->  det(A)
+    register_op("det", [](std::stack<WofValue>& st) {
+        Dense a = square_arg(st.top(), "det");
+        size_t n = a.rows;
+        WofArray lu(a.values->begin(), a.values->end());
+        std::vector<size_t> perm;
+        double det = lu_factor(n, lu.data(), perm);
+        for (size_t i = 0; i < n && det != 0.0; ++i) det *= lu[i * n + i];
+        st.pop();
+        st.push(WofValue(det));
+    }, {1, 1});
+}
+
+} // namespace woflang
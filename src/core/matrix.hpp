@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace woflang {
+
+// Dense kernels behind the matrix ops. Matrices are row-major doubles.
+//
+// gemm follows the usual packed layout: B is packed a KC x NC panel at a
+// time into NR-wide slivers, A an MC x KC block at a time into MR-tall
+// slivers, and an MR x NR micro-kernel accumulates one tile of C in
+// registers. The panels are sized for L2 and the slivers for L1. MC blocks
+// run in parallel on the shared thread pool once the product is large
+// enough to pay for it. The micro-kernel uses AVX2/FMA when the CPU has
+// them and a portable loop otherwise.
+
+// C (m x n) = A (m x k) * B (k x n).
+void gemm(size_t m, size_t n, size_t k, const double* a, const double* b, double* c);
+
+// at (cols x rows) = a (rows x cols) transposed, in cache-sized tiles.
+void transpose(size_t rows, size_t cols, const double* a, double* at);
+
+// LU factorization with partial pivoting, in place on the n x n matrix `a`:
+// afterwards its strict lower triangle is L (with a unit diagonal), its
+// upper triangle is U, and row i of P A is row perm[i] of A. Returns the
+// sign of the permutation, or 0 if a pivot is zero (A is singular).
+int lu_factor(size_t n, double* a, std::vector<size_t>& perm);
+
+// Overwrites b (n x nrhs) with the solution X of A X = B, given the factors
+// from lu_factor.
+void lu_solve(size_t n, const double* lu, const std::vector<size_t>& perm, size_t nrhs, double* b);
+
+} // namespace woflang
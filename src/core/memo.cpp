@@ -0,0 +1,154 @@
+#include "memo.hpp"
+#include "woflang.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace woflang {
+
+struct MemoCache::Entry {
+    uint64_t hash;
+    uint32_t op;
+    std::vector<WofValue> args;
+    std::vector<WofValue> results;
+};
+
+struct MemoCache::Shard {
+    std::mutex mutex;
+    std::list<Entry> lru;  // most recently used first
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+};
+
+namespace {
+bool same_value(const WofValue& a, const WofValue& b) {
+    // Bitwise on the double so NaN keys hit and 0.0 / -0.0 stay distinct.
+    return a.i == b.i && std::memcmp(&a.d, &b.d, sizeof(double)) == 0 && a.is_string() == b.is_string() &&
+           a.s == b.s;
+}
+
+bool same_args(std::span<const WofValue> a, std::span<const WofValue> b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), same_value);
+}
+}
+
+MemoCache::MemoCache(size_t capacity, size_t shards) : ops_(new Op[kMaxOps]) {
+    shards = std::max<size_t>(shards, 1);
+    for (size_t k = 0; k < shards; ++k) shards_.push_back(std::make_unique<Shard>());
+    shard_capacity_ = std::max<size_t>(capacity / shards, 1);
+}
+
+MemoCache::~MemoCache() = default;
+
+uint32_t MemoCache::add_op(const std::string& name, size_t arity, bool* added) {
+    std::lock_guard<std::mutex> lock(ops_mutex_);
+    for (size_t k = 0; k < op_count_; ++k) {
+        if (ops_[k].name == name) {
+            if (added) *added = false;
+            return static_cast<uint32_t>(k);
+        }
+    }
+    if (op_count_ == kMaxOps) throw std::runtime_error("too many memoized ops");
+    ops_[op_count_].name = name;
+    ops_[op_count_].arity = arity;
+    if (added) *added = true;
+    return static_cast<uint32_t>(op_count_++);
+}
+
+bool MemoCache::cacheable(std::span<const WofValue> args) {
+    return std::none_of(args.begin(), args.end(), [](const WofValue& v) {
+        return v.is_array() || v.is_quotation();
+    });
+}
+
+uint64_t MemoCache::hash_key(uint32_t op, std::span<const WofValue> args) {
+    uint64_t h = fnv1a(std::string_view(reinterpret_cast<const char*>(&op), sizeof(op)));
+    for (const auto& v : args) {
+        h = fnv1a(std::string_view(reinterpret_cast<const char*>(&v.i), sizeof(v.i)), h);
+        h = fnv1a(std::string_view(reinterpret_cast<const char*>(&v.d), sizeof(v.d)), h);
+        h = fnv1a(v.is_string() ? std::string_view("s", 1) : std::string_view("n", 1), h);
+        h = fnv1a(v.s, h);
+    }
+    return h;
+}
+
+bool MemoCache::lookup(uint32_t op, std::span<const WofValue> args, std::vector<WofValue>& results) {
+    uint64_t h = hash_key(op, args);
+    Shard& shard = shard_for(h);
+    bool hit = false;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(h);
+        if (it != shard.index.end() && it->second->op == op && same_args(it->second->args, args)) {
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+            results = it->second->results;
+            hit = true;
+        }
+    }
+    Op& stats = ops_[op];
+    (hit ? stats.hits : stats.misses).fetch_add(1, std::memory_order_relaxed);
+    return hit;
+}
+
+void MemoCache::insert(uint32_t op, std::span<const WofValue> args, std::vector<WofValue> results) {
+    uint64_t h = hash_key(op, args);
+    Shard& shard = shard_for(h);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (auto it = shard.index.find(h); it != shard.index.end()) {
+        // Same key computed concurrently, or a hash collision: newest wins.
+        shard.lru.erase(it->second);
+        shard.index.erase(it);
+    }
+    shard.lru.push_front({h, op, {args.begin(), args.end()}, std::move(results)});
+    shard.index[h] = shard.lru.begin();
+    while (shard.lru.size() > shard_capacity_) {
+        shard.index.erase(shard.lru.back().hash);
+        shard.lru.pop_back();
+        evictions_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void MemoCache::clear() {
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->lru.clear();
+        shard->index.clear();
+    }
+    std::lock_guard<std::mutex> lock(ops_mutex_);
+    for (size_t k = 0; k < op_count_; ++k) {
+        ops_[k].hits = 0;
+        ops_[k].misses = 0;
+    }
+    evictions_ = 0;
+}
+
+void MemoCache::set_capacity(size_t entries) {
+    shard_capacity_ = std::max<size_t>(entries / shards_.size(), 1);
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        while (shard->lru.size() > shard_capacity_) {
+            shard->index.erase(shard->lru.back().hash);
+            shard->lru.pop_back();
+        }
+    }
+}
+
+size_t MemoCache::size() const {
+    size_t n = 0;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        n += shard->lru.size();
+    }
+    return n;
+}
+
+std::vector<MemoCache::OpStats> MemoCache::stats() const {
+    std::lock_guard<std::mutex> lock(ops_mutex_);
+    std::vector<OpStats> out;
+    for (size_t k = 0; k < op_count_; ++k) {
+        const Op& op = ops_[k];
+        out.push_back({op.name, op.arity, op.hits.load(), op.misses.load()});
+    }
+    return out;
+}
+
+} // namespace woflang
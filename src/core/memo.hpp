@@ -0,0 +1,81 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace woflang {
+
+struct WofValue;
+
+// Results of pure ops, keyed by op id and argument values. The capacity is
+// split over independently locked shards so parallel combinators calling the
+// same op from several workers do not serialize on one mutex; each shard
+// evicts its least recently used entry when full.
+class MemoCache {
+public:
+    struct OpStats {
+        std::string name;
+        size_t arity = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+
+    explicit MemoCache(size_t capacity = 65536, size_t shards = 16);
+    ~MemoCache();
+
+    MemoCache(const MemoCache&) = delete;
+    MemoCache& operator=(const MemoCache&) = delete;
+
+    // Id for a memoized op, or its existing id if already registered.
+    // Throws once kMaxOps ops are registered.
+    uint32_t add_op(const std::string& name, size_t arity, bool* added = nullptr);
+
+    // Only plain numbers and strings are used as keys; calls with array or
+    // quotation arguments bypass the cache.
+    static bool cacheable(std::span<const WofValue> args);
+
+    bool lookup(uint32_t op, std::span<const WofValue> args, std::vector<WofValue>& results);
+    void insert(uint32_t op, std::span<const WofValue> args, std::vector<WofValue> results);
+
+    void clear();
+    void set_capacity(size_t entries);
+
+    size_t size() const;
+    uint64_t evictions() const { return evictions_.load(std::memory_order_relaxed); }
+    std::vector<OpStats> stats() const;
+
+private:
+    struct Entry;
+    struct Shard;
+    struct Op {
+        std::string name;
+        size_t arity = 0;
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+    };
+
+    static uint64_t hash_key(uint32_t op, std::span<const WofValue> args);
+    Shard& shard_for(uint64_t hash) { return *shards_[hash % shards_.size()]; }
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    size_t shard_capacity_;
+    // Fixed table so workers can index it while another op is being added.
+    static constexpr size_t kMaxOps = 1024;
+    mutable std::mutex ops_mutex_;
+    std::unique_ptr<Op[]> ops_;
+    size_t op_count_ = 0;
+    std::atomic<uint64_t> evictions_{0};
+};
+
+// Signature of the optional `declare_pure_ops` plugin export: the loader
+// passes a callback the plugin calls once per pure op with its arity.
+using PureOpSink = void (*)(void* ctx, const char* name, int arity);
+
+} // namespace woflang
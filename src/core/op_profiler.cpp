@@ -0,0 +1,165 @@
+#include "op_profiler.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace woflang {
+
+namespace {
+
+#ifdef __linux__
+struct EventSpec {
+    OpProfiler::Counter counter;
+    uint32_t type;
+    uint64_t config;
+};
+
+constexpr EventSpec kEvents[] = {
+    {OpProfiler::Counter::Cycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {OpProfiler::Counter::Instructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {OpProfiler::Counter::L1dMisses, PERF_TYPE_HW_CACHE,
+     PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {OpProfiler::Counter::LlcMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {OpProfiler::Counter::BranchMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {OpProfiler::Counter::PageFaults, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+};
+
+int open_event(const EventSpec& e, int group_fd) {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = e.type;
+    attr.config = e.config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, PERF_FLAG_FD_CLOEXEC));
+}
+#endif
+
+} // namespace
+
+OpProfiler::OpProfiler(bool hardware_counters) : owner_(std::this_thread::get_id()) {
+    if (!hardware_counters) return;
+#ifdef __linux__
+    for (const EventSpec& e : kEvents) {
+        int fd = open_event(e, fds_.empty() ? -1 : fds_.front());
+        if (fd < 0) {
+            if (!unavailable_.empty()) unavailable_ += ", ";
+            unavailable_ += std::string(counter_name(e.counter)) + " (" + std::strerror(errno) + ")";
+            continue;
+        }
+        fds_.push_back(fd);
+        counters_.push_back(e.counter);
+    }
+#else
+    unavailable_ = "hardware counters need Linux perf_event";
+#endif
+}
+
+OpProfiler::~OpProfiler() {
+#ifdef __linux__
+    for (int fd : fds_) ::close(fd);
+#endif
+}
+
+const char* OpProfiler::counter_name(Counter c) {
+    switch (c) {
+    case Counter::Cycles: return "cycles";
+    case Counter::Instructions: return "instructions";
+    case Counter::L1dMisses: return "L1d-misses";
+    case Counter::LlcMisses: return "LLC-misses";
+    case Counter::BranchMisses: return "branch-misses";
+    case Counter::PageFaults: return "page-faults";
+    }
+    return "?";
+}
+
+void OpProfiler::read_counters(uint64_t* values) {
+#ifdef __linux__
+    // nr, time enabled, time running, then one value per group member.
+    uint64_t buf[3 + kMaxCounters] = {};
+    if (::read(fds_.front(), buf, sizeof(buf)) < static_cast<ssize_t>(3 * sizeof(uint64_t))) return;
+    if (buf[2] < buf[1]) multiplexed_ = true;
+    std::copy_n(buf + 3, std::min<uint64_t>(buf[0], counters_.size()), values);
+#else
+    (void)values;
+#endif
+}
+
+void OpProfiler::begin(Sample& sample) {
+    std::fill_n(sample.values, kMaxCounters, 0);
+    if (!fds_.empty()) read_counters(sample.values);
+    sample.start = std::chrono::steady_clock::now();
+}
+
+void OpProfiler::end(std::string_view op, const Sample& sample) {
+    auto now = std::chrono::steady_clock::now();
+    uint64_t values[kMaxCounters] = {};
+    if (!fds_.empty()) read_counters(values);
+    auto it = ops_.find(op);
+    if (it == ops_.end()) it = ops_.emplace(std::string(op), OpStats{}).first;
+    OpStats& s = it->second;
+    ++s.calls;
+    s.nanos += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - sample.start).count());
+    for (size_t k = 0; k < counters_.size(); ++k) {
+        if (values[k] >= sample.values[k]) s.counts[k] += values[k] - sample.values[k];
+    }
+}
+
+std::vector<std::pair<std::string, OpProfiler::OpStats>> OpProfiler::sorted() const {
+    std::vector<std::pair<std::string, OpStats>> ops(ops_.begin(), ops_.end());
+    std::sort(ops.begin(), ops.end(), [](const auto& a, const auto& b) { return a.second.nanos > b.second.nanos; });
+    return ops;
+}
+
+void OpProfiler::report(std::ostream& out, size_t max_ops) const {
+    auto ops = sorted();
+    auto find = [&](Counter c) -> int {
+        auto it = std::find(counters_.begin(), counters_.end(), c);
+        return it == counters_.end() ? -1 : static_cast<int>(it - counters_.begin());
+    };
+    int cycles = find(Counter::Cycles);
+    int instructions = find(Counter::Instructions);
+    bool ipc = cycles >= 0 && instructions >= 0;
+
+    auto flags = out.flags();
+    out << std::left << std::setw(20) << "op" << std::right << std::setw(10) << "calls" << std::setw(12) << "total ms"
+        << std::setw(12) << "us/call";
+    if (ipc) out << std::setw(8) << "IPC";
+    for (Counter c : counters_) {
+        if (c == Counter::Cycles || c == Counter::Instructions) continue;
+        out << std::setw(20) << (std::string(counter_name(c)) + "/call");
+    }
+    out << "\n";
+    for (size_t k = 0; k < std::min(max_ops, ops.size()); ++k) {
+        const auto& [name, s] = ops[k];
+        double calls = static_cast<double>(s.calls);
+        out << std::left << std::setw(20) << name << std::right << std::setw(10) << s.calls << std::fixed
+            << std::setprecision(3) << std::setw(12) << static_cast<double>(s.nanos) / 1e6 << std::setw(12)
+            << static_cast<double>(s.nanos) / 1e3 / calls;
+        if (ipc) {
+            out << std::setprecision(2) << std::setw(8)
+                << (s.counts[cycles] ? static_cast<double>(s.counts[instructions]) /
+                                           static_cast<double>(s.counts[cycles])
+                                     : 0.0);
+        }
+        for (size_t c = 0; c < counters_.size(); ++c) {
+            if (counters_[c] == Counter::Cycles || counters_[c] == Counter::Instructions) continue;
+            out << std::setprecision(1) << std::setw(20) << static_cast<double>(s.counts[c]) / calls;
+        }
+        out << "\n";
+    }
+    if (ops.size() > max_ops) out << "(" << ops.size() - max_ops << " more ops)\n";
+    if (!unavailable_.empty()) out << "Counters not available: " << unavailable_ << "\n";
+    if (multiplexed_) out << "Note: the counter group was multiplexed; counts cover only part of the run\n";
+    out.flags(flags);
+}
+
+} // namespace woflang
@@ -0,0 +1,84 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace woflang {
+
+// Per-op profile: calls and wall time for every op dispatched, and
+// optionally hardware counter deltas from a perf_event group (cycles,
+// instructions, L1d read misses, LLC misses, branch misses, page faults)
+// so a slow op can be told apart as compute-, cache- or branch-bound.
+//
+// Times and counts are inclusive: a word's entry covers the ops it runs.
+// Only the thread that created the profiler is measured; ops run by
+// parallel combinators on pool workers count toward the combinator. The
+// counters exclude kernel time, so reading them does not skew the deltas,
+// but each read is a syscall (about 1 us per op dispatched).
+//
+// Counters the kernel or CPU does not provide (no PMU in a VM,
+// perf_event_paranoid too high, non-Linux) are left out; with none, only
+// calls and time are reported.
+class OpProfiler {
+public:
+    enum class Counter { Cycles, Instructions, L1dMisses, LlcMisses, BranchMisses, PageFaults };
+    static constexpr size_t kMaxCounters = 6;
+
+    struct Sample {
+        std::chrono::steady_clock::time_point start;
+        uint64_t values[kMaxCounters];
+    };
+
+    struct OpStats {
+        uint64_t calls = 0;
+        uint64_t nanos = 0;
+        uint64_t counts[kMaxCounters] = {};  // indexed like counters()
+    };
+
+    explicit OpProfiler(bool hardware_counters);
+    ~OpProfiler();
+
+    OpProfiler(const OpProfiler&) = delete;
+    OpProfiler& operator=(const OpProfiler&) = delete;
+
+    bool owns_thread() const { return std::this_thread::get_id() == owner_; }
+
+    void begin(Sample& sample);
+    void end(std::string_view op, const Sample& sample);
+
+    // Counters that opened, in the order of OpStats::counts; why the rest
+    // did not, if any were requested.
+    const std::vector<Counter>& counters() const { return counters_; }
+    const std::string& unavailable() const { return unavailable_; }
+    static const char* counter_name(Counter c);
+
+    // Ops by total time, slowest first.
+    std::vector<std::pair<std::string, OpStats>> sorted() const;
+    void report(std::ostream& out, size_t max_ops = 30) const;
+    void reset() { ops_.clear(); }
+
+private:
+    struct NameHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+    };
+
+    void read_counters(uint64_t* values);
+
+    std::thread::id owner_;
+    std::vector<int> fds_;  // fds_[0] leads the group
+    std::vector<Counter> counters_;
+    std::string unavailable_;
+    bool multiplexed_ = false;
+    std::unordered_map<std::string, OpStats, NameHash, std::equal_to<>> ops_;
+};
+
+} // namespace woflang
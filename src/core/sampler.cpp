@@ -0,0 +1,186 @@
+#include "sampler.hpp"
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace woflang {
+
+namespace {
+// The sampler the SIGPROF handler feeds; at most one at a time.
+std::atomic<SamplingProfiler*> g_active{nullptr};
+#ifdef __linux__
+timer_t g_timer;
+struct sigaction g_previous;
+#endif
+}
+
+SamplingProfiler::SamplingProfiler(unsigned hz) : owner_(std::this_thread::get_id()), slots_(kSlots) {
+#ifdef __linux__
+    if (hz == 0 || hz > 100000) throw std::runtime_error("profile sample: rate must be 1..100000 Hz");
+    SamplingProfiler* expected = nullptr;
+    if (!g_active.compare_exchange_strong(expected, this)) {
+        throw std::runtime_error("profile sample: another sampler is already running");
+    }
+    struct sigaction sa {};
+    sa.sa_handler = &SamplingProfiler::on_signal;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGPROF, &sa, &g_previous);
+
+    // Thread CPU time, delivered to this thread only: idle time (waiting on
+    // input) is not sampled and pool workers are never interrupted.
+    sigevent sev{};
+    sev.sigev_notify = SIGEV_THREAD_ID;
+    sev.sigev_signo = SIGPROF;
+    sev._sigev_un._tid = static_cast<pid_t>(::syscall(SYS_gettid));
+    if (timer_create(CLOCK_THREAD_CPUTIME_ID, &sev, &g_timer) != 0) {
+        int err = errno;
+        sigaction(SIGPROF, &g_previous, nullptr);
+        g_active.store(nullptr);
+        throw std::runtime_error(std::string("profile sample: cannot create timer: ") + std::strerror(err));
+    }
+    long period = 1000000000L / static_cast<long>(hz);
+    itimerspec its{};
+    its.it_interval.tv_sec = period / 1000000000L;
+    its.it_interval.tv_nsec = period % 1000000000L;
+    its.it_value = its.it_interval;
+    timer_settime(g_timer, 0, &its, nullptr);
+#else
+    (void)hz;
+    throw std::runtime_error("profile sample: the sampling profiler needs Linux");
+#endif
+}
+
+SamplingProfiler::~SamplingProfiler() {
+#ifdef __linux__
+    timer_delete(g_timer);
+    sigaction(SIGPROF, &g_previous, nullptr);
+    g_active.store(nullptr);
+#endif
+}
+
+void SamplingProfiler::on_signal(int) {
+    int saved_errno = errno;
+    if (SamplingProfiler* s = g_active.load(std::memory_order_relaxed); s && s->owns_thread()) {
+#ifdef __linux__
+        // CPU-time timers fire on the scheduler tick, which may be slower
+        // than the requested rate; expirations folded into one signal still
+        // count, so sample weights stay proportional to CPU time.
+        int overrun = timer_getoverrun(g_timer);
+        s->sample(1 + static_cast<uint32_t>(overrun > 0 ? overrun : 0));
+#endif
+    }
+    errno = saved_errno;
+}
+
+// Async-signal context: no allocation, no locks; plain loads and stores.
+void SamplingProfiler::sample(uint32_t weight) {
+    std::atomic_signal_fence(std::memory_order_acquire);
+    uint32_t depth = depth_.load(std::memory_order_relaxed);
+    if (depth == 0) return;  // between lines
+    uint32_t kept = depth < kMaxDepth ? depth : kMaxDepth;
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+
+    if (head != tail) {
+        // Same stack as the newest undrained sample: count it there.
+        Slot& last = slots_[(head - 1) % kSlots];
+        bool same = last.depth == depth;
+        for (uint32_t k = 0; same && k < kept; ++k) {
+            const ShadowFrame& f = frames_[k];
+            same = last.frames[k].label == f.label && last.frames[k].program == f.program &&
+                   last.frames[k].at == f.at.load(std::memory_order_relaxed);
+        }
+        if (same) {
+            last.count += weight;
+            return;
+        }
+    }
+    // One slot stays free for the one drain() may be reading.
+    if (head - tail >= kSlots - 1) {
+        dropped_.fetch_add(weight, std::memory_order_relaxed);
+        return;
+    }
+    Slot& slot = slots_[head % kSlots];
+    slot.count = weight;
+    slot.depth = depth;
+    for (uint32_t k = 0; k < kept; ++k) {
+        slot.frames[k] = {frames_[k].label, frames_[k].program, frames_[k].at.load(std::memory_order_relaxed)};
+    }
+    std::atomic_signal_fence(std::memory_order_release);
+    head_.store(head + 1, std::memory_order_relaxed);
+}
+
+void SamplingProfiler::push(const ProgramView* program, const std::string* label) {
+    uint32_t d = depth_.load(std::memory_order_relaxed);
+    if (d < kMaxDepth) {
+        frames_[d].label = label;
+        frames_[d].program = program;
+        frames_[d].at.store(nullptr, std::memory_order_relaxed);
+    }
+    std::atomic_signal_fence(std::memory_order_release);
+    depth_.store(d + 1, std::memory_order_relaxed);
+}
+
+void SamplingProfiler::pop() {
+    depth_.store(depth_.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    // Samples may point into the popped frame's program; resolve them while
+    // it still lives.
+    if (head_.load(std::memory_order_relaxed) != tail_.load(std::memory_order_relaxed)) drain();
+}
+
+void SamplingProfiler::drain() {
+    std::string key;
+    for (;;) {
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        std::atomic_signal_fence(std::memory_order_acquire);
+        if (tail == head_.load(std::memory_order_relaxed)) return;
+        // Claim the slot before reading it so the handler no longer adds to
+        // its count; it may still coalesce into later slots.
+        tail_.store(tail + 1, std::memory_order_relaxed);
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        const Slot& slot = slots_[tail % kSlots];
+
+        key.clear();
+        uint32_t kept = slot.depth < kMaxDepth ? slot.depth : kMaxDepth;
+        for (uint32_t k = 0; k < kept; ++k) {
+            const SampleFrame& f = slot.frames[k];
+            if (k > 0) key += ';';
+            key += f.label ? *f.label : "{}";
+            if (!f.at) continue;  // sampled before its first instruction
+            key += ':';
+            key += std::to_string(f.at->line);
+            // The running op, unless it is the word the next frame runs.
+            if (f.at->op != OpCode::Call) continue;
+            std::string_view op = f.program->symbol(f.at->sym);
+            bool is_next = k + 1 < kept && slot.frames[k + 1].label && *slot.frames[k + 1].label == op;
+            if (!is_next) {
+                key += ';';
+                key += op;
+            }
+        }
+        if (slot.depth > kMaxDepth) key += ";[deeper]";
+        folded_[key] += slot.count;
+        total_ += slot.count;
+    }
+}
+
+void SamplingProfiler::write_folded(std::ostream& out) {
+    if (owns_thread()) drain();
+    for (const auto& [stack, count] : folded_) out << stack << ' ' << count << '\n';
+}
+
+uint64_t SamplingProfiler::samples() {
+    if (owns_thread()) drain();
+    return total_;
+}
+
+} // namespace woflang
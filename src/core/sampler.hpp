@@ -0,0 +1,118 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bytecode.hpp"
+
+namespace woflang {
+
+// Statistical profiler for Woflang code. A CPU-time timer on the
+// interpreter thread raises SIGPROF up to `hz` times a second (the kernel
+// may deliver at its tick rate instead, weighting each sample by the
+// periods it covers); the handler copies
+// the shadow stack the interpreter keeps (one frame per running line, word
+// or quotation, each pointing at its current instruction) into a ring of
+// preallocated slots. The interpreter drains the ring between
+// instructions, turning samples into folded stacks for flamegraph tools:
+//
+//   script.wof:12;square:3;*  41
+//
+// Frames are `name:line` (an anonymous quotation is `{}`); the leaf is the
+// op that was running, so time spent in native ops lands on the op under
+// the word and line that called it. Consecutive identical samples are
+// coalesced in the handler, so a long native op does not fill the ring.
+//
+// Only the creating thread is sampled and one sampler may run at a time.
+// Linux only; elsewhere the constructor throws.
+class SamplingProfiler {
+public:
+    static constexpr uint32_t kMaxDepth = 64;
+
+    explicit SamplingProfiler(unsigned hz = 1000);
+    ~SamplingProfiler();
+
+    SamplingProfiler(const SamplingProfiler&) = delete;
+    SamplingProfiler& operator=(const SamplingProfiler&) = delete;
+
+    bool owns_thread() const { return std::this_thread::get_id() == owner_; }
+
+    // Shadow stack upkeep, called by the interpreter on the sampled thread.
+    // `label` names the frame (null: anonymous quotation) and must outlive
+    // it, as must `program`.
+    void push(const ProgramView* program, const std::string* label);
+    void pop();
+    void at(const Instr* instr) {
+        uint32_t d = depth_.load(std::memory_order_relaxed);
+        if (d > 0 && d <= kMaxDepth) frames_[d - 1].at.store(instr, std::memory_order_relaxed);
+        if (head_.load(std::memory_order_relaxed) != tail_.load(std::memory_order_relaxed)) drain();
+    }
+
+    // Name of the outermost frames; "<main>" until execute_file sets it to
+    // the script's file name.
+    void set_source(std::string name) { source_ = std::move(name); }
+    const std::string* source() const { return &source_; }
+
+    // Folded stacks ("a;b;c count" per line) and totals so far.
+    void write_folded(std::ostream& out);
+    uint64_t samples();
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    // Scoped push/pop; does nothing with a null sampler.
+    class Scope {
+    public:
+        Scope(SamplingProfiler* s, const ProgramView* program, const std::string* label) : s_(s) {
+            if (s_) s_->push(program, label);
+        }
+        ~Scope() {
+            if (s_) s_->pop();
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        SamplingProfiler* s_;
+    };
+
+private:
+    struct ShadowFrame {
+        const std::string* label;
+        const ProgramView* program;
+        std::atomic<const Instr*> at;
+    };
+    struct SampleFrame {
+        const std::string* label;
+        const ProgramView* program;
+        const Instr* at;
+    };
+    struct Slot {
+        uint32_t count;
+        uint32_t depth;  // may exceed kMaxDepth; only kMaxDepth frames are kept
+        SampleFrame frames[kMaxDepth];
+    };
+    static constexpr uint32_t kSlots = 64;
+
+    static void on_signal(int);
+    void sample(uint32_t weight);
+    void drain();
+
+    std::thread::id owner_;
+    std::string source_ = "<main>";
+    ShadowFrame frames_[kMaxDepth] = {};
+    std::atomic<uint32_t> depth_{0};
+
+    // Written by the handler (head_) and by drain() (tail_), both on the
+    // sampled thread; a slot in [tail_, head_) is filled.
+    std::vector<Slot> slots_;
+    std::atomic<uint32_t> head_{0};
+    std::atomic<uint32_t> tail_{0};
+    std::atomic<uint64_t> dropped_{0};
+
+    std::map<std::string, uint64_t> folded_;
+    uint64_t total_ = 0;
+};
+
+} // namespace woflang
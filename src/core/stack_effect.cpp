@@ -0,0 +1,47 @@
+#include "stack_effect.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace woflang {
+
+std::optional<size_t> required_depth(const ProgramView& program, uint32_t begin, uint32_t end,
+                                     std::span<const StackEffect> effects) {
+    // Depths are relative to the entry depth; `need` is how far below the
+    // entry any op reaches.
+    int64_t depth = 0;
+    int64_t need = 0;
+    std::vector<int64_t> marks;
+    for (uint32_t pc = begin; pc < end; ++pc) {
+        const Instr& in = program.code[pc];
+        switch (in.op) {
+        case OpCode::Push:
+        case OpCode::Name:
+            ++depth;
+            break;
+        case OpCode::Quote:
+            ++depth;
+            pc += in.arg;
+            break;
+        case OpCode::Mark:
+            marks.push_back(depth);
+            break;
+        case OpCode::Collect:
+            if (marks.empty() || marks.back() > depth) return std::nullopt;
+            depth = marks.back() + 1;
+            marks.pop_back();
+            break;
+        case OpCode::Call: {
+            if (in.sym >= effects.size() || !effects[in.sym].known()) return std::nullopt;
+            const StackEffect& e = effects[in.sym];
+            need = std::max(need, e.in - depth);
+            depth += e.out - e.in;
+            break;
+        }
+        case OpCode::Fail:
+            break;
+        }
+    }
+    return static_cast<size_t>(need);
+}
+
+} // namespace woflang
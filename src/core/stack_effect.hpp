@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include "bytecode.hpp"
+
+namespace woflang {
+
+// Declared stack effect of an op: `( a b -- c )` is {2, 1}. The op needs
+// `in` values, consumes them and leaves `out`. Ops whose effect depends on
+// their arguments (clear, call, min/max reducing an array) declare nothing.
+struct StackEffect {
+    static constexpr uint8_t kUnknown = 0xff;
+    uint8_t in = kUnknown;
+    uint8_t out = 0;
+
+    bool known() const { return in != kUnknown; }
+};
+
+// Smallest entry depth at which code[begin, end) runs without any op seeing
+// fewer than its `in` values. `effects` is indexed by symbol. Returns
+// nullopt when the range calls an op without a declared effect or has an
+// unmatched `]`. Quotation bodies are skipped; they are checked when run.
+std::optional<size_t> required_depth(const ProgramView& program, uint32_t begin, uint32_t end,
+                                     std::span<const StackEffect> effects);
+
+// Signature of the optional `declare_stack_effects` plugin export, called
+// once per op with a fixed effect.
+using StackEffectSink = void (*)(void* ctx, const char* name, int in, int out);
+
+} // namespace woflang
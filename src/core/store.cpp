@@ -0,0 +1,452 @@
+#include "store.hpp"
+#include "woflang.hpp"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace woflang {
+
+namespace {
+
+constexpr char kStoreMagic[4] = {'W', 'O', 'F', 'S'};
+constexpr uint32_t kStoreFormat = 1;
+constexpr uint32_t kByteOrderMark = 0x01020304;
+constexpr uint32_t kRecordMagic = 0x5245434b;  // "KCER"
+constexpr const char* kDefaultStore = "woflang.store";
+
+struct StoreHeader {
+    char magic[4];
+    uint32_t format;
+    uint32_t byte_order;
+    uint32_t reserved;
+};
+
+enum RecordKind : uint32_t { Number, String, Array, Forget };
+
+// Followed by the key and the value, each padded to 8 bytes so arrays can be
+// read straight from the mapping, then a checksum of header, key and value.
+struct RecordHeader {
+    uint32_t magic;
+    uint32_t kind;
+    uint32_t key_size;
+    uint32_t detail;  // Number: the value is an exact integer; Array: matrix columns
+    uint64_t value_size;
+};
+static_assert(sizeof(StoreHeader) % 8 == 0 && sizeof(RecordHeader) % 8 == 0);
+
+uint64_t pad8(uint64_t n) { return (n + 7) & ~uint64_t(7); }
+
+std::string_view bytes_of(const void* p, size_t n) { return {static_cast<const char*>(p), n}; }
+
+// Thin wrappers over the descriptor calls that differ on Windows.
+int open_store(const std::filesystem::path& path, bool create) {
+#ifdef _WIN32
+    int fd = -1;
+    int flags = _O_RDWR | _O_BINARY | _O_NOINHERIT | (create ? _O_CREAT | _O_EXCL : 0);
+    _wsopen_s(&fd, path.c_str(), flags, _SH_DENYNO, _S_IREAD | _S_IWRITE);
+    return fd;
+#else
+    return ::open(path.c_str(), O_RDWR | O_CLOEXEC | (create ? O_CREAT | O_EXCL : 0), 0644);
+#endif
+}
+
+bool file_size_of(int fd, uint64_t& size) {
+#ifdef _WIN32
+    __int64 n = _filelengthi64(fd);
+    if (n < 0) return false;
+    size = static_cast<uint64_t>(n);
+#else
+    struct stat s;
+    if (::fstat(fd, &s) != 0) return false;
+    size = static_cast<uint64_t>(s.st_size);
+#endif
+    return true;
+}
+
+bool write_at(int fd, uint64_t at, std::string_view b) {
+#ifdef _WIN32
+    if (_lseeki64(fd, static_cast<__int64>(at), SEEK_SET) < 0) return false;
+    while (!b.empty()) {
+        int n = _write(fd, b.data(), static_cast<unsigned>(std::min<size_t>(b.size(), 1u << 30)));
+        if (n <= 0) return false;
+        b.remove_prefix(static_cast<size_t>(n));
+    }
+#else
+    while (!b.empty()) {
+        ssize_t n = ::pwrite(fd, b.data(), b.size(), static_cast<off_t>(at));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        b.remove_prefix(static_cast<size_t>(n));
+        at += static_cast<uint64_t>(n);
+    }
+#endif
+    return true;
+}
+
+bool truncate_to(int fd, uint64_t size) {
+#ifdef _WIN32
+    return _chsize_s(fd, static_cast<__int64>(size)) == 0;
+#else
+    return ::ftruncate(fd, static_cast<off_t>(size)) == 0;
+#endif
+}
+
+void close_store(int fd) {
+#ifdef _WIN32
+    _close(fd);
+#else
+    ::close(fd);
+#endif
+}
+
+bool sync(int fd) {
+#ifdef _WIN32
+    return _commit(fd) == 0;
+#else
+    return ::fsync(fd) == 0;
+#endif
+}
+
+// True if the bytes in [from, size) are one record cut short: a header
+// that runs to or past the end, a partial header, or the zero-filled blocks
+// a crash can leave. Anything else there is damage, not a torn append.
+bool torn_record(const std::byte* base, uint64_t from, uint64_t size) {
+    if (size - from < sizeof(RecordHeader)) return true;
+    RecordHeader h;
+    std::memcpy(&h, base + from, sizeof(h));
+    if (h.magic == kRecordMagic && h.kind <= Forget) {
+        uint64_t value_at = from + sizeof(h) + pad8(h.key_size);
+        return value_at >= size || pad8(h.value_size) + 8 >= size - value_at;
+    }
+    return std::all_of(base + from, base + size, [](std::byte b) { return b == std::byte{0}; });
+}
+
+// Exclusive lock on the whole store for as long as it lives. The lock is
+// advisory and shared by every ValueStore, in this process or another.
+class StoreLock {
+public:
+    StoreLock(int fd, const std::filesystem::path& path) : fd_(fd) {
+#ifdef _WIN32
+        OVERLAPPED at{};
+        bool ok = LockFileEx(reinterpret_cast<HANDLE>(_get_osfhandle(fd_)), LOCKFILE_EXCLUSIVE_LOCK, 0,
+                             MAXDWORD, MAXDWORD, &at);
+#else
+        int r;
+        while ((r = ::flock(fd_, LOCK_EX)) != 0 && errno == EINTR) {}
+        bool ok = r == 0;
+#endif
+        if (!ok) throw std::runtime_error("store: cannot lock " + path.string());
+    }
+    ~StoreLock() {
+#ifdef _WIN32
+        OVERLAPPED at{};
+        UnlockFileEx(reinterpret_cast<HANDLE>(_get_osfhandle(fd_)), 0, MAXDWORD, MAXDWORD, &at);
+#else
+        ::flock(fd_, LOCK_UN);
+#endif
+    }
+    StoreLock(const StoreLock&) = delete;
+    StoreLock& operator=(const StoreLock&) = delete;
+
+private:
+    int fd_;
+};
+
+} // namespace
+
+ValueStore::ValueStore(std::filesystem::path path) : path_(std::move(path)) {
+    // Never replaced by a rename: every process must append to one inode.
+    fd_ = open_store(path_, true);
+    if (fd_ < 0 && errno == EEXIST) fd_ = open_store(path_, false);
+    if (fd_ < 0) throw std::runtime_error("store: cannot open " + path_.string());
+    try {
+        StoreLock lock(fd_, path_);
+        // Whoever locks an empty file first writes the header, which may not
+        // be the process that created it.
+        uint64_t size = 0;
+        if (!file_size_of(fd_, size)) throw std::runtime_error("store: cannot read " + path_.string());
+        if (size == 0) {
+            StoreHeader h{};
+            std::memcpy(h.magic, kStoreMagic, sizeof(kStoreMagic));
+            h.format = kStoreFormat;
+            h.byte_order = kByteOrderMark;
+            if (!write_at(fd_, 0, bytes_of(&h, sizeof(h))) || !sync(fd_)) {
+                throw std::runtime_error("store: cannot create " + path_.string());
+            }
+        }
+        remap();
+        StoreHeader h;
+        if (!map_ || map_->size() < sizeof(h)) throw std::runtime_error("store: cannot read " + path_.string());
+        std::memcpy(&h, map_->data(), sizeof(h));
+        if (std::memcmp(h.magic, kStoreMagic, sizeof(kStoreMagic)) != 0 || h.format != kStoreFormat ||
+            h.byte_order != kByteOrderMark) {
+            throw std::runtime_error("store: " + path_.string() + " is not a value store");
+        }
+        end_ = sizeof(h);
+        repair_tail();
+    } catch (...) {
+        close_store(fd_);
+        throw;
+    }
+}
+
+ValueStore::~ValueStore() {
+    if (fd_ >= 0) close_store(fd_);
+}
+
+void ValueStore::scan(bool verify_tail) {
+    const std::byte* base = map_->data();
+    uint64_t size = map_->size();
+    for (uint64_t pos = end_; size - pos >= sizeof(RecordHeader);) {
+        RecordHeader h;
+        std::memcpy(&h, base + pos, sizeof(h));
+        uint64_t key_at = pos + sizeof(h);
+        uint64_t value_at = key_at + pad8(h.key_size);
+        if (h.magic != kRecordMagic || h.kind > Forget || value_at > size ||
+            h.value_size > size - value_at || pad8(h.value_size) + 8 > size - value_at) {
+            return;
+        }
+        uint64_t sum_at = value_at + pad8(h.value_size);
+        std::string_view key = bytes_of(base + key_at, h.key_size);
+        // Only the last record can be torn (or still being written), so only
+        // it pays for a full check.
+        if (verify_tail && sum_at + 8 == size) {
+            uint64_t sum = fnv1a(bytes_of(&h, sizeof(h)));
+            sum = fnv1a(key, sum);
+            sum = fnv1a(bytes_of(base + value_at, h.value_size), sum);
+            uint64_t stored;
+            std::memcpy(&stored, base + sum_at, sizeof(stored));
+            if (sum != stored) return;
+        }
+        if (h.kind == Forget) {
+            if (auto it = index_.find(key); it != index_.end()) index_.erase(it);
+        } else {
+            index_.insert_or_assign(std::string(key), pos);
+        }
+        pos = sum_at + 8;
+        end_ = pos;
+    }
+}
+
+void ValueStore::remap() {
+    // The old mapping lives on in any array fetched from it.
+    if (auto m = MappedFile::open(path_)) map_ = std::move(m);
+}
+
+void ValueStore::refresh() {
+    uint64_t size = 0;
+    if (!file_size_of(fd_, size)) return;
+    // Grown, or a tail that was incomplete last time may be whole now.
+    if (size > map_->size()) remap();
+    if (end_ < map_->size()) scan(true);
+}
+
+bool ValueStore::repair_tail() {
+    refresh();
+    uint64_t size = map_->size();
+    if (end_ == size) return true;
+    // No writer is active, so a record cut short here was torn by a crash,
+    // and nothing was appended after it.
+    if (!torn_record(map_->data(), end_, size)) return false;
+    if (!truncate_to(fd_, end_) || !sync(fd_)) {
+        throw std::runtime_error("store: cannot repair " + path_.string());
+    }
+    remap();
+    return true;
+}
+
+void ValueStore::append(uint32_t kind, uint32_t detail, std::string_view key, uint64_t value_size,
+                        const std::function<void(const std::function<void(std::string_view)>&)>& value) {
+    if (key.empty()) throw std::runtime_error("store: empty key");
+    StoreLock lock(fd_, path_);
+    if (!repair_tail()) {
+        // Good records may follow the damage; appending after it would
+        // hide the new one too.
+        throw std::runtime_error("store: " + path_.string() + " is damaged after byte " +
+                                 std::to_string(end_));
+    }
+    const uint64_t start = end_;
+    RecordHeader h{kRecordMagic, kind, static_cast<uint32_t>(key.size()), detail, value_size};
+    static constexpr char kZeros[8] = {};
+    // Written through a buffer at the end found under the lock; an array
+    // value streams through it in chunks.
+    std::string buffer;
+    uint64_t at = start;
+    bool ok = true;
+    auto flush = [&] {
+        ok = ok && write_at(fd_, at, buffer);
+        at += buffer.size();
+        buffer.clear();
+    };
+    auto write = [&](std::string_view b) {
+        buffer.append(b);
+        if (buffer.size() >= (size_t(1) << 20)) flush();
+    };
+    uint64_t written = 0;
+    try {
+        uint64_t sum = fnv1a(bytes_of(&h, sizeof(h)));
+        sum = fnv1a(key, sum);
+        write(bytes_of(&h, sizeof(h)));
+        write(key);
+        write({kZeros, pad8(key.size()) - key.size()});
+        value([&](std::string_view chunk) {
+            sum = fnv1a(chunk, sum);
+            write(chunk);
+            written += chunk.size();
+        });
+        write({kZeros, pad8(value_size) - value_size});
+        write(bytes_of(&sum, sizeof(sum)));
+        flush();
+    } catch (...) {
+        truncate_to(fd_, start);
+        throw;
+    }
+    if (!ok || written != value_size || !sync(fd_)) {
+        // Leave no partial record behind for the next writer to find.
+        truncate_to(fd_, start);
+        throw std::runtime_error("store: cannot write " + path_.string());
+    }
+    refresh();  // indexes the new record
+}
+
+void ValueStore::put(std::string_view key, const WofValue& value) {
+    if (value.is_quotation()) throw std::runtime_error("store: cannot store quotations");
+    if (value.is_array()) {
+        size_t n = array_size(value);
+        if (n == kUnbounded) throw std::runtime_error("store: cannot store an unbounded sequence");
+        // Deferred arrays are written as they stream, never materialized.
+        append(Array, value.cols, key, n * sizeof(double), [&](const auto& emit) {
+            for_each_chunk(value, [&](std::span<const double> c) {
+                emit(bytes_of(c.data(), c.size() * sizeof(double)));
+            });
+        });
+    } else if (value.is_string()) {
+        append(String, 0, key, value.s.size(), [&](const auto& emit) { emit(value.s); });
+    } else {
+        int64_t i = value.i;
+        double d = value.d;
+        append(Number, value.exact, key, sizeof(i) + sizeof(d), [&](const auto& emit) {
+            emit(bytes_of(&i, sizeof(i)));
+            emit(bytes_of(&d, sizeof(d)));
+        });
+    }
+}
+
+std::optional<WofValue> ValueStore::get(std::string_view key) {
+    refresh();
+    auto it = index_.find(key);
+    if (it == index_.end()) return std::nullopt;
+    const std::byte* base = map_->data();
+    RecordHeader h;
+    std::memcpy(&h, base + it->second, sizeof(h));
+    const std::byte* value = base + it->second + sizeof(h) + pad8(h.key_size);
+    WofValue v;
+    switch (h.kind) {
+    case Number:
+        std::memcpy(&v.i, value, sizeof(v.i));
+        std::memcpy(&v.d, value + sizeof(v.i), sizeof(v.d));
+        v.exact = h.detail != 0;
+        break;
+    case String:
+        v.text = true;
+        v.s.assign(reinterpret_cast<const char*>(value), h.value_size);
+        break;
+    case Array: {
+        size_t n = h.value_size / sizeof(double);
+        v.lazy = make_view(reinterpret_cast<const double*>(value), n, map_);
+        if (h.detail != 0 && n % h.detail == 0) v.cols = h.detail;
+        break;
+    }
+    }
+    return v;
+}
+
+bool ValueStore::contains(std::string_view key) {
+    refresh();
+    return index_.find(key) != index_.end();
+}
+
+bool ValueStore::erase(std::string_view key) {
+    if (!contains(key)) return false;
+    append(Forget, 0, key, 0, [](const auto&) {});
+    return true;
+}
+
+ValueStore& WoflangInterpreter::value_store() {
+    if (!store_) {
+        const char* path = std::getenv("WOFLANG_STORE");
+        store_ = std::make_unique<ValueStore>(path && *path ? path : kDefaultStore);
+    }
+    return *store_;
+}
+
+namespace {
+// The key on top of the stack, left there: ops pop it once they succeed, so
+// a failed store or fetch leaves its operands in place.
+std::string need_key(std::stack<WofValue>& st, const char* op) {
+    // The store, and remapping it, is not shared safely between threads.
+    WoflangInterpreter::refuse_in_parallel(op);
+    if (st.top().s.empty()) throw std::runtime_error(std::string(op) + ": expects a 'key");
+    return st.top().s;
+}
+}
+
+void WoflangInterpreter::register_store_ops() {
+    // Values persist across runs in $WOFLANG_STORE (default ./woflang.store).
+
+    // 'path store_open  ->  use another store file
+    register_op("store_open", [this](std::stack<WofValue>& st) {
+        store_ = std::make_unique<ValueStore>(need_key(st, "store_open"));
+        st.pop();
+    }, {1, 0});
+
+    // value 'key store  ->
+    register_op("store", [this](std::stack<WofValue>& st) {
+        std::string key = need_key(st, "store");
+        WofValue name = std::move(st.top());
+        st.pop();
+        try {
+            value_store().put(key, st.top());
+        } catch (...) {
+            st.push(std::move(name));
+            throw;
+        }
+        st.pop();
+    }, {2, 0});
+
+    // 'key fetch  ->  value   (arrays are read in place from the file)
+    register_op("fetch", [this](std::stack<WofValue>& st) {
+        std::string key = need_key(st, "fetch");
+        auto v = value_store().get(key);
+        if (!v) throw std::runtime_error("fetch: nothing stored under '" + key + "'");
+        st.pop();
+        st.push(std::move(*v));
+    }, {1, 1});
+
+    // 'key stored  ->  1 if key holds a value, else 0
+    register_op("stored", [this](std::stack<WofValue>& st) {
+        std::string key = need_key(st, "stored");
+        bool found = value_store().contains(key);
+        st.pop();
+        st.push(WofValue(found ? 1 : 0));
+    }, {1, 1});
+
+    // 'key forget  ->
+    register_op("forget", [this](std::stack<WofValue>& st) {
+        value_store().erase(need_key(st, "forget"));
+        st.pop();
+    }, {1, 0});
+}
+
+} // namespace woflang
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "../io/mapped_file.hpp"
+
+namespace woflang {
+
+struct WofValue;
+
+// Persistent key/value store for values, kept in one append-only file.
+// store and forget each append a record: a header, then the key and the
+// value, each padded to 8 bytes, then a checksum. The record is synced
+// before the call returns. The index maps each key to its latest record and
+// is rebuilt by scanning the headers on open.
+//
+// Any number of processes may share a store. The file is created in place
+// (never renamed over), and appends and repairs hold an exclusive lock on
+// it (flock; LockFileEx on Windows), writing at the end they find under the
+// lock. A writer first cuts off anything past the last good record: with no
+// other writer active, that can only be a record torn by a crash, and since
+// nothing is ever appended after one, it is always the last thing in the
+// file. Readers take no lock and index a record once it is complete. A
+// file damaged anywhere else stays readable up to the damage but refuses
+// appends.
+//
+// Fetched arrays are views into the file's mapping (see make_view): they are
+// never copied to be read. Records appended later, including by other
+// processes, are picked up when the file grows.
+class ValueStore {
+public:
+    // Creates the file if needed; throws if it cannot be opened or is not a
+    // store.
+    explicit ValueStore(std::filesystem::path path);
+    ~ValueStore();
+
+    ValueStore(const ValueStore&) = delete;
+    ValueStore& operator=(const ValueStore&) = delete;
+
+    // Numbers, strings and (possibly deferred) arrays, matrices keeping their
+    // shape; throws for others.
+    void put(std::string_view key, const WofValue& value);
+    std::optional<WofValue> get(std::string_view key);
+    bool contains(std::string_view key);
+    // False if there was nothing to forget.
+    bool erase(std::string_view key);
+
+    const std::filesystem::path& path() const { return path_; }
+
+private:
+    struct KeyHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+    };
+
+    void refresh();
+    void scan(bool verify_tail);
+    void remap();
+    // With the lock held: index new records and cut off a torn tail. False
+    // if what follows the last good record is damage rather than a tail.
+    bool repair_tail();
+    void append(uint32_t kind, uint32_t detail, std::string_view key, uint64_t value_size,
+                const std::function<void(const std::function<void(std::string_view)>&)>& value);
+
+    std::filesystem::path path_;
+    int fd_ = -1;
+    std::shared_ptr<const MappedFile> map_;
+    uint64_t end_ = 0;  // end of the last indexed record
+    std::unordered_map<std::string, uint64_t, KeyHash, std::equal_to<>> index_;
+};
+
+} // namespace woflang
@@ -0,0 +1,127 @@
+#include "thread_pool.hpp"
+#include <exception>
+
+namespace woflang {
+
+namespace {
+// Index of the pool worker running on this thread; npos for outside threads.
+thread_local const ThreadPool* tls_pool = nullptr;
+thread_local size_t tls_worker = static_cast<size_t>(-1);
+std::atomic<bool> g_shared_started{false};
+}
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) threads = 1;
+    for (unsigned i = 0; i < threads; ++i) workers_.push_back(std::make_unique<Worker>());
+    for (unsigned i = 0; i < threads; ++i) threads_.emplace_back([this, i] { worker_loop(i); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stopping_ = true;
+    }
+    sleep_cv_.notify_all();
+    for (auto& t : threads_) t.join();
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    g_shared_started.store(true, std::memory_order_relaxed);
+    return pool;
+}
+
+bool ThreadPool::shared_started() {
+    return g_shared_started.load(std::memory_order_relaxed);
+}
+
+void ThreadPool::push(size_t queue, Job job) {
+    {
+        std::lock_guard<std::mutex> lock(workers_[queue]->mutex);
+        workers_[queue]->jobs.push_back(std::move(job));
+    }
+    pending_.fetch_add(1, std::memory_order_release);
+}
+
+bool ThreadPool::try_run_one(size_t self) {
+    Job job;
+    size_t n = workers_.size();
+    // Own queue first (newest job, cache-warm), then steal the oldest from siblings.
+    if (self < n) {
+        std::lock_guard<std::mutex> lock(workers_[self]->mutex);
+        if (!workers_[self]->jobs.empty()) {
+            job = std::move(workers_[self]->jobs.back());
+            workers_[self]->jobs.pop_back();
+        }
+    }
+    for (size_t k = 1; !job && k <= n; ++k) {
+        size_t victim = (self < n ? self + k : k) % n;
+        std::lock_guard<std::mutex> lock(workers_[victim]->mutex);
+        if (!workers_[victim]->jobs.empty()) {
+            job = std::move(workers_[victim]->jobs.front());
+            workers_[victim]->jobs.pop_front();
+        }
+    }
+    if (!job) return false;
+    pending_.fetch_sub(1, std::memory_order_acq_rel);
+    job();
+    return true;
+}
+
+void ThreadPool::worker_loop(size_t self) {
+    tls_pool = this;
+    tls_worker = self;
+    for (;;) {
+        if (try_run_one(self)) continue;
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        sleep_cv_.wait(lock, [this] {
+            return stopping_ || pending_.load(std::memory_order_acquire) > 0;
+        });
+        if (stopping_ && pending_.load(std::memory_order_acquire) == 0) return;
+    }
+}
+
+void ThreadPool::parallel_for(size_t n, const std::function<void(size_t)>& body) {
+    if (n == 0) return;
+    if (n == 1 || workers_.size() == 1) {
+        for (size_t i = 0; i < n; ++i) body(i);
+        return;
+    }
+
+    struct Group {
+        std::atomic<size_t> remaining;
+        std::mutex error_mutex;
+        std::exception_ptr error;
+    };
+    auto group = std::make_shared<Group>();
+    group->remaining.store(n, std::memory_order_relaxed);
+
+    // Jobs spawned from a worker land on its own deque and get stolen from
+    // there; outside callers spread them round-robin.
+    size_t self = tls_pool == this ? tls_worker : static_cast<size_t>(-1);
+    for (size_t i = 0; i < n; ++i) {
+        size_t queue = self != static_cast<size_t>(-1)
+            ? self
+            : next_queue_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+        push(queue, [group, &body, i] {
+            try {
+                body(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(group->error_mutex);
+                if (!group->error) group->error = std::current_exception();
+            }
+            group->remaining.fetch_sub(1, std::memory_order_acq_rel);
+        });
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+    }
+    sleep_cv_.notify_all();
+
+    while (group->remaining.load(std::memory_order_acquire) != 0) {
+        if (!try_run_one(self)) std::this_thread::yield();
+    }
+    if (group->error) std::rethrow_exception(group->error);
+}
+
+} // namespace woflang
@@ -0,0 +1,60 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace woflang {
+
+// Work-stealing pool behind the parallel combinators (pmap, preduce, pfor).
+// Each worker owns a deque: it pops its own newest job and steals the oldest
+// job of a sibling when idle. Callers of parallel_for help drain jobs while
+// they wait, so nested parallel_for from inside a job cannot deadlock.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threads = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(workers_.size()); }
+
+    // Run body(i) for every i in [0, n) and block until all have finished.
+    // The first exception thrown by any body is rethrown here.
+    void parallel_for(size_t n, const std::function<void(size_t)>& body);
+
+    // Process-wide pool, created on first use.
+    static ThreadPool& shared();
+    // Whether shared() has started its threads (a forked child would not
+    // inherit them).
+    static bool shared_started();
+
+private:
+    using Job = std::function<void()>;
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    void worker_loop(size_t self);
+    void push(size_t queue, Job job);
+    bool try_run_one(size_t self);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+    std::atomic<size_t> pending_{0};
+    std::atomic<size_t> next_queue_{0};
+    bool stopping_ = false;
+};
+
+} // namespace woflang
@@ -1,9 +1,17 @@
 #include "woflang.hpp"
-#include "../io/tokenizer.hpp"
+#include "thread_pool.hpp"
+#include "array_file.hpp"
+#include "int_math.hpp"
+#include "../io/mapped_file.hpp"
+#include "../io/numeric_text.hpp"
+#include <algorithm>
 #include <iostream>
+#include <charconv>
+#include <limits>
 #include <sstream>
 #include <cctype>
 #include <cmath>
+#include <utility>
 #ifdef _WIN32
 #include <windows.h>
 #else
@@ -12,7 +20,54 @@
 
 namespace woflang {
 
-WoflangInterpreter::WoflangInterpreter() {
+namespace {
+thread_local WoflangInterpreter* tls_current_interpreter = nullptr;
+
+// Instruction tally of the parallel combinator whose chunk this thread is
+// running, or null. Charges made inside a chunk (call, words, nested
+// combinators) land here, never in the owner's non-atomic steps_.
+struct ParallelTally {
+    std::atomic<uint64_t> steps{0};
+    uint64_t budget = 0;  // instructions left when the combinator started
+};
+thread_local ParallelTally* tls_parallel_tally = nullptr;
+
+struct ParallelScope {
+    ParallelTally* outer;
+    explicit ParallelScope(ParallelTally* tally) : outer(tls_parallel_tally) { tls_parallel_tally = tally; }
+    ~ParallelScope() { tls_parallel_tally = outer; }
+};
+
+// Returns the tally after adding `n`.
+uint64_t charge_parallel(ParallelTally& tally, uint64_t n, uint64_t max_instructions) {
+    uint64_t used = tally.steps.fetch_add(n, std::memory_order_relaxed) + n;
+    if (max_instructions && used > tally.budget) {
+        throw BudgetExceeded("instruction budget of " + std::to_string(max_instructions) +
+                             " exhausted in parallel work");
+    }
+    return used;
+}
+
+// std::stack hides its container; a derived accessor lets the governor walk
+// the values without copying the whole stack.
+struct StackPeek : std::stack<WofValue> {
+    static const container_type& of(const std::stack<WofValue>& s) {
+        return s.*(&StackPeek::c);
+    }
+};
+}
+
+WoflangInterpreter* WoflangInterpreter::current() {
+    return tls_current_interpreter;
+}
+
+void WoflangInterpreter::refuse_in_parallel(const char* op) {
+    if (tls_parallel_tally) throw std::runtime_error(std::string(op) + ": not available in a parallel op");
+}
+
+WoflangInterpreter::WoflangInterpreter() : memo_(std::make_unique<MemoCache>()) {
+    host_current_interpreter = &WoflangInterpreter::current;
+
     // Register built-in ops and eggs
     register_op("cursed", [](std::stack<WofValue>& stack) {
         std::cout << "You have invoked the ancient Woflang curse! 👻\n";
@@ -35,8 +90,10 @@ WoflangInterpreter::WoflangInterpreter() {
         auto val = stack.top();
         stack.pop();
         // Safe output without using potentially broken to_string()
-        if (!val.s.empty()) {
-            std::cout << val.s << "\n";
+        if (val.is_string() || val.is_array() || val.is_quotation()) {
+            std::cout << val.to_string() << "\n";
+        } else if (val.exact) {
+            std::cout << val.i << "\n";
         } else if (val.d != 0.0) {
             std::cout << val.d << "\n";
         } else {
@@ -56,8 +113,10 @@ WoflangInterpreter::WoflangInterpreter() {
         
         while (!temp.empty()) {
             auto val = temp.top();
-            if (!val.s.empty()) {
-                values.push_back(val.s);
+            if (val.is_string() || val.is_array() || val.is_quotation()) {
+                values.push_back(val.to_string());
+            } else if (val.exact) {
+                values.push_back(std::to_string(val.i));
             } else if (val.d != 0.0) {
                 values.push_back(std::to_string(val.d));
             } else {
@@ -80,92 +139,117 @@ WoflangInterpreter::WoflangInterpreter() {
     
     // Basic arithmetic
     register_op("+", [](std::stack<WofValue>& stack) {
-        if (stack.size() < 2) {
-            std::cout << "Error: + requires 2 values\n";
-            return;
-        }
+        if (fuse_binary(stack, ElemOp::Add)) return;
         auto b = stack.top(); stack.pop();
         auto a = stack.top(); stack.pop();
         WofValue result;
+        if (int_binary(ElemOp::Add, a, b, result)) {
+            stack.push(result);
+            return;
+        }
         result.d = a.as_numeric() + b.as_numeric();
         stack.push(result);
-    });
+    }, {2, 1});
     
     register_op("-", [](std::stack<WofValue>& stack) {
-        if (stack.size() < 2) {
-            std::cout << "Error: - requires 2 values\n";
-            return;
-        }
+        if (fuse_binary(stack, ElemOp::Sub)) return;
         auto b = stack.top(); stack.pop();
         auto a = stack.top(); stack.pop();
         WofValue result;
+        if (int_binary(ElemOp::Sub, a, b, result)) {
+            stack.push(result);
+            return;
+        }
         result.d = a.as_numeric() - b.as_numeric();
         stack.push(result);
-    });
+    }, {2, 1});
     
     register_op("*", [](std::stack<WofValue>& stack) {
-        if (stack.size() < 2) {
-            std::cout << "Error: * requires 2 values\n";
-            return;
-        }
+        if (fuse_binary(stack, ElemOp::Mul)) return;
         auto b = stack.top(); stack.pop();
         auto a = stack.top(); stack.pop();
         WofValue result;
+        if (int_binary(ElemOp::Mul, a, b, result)) {
+            stack.push(result);
+            return;
+        }
         result.d = a.as_numeric() * b.as_numeric();
         stack.push(result);
-    });
+    }, {2, 1});
     
     register_op("/", [](std::stack<WofValue>& stack) {
-        if (stack.size() < 2) {
-            std::cout << "Error: / requires 2 values\n";
-            return;
-        }
+        if (fuse_binary(stack, ElemOp::Div)) return;
+        double b_val = stack.top().as_numeric();
+        if (b_val == 0.0) throw std::runtime_error("division by zero");
         auto b = stack.top(); stack.pop();
         auto a = stack.top(); stack.pop();
-        double b_val = b.as_numeric();
-        if (b_val == 0.0) {
-            std::cout << "Error: Division by zero\n";
-            stack.push(a);
-            stack.push(b);
+        WofValue result;
+        if (int_binary(ElemOp::Div, a, b, result)) {
+            stack.push(result);
             return;
         }
-        WofValue result;
         result.d = a.as_numeric() / b_val;
         stack.push(result);
-    });
+    }, {2, 1});
     
     register_op("sqrt", [](std::stack<WofValue>& stack) {
-        if (stack.empty()) {
-            std::cout << "Error: sqrt requires 1 value\n";
-            return;
-        }
-        auto a = stack.top(); stack.pop();
-        double val = a.as_numeric();
-        if (val < 0) {
-            std::cout << "Error: sqrt of negative number\n";
-            stack.push(a);
-            return;
-        }
+        if (fuse_unary(stack, ElemOp::Sqrt)) return;
+        double val = stack.top().as_numeric();
+        if (val < 0) throw std::runtime_error("sqrt of negative number");
+        stack.pop();
         WofValue result;
         result.d = std::sqrt(val);
         stack.push(result);
-    });
+    }, {1, 1});
     
+    // Async: suspends the session on the scheduler's timer heap instead of
+    // parking the thread; a plain blocking sleep under execute_line.
+    register_async_op("sleep", [](std::stack<WofValue>& stack) -> Task {
+        if (stack.empty()) {
+            std::cout << "Error: sleep requires milliseconds\n";
+            co_return;
+        }
+        auto ms = stack.top(); stack.pop();
+        co_await sleep_for(std::chrono::duration_cast<Scheduler::Clock::duration>(
+            std::chrono::duration<double, std::milli>(ms.as_numeric())));
+    });
+
+    register_parallel_ops();
+    register_sequence_ops();
+    register_word_ops();
+    register_evolve_ops();
+    register_store_ops();
+    register_matrix_ops();
+    register_image_ops();
+
+    register_op("memo_stats", [this](std::stack<WofValue>&) {
+        std::cout << "memo: " << memo_->size() << " entries, " << memo_->evictions()
+                  << " evictions\n";
+        for (const auto& op : memo_->stats()) {
+            uint64_t calls = op.hits + op.misses;
+            std::cout << "  " << op.name << "/" << op.arity << ": " << op.hits << " hits, "
+                      << op.misses << " misses";
+            if (calls) std::cout << " (" << (100.0 * op.hits / calls) << "% hit)";
+            std::cout << "\n";
+        }
+    });
+    register_op("memo_clear", [this](std::stack<WofValue>&) { memo_->clear(); });
+
     register_op("pi", [](std::stack<WofValue>& stack) {
         WofValue pi;
         pi.d = 3.14159265358979323846;
         stack.push(pi);
-    });
+    }, {0, 1});
     
     register_op("π", [](std::stack<WofValue>& stack) {
         WofValue pi;
         pi.d = 3.14159265358979323846;
         stack.push(pi);
-    });
+    }, {0, 1});
 }
 
 // Helper function to check if a string is a number
-bool is_number(const std::string& str) {
+bool is_number(std::string_view str) {
     if (str.empty()) return false;
     
     size_t start = 0;
@@ -175,59 +259,851 @@ bool is_number(const std::string& str) {
     }
     
     bool has_dot = false;
+    bool has_digit = false;
     for (size_t i = start; i < str.length(); ++i) {
         if (str[i] == '.') {
             if (has_dot) return false; // Multiple dots
             has_dot = true;
-        } else if (!std::isdigit(str[i])) {
+        } else if (!std::isdigit(static_cast<unsigned char>(str[i]))) {
             return false;
+        } else {
+            has_digit = true;
         }
     }
-    return true;
+    return has_digit; // a lone "." or "-." is a word, not a number
 }
 
-// Safe number parsing
-WofValue parse_number(const std::string& str) {
+// Safe number parsing (from_chars: no allocation, no locale, no exceptions)
+WofValue parse_number(std::string_view str) {
     WofValue val;
-    try {
-        if (str.find('.') != std::string::npos) {
-            val.d = std::stod(str);
-        } else {
-            val.i = std::stoi(str);
-            val.d = static_cast<double>(val.i);
-        }
-    } catch (const std::exception&) {
-        // If parsing fails, treat as zero
-        val.i = 0;
-        val.d = 0.0;
+    if (!str.empty() && str[0] == '+') str.remove_prefix(1);
+    const char* first = str.data();
+    const char* last = str.data() + str.size();
+    if (str.find('.') != std::string_view::npos) {
+        auto [end, ec] = std::from_chars(first, last, val.d);
+        if (ec != std::errc() || end != last) val.d = 0.0;
+    } else {
+        int64_t n = 0;
+        auto [end, ec] = std::from_chars(first, last, n);
+        if (ec == std::errc() && end == last) return WofValue::make_int(n);
+        // Too big for int64: promote to the nearest double.
+        auto [dend, dec] = std::from_chars(first, last, val.d);
+        if (dec != std::errc() || dend != last) val.d = 0.0;
     }
     return val;
 }
 
+WoflangInterpreter::~WoflangInterpreter() = default;
+
 void WoflangInterpreter::register_op(const std::string& name, OpHandler handler) {
     op_table_[name] = handler;
 }
 
+void WoflangInterpreter::register_op(const std::string& name, OpHandler handler,
+                                     StackEffect effect) {
+    op_table_[name] = std::move(handler);
+    effects_[name] = effect;
+}
+
+void WoflangInterpreter::declare_effect(const std::string& name, StackEffect effect) {
+    effects_[name] = effect;
+}
+
+void WoflangInterpreter::begin_budget() {
+    steps_ = 0;
+    yield_polls_ = 0;
+    cancel_requested_.store(false, std::memory_order_relaxed);
+    has_deadline_ = limits_.timeout.count() > 0;
+    if (has_deadline_) {
+        deadline_ = std::chrono::steady_clock::now() + limits_.timeout;
+    }
+}
+
+size_t WoflangInterpreter::stack_value_bytes() const {
+    size_t bytes = 0;
+    for (const auto& v : StackPeek::of(stack)) {
+        bytes += sizeof(WofValue);
+        if (v.s.capacity() > sizeof(std::string)) bytes += v.s.capacity();
+        // Deferred arrays count what they hold once evaluated; unbounded
+        // ones hold nothing until a take bounds them. Values shared after
+        // dup count once per copy, so this errs high.
+        if (v.arr) bytes += v.arr->size() * sizeof(double);
+        else if (v.lazy && v.lazy->size != kUnbounded) bytes += v.lazy->size * sizeof(double);
+        if (v.quote) bytes += (v.quote->end - v.quote->begin) * sizeof(Instr);
+    }
+    return bytes;
+}
+
+void WoflangInterpreter::charge_instruction(std::string_view token) {
+    if (ParallelTally* tally = tls_parallel_tally) {
+        // On a pool worker (or the caller, running a chunk): only the shared
+        // tally and the deadline/cancel flag are touched.
+        uint64_t used = charge_parallel(*tally, 1, limits_.max_instructions);
+        if (used % kBudgetCheckStride == 0 && deadline_passed()) {
+            throw BudgetExceeded("parallel work interrupted by resource governor at '" + std::string(token) + "'");
+        }
+        return;
+    }
+    ++steps_;
+    if (limits_.max_instructions && steps_ > limits_.max_instructions) {
+        throw BudgetExceeded("instruction budget of " + std::to_string(limits_.max_instructions) +
+                             " exhausted at '" + std::string(token) + "'");
+    }
+    if (limits_.max_stack_depth && stack.size() > limits_.max_stack_depth) {
+        throw BudgetExceeded("stack depth " + std::to_string(stack.size()) +
+                             " exceeds limit of " + std::to_string(limits_.max_stack_depth));
+    }
+    if (cancel_requested_.load(std::memory_order_relaxed)) {
+        throw BudgetExceeded("execution cancelled at '" + std::string(token) + "'");
+    }
+    // Clock reads and the byte walk are amortised over a stride of instructions.
+    if (steps_ % kBudgetCheckStride != 0) return;
+    if (has_deadline_ && std::chrono::steady_clock::now() >= deadline_) {
+        throw BudgetExceeded("deadline of " + std::to_string(limits_.timeout.count()) +
+                             " ms exceeded at '" + std::string(token) + "'");
+    }
+    if (limits_.max_value_bytes) {
+        size_t bytes = stack_value_bytes();
+        if (bytes > limits_.max_value_bytes) {
+            throw BudgetExceeded("stack values hold " + std::to_string(bytes) +
+                                 " bytes, limit is " + std::to_string(limits_.max_value_bytes));
+        }
+    }
+}
+
+namespace {
+// Publishes the interpreter for WoflangInterpreter::current() while in scope.
+struct CurrentScope {
+    WoflangInterpreter* outer;
+    explicit CurrentScope(WoflangInterpreter* self) : outer(tls_current_interpreter) {
+        tls_current_interpreter = self;
+    }
+    ~CurrentScope() { tls_current_interpreter = outer; }
+};
+}
+
+void WoflangInterpreter::report_error(const std::string& message) {
+    ++op_errors_;
+    std::lock_guard<std::mutex> lock(errors_mutex_);
+    if (capture_errors_) {
+        captured_errors_ += message;
+        captured_errors_ += '\n';
+    } else {
+        std::cout << message << "\n";
+    }
+}
+
+void WoflangInterpreter::capture_errors(bool on) {
+    std::lock_guard<std::mutex> lock(errors_mutex_);
+    capture_errors_ = on;
+}
+
+std::string WoflangInterpreter::take_errors() {
+    std::lock_guard<std::mutex> lock(errors_mutex_);
+    return std::exchange(captured_errors_, {});
+}
+
+bool WoflangInterpreter::dispatch_token(std::string_view token, std::stack<WofValue>& st,
+                                        const OpHandler* handler) {
+    try {
+        if (handler) {
+            (*handler)(st);
+        } else if (auto it = op_table_.find(token); it != op_table_.end()) {
+            it->second(st);
+        } else if (auto ait = async_op_table_.find(token); ait != async_op_table_.end()) {
+            sync_wait(ait->second(st));
+        } else if (auto vit = variables_.find(token); vit != variables_.end()) {
+            st.push(vit->second);
+        } else {
+            report_error("Unknown op: " + std::string(token));
+            return false;
+        }
+    } catch (const BudgetExceeded&) {
+        throw;
+    } catch (const std::exception& e) {
+        report_error("Error executing '" + std::string(token) + "': " + e.what());
+        return false;
+    }
+    return true;
+}
+
+WoflangInterpreter::Bindings WoflangInterpreter::bind(const ProgramView& program,
+                                                      std::pmr::memory_resource* mr) const {
+    // Resolve each distinct name once per run instead of once per call.
+    // Entries stay valid: map nodes are stable and re-registering an op
+    // assigns into the existing node.
+    Bindings bound{std::pmr::vector<const OpHandler*>(program.symbols.size(), nullptr, mr),
+                   std::pmr::vector<StackEffect>(program.symbols.size(), StackEffect{}, mr)};
+    for (uint32_t k = 0; k < program.symbols.size(); ++k) {
+        std::string_view name = program.symbol(k);
+        if (auto it = op_table_.find(name); it != op_table_.end()) {
+            bound.handlers[k] = &it->second;
+        }
+        if (auto it = effects_.find(name); it != effects_.end()) {
+            bound.effects[k] = it->second;
+        }
+    }
+    return bound;
+}
+
+bool WoflangInterpreter::verified_at(const ProgramView& program, uint32_t begin, uint32_t end,
+                                     const Bindings& bound, size_t depth) {
+    auto need = required_depth(program, begin, end, bound.effects);
+    return need && *need <= depth;
+}
+
+uint32_t WoflangInterpreter::step(uint32_t pc, Frame& frame) {
+    const Instr& in = frame.program.code[pc];
+    auto& st = frame.stack;
+    switch (in.op) {
+    case OpCode::Push: {
+        WofValue val;
+        val.i = in.i;
+        val.d = in.d;
+        val.exact = in.arg != 0;
+        st.push(std::move(val));
+        return pc + 1;
+    }
+    case OpCode::Call: {
+        std::string_view name = frame.program.symbol(in.sym);
+        if (!frame.verified) {
+            // Ops with a declared effect leave the underflow check to us.
+            const StackEffect& effect = frame.bound.effects[in.sym];
+            if (effect.known() && st.size() < effect.in) {
+                report_error("Error executing '" + std::string(name) + "': stack underflow");
+                return pc + 1;
+            }
+        }
+        OpProfiler* profiler = profiler_ && profiler_->owns_thread() ? profiler_.get() : nullptr;
+        OpProfiler::Sample sample;
+        if (profiler) profiler->begin(sample);
+        if (!dispatch_token(name, st, frame.bound.handlers[in.sym])) {
+            // A failed op may have consumed part of its input.
+            frame.verified = false;
+        }
+        if (profiler) profiler->end(name, sample);
+        return pc + 1;
+    }
+    case OpCode::Quote: {
+        // Capture the body as a quotation value. Code compiled into the
+        // arena dies with the line, so such bodies are copied out.
+        auto q = std::make_shared<Quotation>();
+        if (frame.owner) {
+            q->owner = frame.owner;
+            q->program = frame.program;
+            q->begin = pc + 1;
+            q->end = pc + 1 + in.arg;
+        } else {
+            auto copy = extract(frame.program, pc + 1, pc + 1 + in.arg);
+            q->program = copy->view();
+            q->end = static_cast<uint32_t>(copy->code.size());
+            q->owner = std::move(copy);
+        }
+        WofValue v;
+        v.quote = std::move(q);
+        st.push(std::move(v));
+        return pc + 1 + in.arg;
+    }
+    case OpCode::Name:
+        st.push(WofValue(std::string(frame.program.symbol(in.sym))));
+        return pc + 1;
+    case OpCode::Mark:
+        frame.marks.push_back(st.size());
+        return pc + 1;
+    case OpCode::Collect: {
+        if (frame.marks.empty() || frame.marks.back() > st.size()) {
+            report_error("Error: unmatched ]");
+            frame.marks.clear();
+            return pc + 1;
+        }
+        WofArray values(st.size() - frame.marks.back());
+        for (size_t k = values.size(); k-- > 0;) {
+            values[k] = st.top().as_numeric();
+            st.pop();
+        }
+        frame.marks.pop_back();
+        st.push(WofValue::make_array(std::move(values)));
+        return pc + 1;
+    }
+    case OpCode::Fail: {
+        std::string message = "Error: " + std::string(frame.program.symbol(in.sym));
+        if (in.line > 1) message += " (line " + std::to_string(in.line) + ")";
+        report_error(message);
+        return pc + 1;
+    }
+    }
+    return pc + 1;
+}
+
+void WoflangInterpreter::record_step(const Instr& in, const Frame& frame) {
+    // pmap/pfor/preduce bodies run on their own stacks, possibly on worker
+    // threads; only the interpreter's stack is recorded.
+    if (&frame.stack != &stack) return;
+    StackEffect hint;
+    switch (in.op) {
+    case OpCode::Push:
+    case OpCode::Quote:
+    case OpCode::Name:
+        hint = {0, 1};
+        break;
+    case OpCode::Mark:
+    case OpCode::Fail:
+        hint = {0, 0};
+        break;
+    case OpCode::Call:
+        hint = frame.bound.effects[in.sym];
+        break;
+    case OpCode::Collect:
+        break;
+    }
+    history_->record(stack, hint);
+}
+
+void WoflangInterpreter::record_history(size_t max_steps) {
+    history_ = std::make_unique<StackHistory>(stack, max_steps);
+}
+
+bool WoflangInterpreter::travel_to(uint64_t step) {
+    return history_ && history_->restore(step, stack);
+}
+
+void WoflangInterpreter::run_program(const ProgramView& program,
+                                     const std::shared_ptr<const void>& owner) {
+    // Budgets span a whole top-level line; nested calls from hosts share it.
+    // The scratch arena is rewound when the outermost line finishes.
+    CurrentScope scope(this);
+    if (exec_depth_++ == 0) begin_budget();
+    struct Depth {
+        WoflangInterpreter* self;
+        ~Depth() { if (--self->exec_depth_ == 0) self->arena_.reset(); }
+    } depth{this};
+
+    Bindings bound = bind(program, &arena_);
+    uint32_t size = static_cast<uint32_t>(program.code.size());
+    Frame frame{stack, program, owner, bound, verified_at(program, 0, size, bound, stack.size()), {}};
+    SamplingProfiler* sampler = sampler_ && sampler_->owns_thread() ? sampler_.get() : nullptr;
+    SamplingProfiler::Scope sampled(sampler, &program, sampler ? sampler->source() : nullptr);
+    // The host may have changed the stack between lines.
+    if (history_ && exec_depth_ == 1) history_->record(stack);
+    for (uint32_t pc = 0; pc < program.code.size();) {
+        const Instr& in = program.code[pc];
+        if (sampler) sampler->at(&in);
+        charge_instruction(program.symbol(in.sym));
+        pc = step(pc, frame);
+        if (history_) record_step(in, frame);
+    }
+}
+
 void WoflangInterpreter::execute_line(const std::string& line) {
-    auto tokens = tokenize(line);
-    for (const auto& [type, token] : tokens) {
-        try {
-            if (is_number(token)) {
-                WofValue val = parse_number(token);
-                stack.push(val);
+    Program program = compile(line, &arena_);
+    run_program(program.view(), nullptr);
+}
+
+void WoflangInterpreter::execute(const std::shared_ptr<const Program>& program) {
+    run_program(program->view(), program);
+}
+
+uint64_t WoflangInterpreter::op_table_fingerprint() const {
+    uint64_t h = fnv1a("ops");
+    for (const auto& [name, handler] : op_table_) h = fnv1a(std::string_view(name.c_str(), name.size() + 1), h);
+    h = fnv1a("async", h);
+    for (const auto& [name, handler] : async_op_table_) h = fnv1a(std::string_view(name.c_str(), name.size() + 1), h);
+    return h;
+}
+
+bool WoflangInterpreter::execute_file(const std::filesystem::path& path, bool use_cache) {
+    auto source = MappedFile::open(path);
+    if (!source) {
+        std::cout << "Error: cannot read " << path.string() << "\n";
+        return false;
+    }
+    uint64_t errors = op_errors();
+    if (sampler_) sampler_->set_source(path.filename().string());
+    CacheKey key;
+    key.source_hash = fnv1a(source->text());
+    key.version_hash = fnv1a(WOFLANG_VERSION);
+    key.op_table_fingerprint = op_table_fingerprint();
+    auto cache_path = path;
+    cache_path += "c";
+
+    if (use_cache) {
+        if (auto cached = MappedFile::open(cache_path)) {
+            if (auto view = deserialize(cached->text(), key)) {
+                run_program(*view, cached);
+                return op_errors() == errors;
             }
-            else {
-                auto it = op_table_.find(token);
-                if (it != op_table_.end()) {
-                    it->second(stack);
-                } else {
-                    std::cout << "Unknown op: " << token << "\n";
+        }
+    }
+    auto program = std::make_shared<Program>();
+    *program = compile(source->text(), std::pmr::get_default_resource());
+    if (use_cache) write_file_atomic(cache_path, serialize(program->view(), key));
+    run_program(program->view(), program);
+    return op_errors() == errors;
+}
+
+void WoflangInterpreter::register_async_op(const std::string& name, AsyncOpHandler handler) {
+    async_op_table_[name] = std::move(handler);
+}
+
+void WoflangInterpreter::mark_blocking(const std::string& name) {
+    blocking_ops_.insert(name);
+}
+
+Task WoflangInterpreter::execute_line_async(std::string line) {
+    // A suspended line may resume on another thread after any co_await, so the
+    // current interpreter is published per instruction instead of once per line.
+    {
+        CurrentScope scope(this);
+        begin_budget();
+    }
+    struct ArenaReset {
+        Arena& arena;
+        ~ArenaReset() { arena.reset(); }
+    } arena_reset{arena_};
+    Program compiled = compile(line, &arena_);
+    ProgramView program = compiled.view();
+    Bindings bound = bind(program, &arena_);
+    std::shared_ptr<const void> no_owner;
+    uint32_t size = static_cast<uint32_t>(program.code.size());
+    Frame frame{stack, program, no_owner, bound, verified_at(program, 0, size, bound, stack.size()), {}};
+    for (uint32_t pc = 0; pc < program.code.size();) {
+        const Instr& in = program.code[pc];
+        std::string_view token = program.symbol(in.sym);
+        {
+            CurrentScope scope(this);
+            charge_instruction(token);
+        }
+        auto ait = in.op == OpCode::Call && !bound.handlers[in.sym] ? async_op_table_.find(token)
+                                                                    : async_op_table_.end();
+        bool blocking = in.op == OpCode::Call && bound.handlers[in.sym] && !blocking_ops_.empty() &&
+                        blocking_ops_.count(token);
+        if (ait == async_op_table_.end() && !blocking) {
+            CurrentScope scope(this);
+            pc = step(pc, frame);
+            if (history_) record_step(in, frame);
+            continue;
+        }
+        try {
+            if (blocking) {
+                const StackEffect& effect = bound.effects[in.sym];
+                if (!frame.verified && effect.known() && stack.size() < effect.in) {
+                    throw std::runtime_error("stack underflow");
                 }
+                const OpHandler& handler = *bound.handlers[in.sym];
+                co_await offload([this, &handler] {
+                    CurrentScope scope(this);
+                    handler(stack);
+                });
+            } else {
+                co_await ait->second(stack);
             }
+        } catch (const BudgetExceeded&) {
+            throw;
         } catch (const std::exception& e) {
-            std::cout << "Error executing '" << token << "': " << e.what() << "\n";
+            report_error("Error executing '" + std::string(token) + "': " + e.what());
+            frame.verified = false;
+        }
+        if (history_) history_->record(stack);
+        ++pc;
+    }
+}
+
+bool WoflangInterpreter::deadline_passed() const {
+    if (cancel_requested_.load(std::memory_order_relaxed)) return true;
+    return has_deadline_ && std::chrono::steady_clock::now() >= deadline_;
+}
+
+uint64_t WoflangInterpreter::run_quotation(const Quotation& q, std::stack<WofValue>& st, bool charge,
+                                           const Bindings& bound, bool verified, const std::string* label) {
+    Frame frame{st, q.program, q.owner, bound, verified, {}};
+    SamplingProfiler* sampler = sampler_ && sampler_->owns_thread() ? sampler_.get() : nullptr;
+    SamplingProfiler::Scope sampled(sampler, &q.program, label);
+    // The op running the body (call, a word) may already have changed the
+    // stack, e.g. popped the quotation; effect hints need an exact base.
+    if (history_ && &st == &stack) history_->record(stack);
+    uint64_t steps = 0;
+    for (uint32_t pc = q.begin; pc < q.end; ++steps) {
+        const Instr& in = q.program.code[pc];
+        if (sampler) sampler->at(&in);
+        if (charge) charge_instruction(q.program.symbol(in.sym));
+        pc = step(pc, frame);
+        if (history_) record_step(in, frame);
+    }
+    return steps;
+}
+
+namespace {
+// Parallel combinators split their input into fixed-size chunks. Chunk
+// boundaries never depend on the thread count, which keeps preduce's
+// floating point association (and so its result) identical across runs.
+constexpr size_t kParallelChunk = 1024;
+
+std::shared_ptr<const Quotation> need_quotation(std::stack<WofValue>& st, const char* op) {
+    if (st.empty() || !st.top().is_quotation()) {
+        throw std::runtime_error(std::string(op) + ": expects a { ... } quotation on top");
+    }
+    auto q = st.top().quote;
+    st.pop();
+    return q;
+}
+
+// Returns a quotation taken by need_quotation when the operand below it is
+// bad, so a failed op leaves the stack as it was.
+void put_back(std::stack<WofValue>& st, std::shared_ptr<const Quotation> q) {
+    WofValue v;
+    v.quote = std::move(q);
+    st.push(std::move(v));
+}
+
+double top_or_nan(std::stack<WofValue>& st) {
+    return st.empty() ? std::numeric_limits<double>::quiet_NaN() : st.top().as_numeric();
+}
+}
+
+void WoflangInterpreter::run_chunks(size_t count, size_t per_chunk,
+                                    const std::function<uint64_t(size_t)>& chunk) {
+    size_t chunks = (count + per_chunk - 1) / per_chunk;
+    // Nested parallel work (a pmap in a pmap body) shares the outermost
+    // tally; only the outermost combinator, back on the owning thread,
+    // folds it into steps_.
+    ParallelTally own;
+    ParallelTally* tally = tls_parallel_tally ? tls_parallel_tally : &own;
+    if (tally == &own && limits_.max_instructions) {
+        own.budget = limits_.max_instructions > steps_ ? limits_.max_instructions - steps_ : 0;
+    }
+    ThreadPool::shared().parallel_for(chunks, [&](size_t c) {
+        if (deadline_passed()) throw BudgetExceeded("parallel work interrupted by resource governor");
+        ParallelScope scope(tally);
+        charge_parallel(*tally, chunk(c), limits_.max_instructions);
+    });
+    if (tally == &own) steps_ += own.steps.load();
+}
+
+void WoflangInterpreter::count_steps(uint64_t n) {
+    if (tls_parallel_tally) charge_parallel(*tls_parallel_tally, n, limits_.max_instructions);
+    else steps_ += n;
+}
+
+void WoflangInterpreter::register_parallel_ops() {
+    // Bodies run on pool workers against this interpreter: they may read
+    // words and variables but not change them (def, !, the store ops and
+    // images refuse to run there).
+    // arr { q } pmap  ->  arr'   (q maps one value to one value)
+    register_op("pmap", [this](std::stack<WofValue>& st) {
+        auto q = need_quotation(st, "pmap");
+        if (st.empty() || !st.top().is_array()) {
+            put_back(st, std::move(q));
+            throw std::runtime_error("pmap: expects an array below the quotation");
+        }
+        auto bound = bind(q->program, std::pmr::get_default_resource());
+        // Every element runs the body on a fresh one-value stack, so it is
+        // verified once for all of them.
+        bool verified = verified_at(q->program, q->begin, q->end, bound, 1);
+        auto input = st.top().array();
+        st.pop();
+        WofArray out(input->size());
+        run_chunks(input->size(), kParallelChunk, [&](size_t c) {
+            std::stack<WofValue> local;
+            uint64_t steps = 0;
+            size_t end = std::min(input->size(), (c + 1) * kParallelChunk);
+            for (size_t k = c * kParallelChunk; k < end; ++k) {
+                while (!local.empty()) local.pop();
+                local.push(WofValue((*input)[k]));
+                steps += run_quotation(*q, local, false, bound, verified);
+                out[k] = top_or_nan(local);
+            }
+            return steps;
+        });
+        st.push(WofValue::make_array(std::move(out)));
+    }, {2, 1});
+
+    // arr { q } preduce  ->  x   (q must be associative, e.g. { + })
+    register_op("preduce", [this](std::stack<WofValue>& st) {
+        auto q = need_quotation(st, "preduce");
+        if (st.empty() || !st.top().is_array() || array_size(st.top()) == 0) {
+            put_back(st, std::move(q));
+            throw std::runtime_error("preduce: expects a non-empty array below the quotation");
+        }
+        auto bound = bind(q->program, std::pmr::get_default_resource());
+        bool verified = verified_at(q->program, q->begin, q->end, bound, 2);
+        auto input = st.top().array();
+        st.pop();
+        auto fold = [&](const double* first, const double* last, uint64_t& steps) {
+            std::stack<WofValue> local;
+            double acc = *first;
+            for (const double* x = first + 1; x != last; ++x) {
+                while (!local.empty()) local.pop();
+                local.push(WofValue(acc));
+                local.push(WofValue(*x));
+                steps += run_quotation(*q, local, false, bound, verified);
+                acc = top_or_nan(local);
+            }
+            return acc;
+        };
+        size_t chunks = (input->size() + kParallelChunk - 1) / kParallelChunk;
+        WofArray partial(chunks);
+        run_chunks(input->size(), kParallelChunk, [&](size_t c) {
+            uint64_t steps = 0;
+            const double* first = input->data() + c * kParallelChunk;
+            const double* last = input->data() + std::min(input->size(), (c + 1) * kParallelChunk);
+            partial[c] = fold(first, last, steps);
+            return steps;
+        });
+        // Partials are combined left to right on this thread.
+        uint64_t steps = 0;
+        double result = fold(partial.data(), partial.data() + partial.size(), steps);
+        count_steps(steps);
+        st.push(WofValue(result));
+    }, {2, 1});
+
+    // lo hi { q } pfor  ->  arr   (q runs once per index i in [lo, hi))
+    register_op("pfor", [this](std::stack<WofValue>& st) {
+        auto q = need_quotation(st, "pfor");
+        auto bound = bind(q->program, std::pmr::get_default_resource());
+        bool verified = verified_at(q->program, q->begin, q->end, bound, 1);
+        auto hi = static_cast<long long>(st.top().as_numeric()); st.pop();
+        auto lo = static_cast<long long>(st.top().as_numeric()); st.pop();
+        size_t count = hi > lo ? static_cast<size_t>(hi - lo) : 0;
+        WofArray out(count);
+        run_chunks(count, kParallelChunk, [&](size_t c) {
+            std::stack<WofValue> local;
+            uint64_t steps = 0;
+            size_t end = std::min(count, (c + 1) * kParallelChunk);
+            for (size_t k = c * kParallelChunk; k < end; ++k) {
+                while (!local.empty()) local.pop();
+                local.push(WofValue(static_cast<double>(lo + static_cast<long long>(k))));
+                steps += run_quotation(*q, local, false, bound, verified);
+                out[k] = top_or_nan(local);
+            }
+            return steps;
+        });
+        st.push(WofValue::make_array(std::move(out)));
+    }, {3, 1});
+
+    // { q } call  ->  runs q on the current stack
+    register_op("call", [this](std::stack<WofValue>& st) {
+        auto q = need_quotation(st, "call");
+        // The arena is not thread-safe: a call inside a parallel body or an
+        // evolve candidate runs on a pool worker and binds on the heap.
+        auto bound = bind(q->program, current() == this ? scratch() : std::pmr::get_default_resource());
+        run_quotation(*q, st, true, bound, verified_at(q->program, q->begin, q->end, bound, st.size()));
+    });
+
+    // arr len  ->  n
+    register_op("len", [](std::stack<WofValue>& st) {
+        if (!st.top().is_array()) throw std::runtime_error("len: expects an array");
+        auto n = array_size(st.top());
+        if (n == kUnbounded) throw std::runtime_error("len: unbounded sequence");
+        st.pop();
+        st.push(WofValue(static_cast<double>(n)));
+    }, {1, 1});
+}
+
+void WoflangInterpreter::register_sequence_ops() {
+    // Deferred sequences: nothing is stored until a consumer materializes
+    // them, and reductions (Σ, Π, max, ...) stream them chunk by chunk.
+    auto count_arg = [](std::stack<WofValue>& st, const char* op) {
+        double n = st.top().as_numeric();
+        if (st.top().is_array() || n < 0 || n != std::floor(n)) {
+            throw std::runtime_error(std::string(op) + ": expects a non-negative integer count");
+        }
+        st.pop();
+        return static_cast<size_t>(n);
+    };
+    auto push_seq = [](std::stack<WofValue>& st, std::shared_ptr<const LazyExpr> e) {
+        WofValue v;
+        v.lazy = std::move(e);
+        st.push(std::move(v));
+    };
+
+    // a b range  ->  a, a+1, ..., b   (counts down when b < a)
+    register_op("range", [=](std::stack<WofValue>& st) {
+        double b = st.top().as_numeric(); st.pop();
+        double a = st.top().as_numeric(); st.pop();
+        double step = b >= a ? 1.0 : -1.0;
+        push_seq(st, make_range(a, step, static_cast<size_t>(std::floor(std::abs(b - a))) + 1));
+    }, {2, 1});
+
+    // n iota  ->  0, 1, ..., n-1
+    register_op("iota", [=](std::stack<WofValue>& st) {
+        push_seq(st, make_range(0.0, 1.0, count_arg(st, "iota")));
+    }, {1, 1});
+
+    // x repeat  ->  x, x, x, ...   (unbounded; bound it with take)
+    register_op("repeat", [=](std::stack<WofValue>& st) {
+        if (st.top().is_array()) throw std::runtime_error("repeat: expects a number");
+        double x = st.top().as_numeric(); st.pop();
+        push_seq(st, make_repeat(x));
+    }, {1, 1});
+
+    // seq n take  ->  first n elements
+    register_op("take", [=](std::stack<WofValue>& st) {
+        size_t n = count_arg(st, "take");
+        if (!st.top().is_array()) throw std::runtime_error("take: expects a sequence");
+        auto e = make_take(st.top(), n);
+        st.pop();
+        push_seq(st, std::move(e));
+    }, {2, 1});
+
+    // a b zip  ->  a0 b0 a1 b1 ...
+    register_op("zip", [=](std::stack<WofValue>& st) {
+        WofValue b = st.top(); st.pop();
+        WofValue a = st.top(); st.pop();
+        if (!a.is_array() || !b.is_array()) throw std::runtime_error("zip: expects two sequences");
+        push_seq(st, make_zip(a, b));
+    }, {2, 1});
+
+    // Numeric files are mapped and parsed in parallel (see numeric_text.hpp).
+    auto map_text = [](std::stack<WofValue>& st, const char* op) {
+        if (st.top().s.empty()) throw std::runtime_error(std::string(op) + ": expects a 'path");
+        auto file = MappedFile::open(st.top().s);
+        if (!file) throw std::runtime_error(std::string(op) + ": cannot read " + st.top().s);
+        st.pop();
+        return file;
+    };
+
+    // 'path load_numbers  ->  every number in the file, as one array
+    register_op("load_numbers", [=](std::stack<WofValue>& st) {
+        auto file = map_text(st, "load_numbers");
+        st.push(WofValue::make_array(parse_numbers(file->text())));
+    }, {1, 1});
+
+    // 'path load_csv  ->  col1 ... colN N
+    register_op("load_csv", [=](std::stack<WofValue>& st) {
+        auto file = map_text(st, "load_csv");
+        auto columns = parse_csv(file->text());
+        for (auto& c : columns) st.push(WofValue::make_array(std::move(c)));
+        st.push(WofValue(static_cast<int>(columns.size())));
+    });
+
+    // arr 'path save_array  ->   (binary, see array_file.hpp)
+    register_op("save_array", [=](std::stack<WofValue>& st) {
+        if (st.top().s.empty()) throw std::runtime_error("save_array: expects a 'path");
+        // Both stay on the stack until the file is written.
+        const auto& values = StackPeek::of(st);
+        const WofValue& v = values[values.size() - 2];
+        if (!v.is_array()) throw std::runtime_error("save_array: expects an array");
+        std::vector<uint64_t> shape;
+        if (v.is_matrix()) shape = {array_size(v) / v.cols, v.cols};
+        save_array_file(st.top().s, v, std::move(shape));
+        st.pop();
+        st.pop();
+    }, {2, 0});
+
+    // 'path load_array  ->  arr   (a view of the mapped file; nothing is copied)
+    // Two-dimensional files load as matrices.
+    register_op("load_array", [=](std::stack<WofValue>& st) {
+        if (st.top().s.empty()) throw std::runtime_error("load_array: expects a 'path");
+        ArrayFile file = load_array_file(st.top().s);
+        st.pop();
+        WofValue v;
+        v.lazy = make_view(file.data, file.count, std::move(file.map));
+        if (file.shape.size() == 2 && file.count > 0 && file.shape[1] <= UINT32_MAX) {
+            v.cols = static_cast<uint32_t>(file.shape[1]);
+        }
+        st.push(std::move(v));
+    }, {1, 1});
+}
+
+void WoflangInterpreter::register_word_ops() {
+    // 'name { body } def  ->  defines the word `name`
+    // No declared effect: a program that (re)defines words cannot be
+    // verified up front against the effects it was bound with.
+    register_op("def", [this](std::stack<WofValue>& st) {
+        refuse_in_parallel("def");
+        if (st.size() < 2) throw std::runtime_error("def: expects 'name { body }");
+        // The body comes off first so the name below it can be checked; a
+        // bad pair is left as it was.
+        WofValue body = std::move(st.top());
+        st.pop();
+        if (!body.is_quotation() || st.top().s.empty()) {
+            st.push(std::move(body));
+            throw std::runtime_error("def: expects 'name { body }");
         }
+        std::string name = st.top().s;
+        st.pop();
+        define_word(name, body.quote);
+    });
+
+    // value 'name !  ->  stores value in the variable `name`
+    register_op("!", [this](std::stack<WofValue>& st) {
+        refuse_in_parallel("!");
+        if (st.top().s.empty()) throw std::runtime_error("!: expects value 'name");
+        std::string name = st.top().s;
+        st.pop();
+        set_variable(name, std::move(st.top()));
+        st.pop();
+    }, {2, 0});
+}
+
+void WoflangInterpreter::define_word(const std::string& name, std::shared_ptr<const Quotation> body) {
+    // Bound once here; names defined later still resolve when called.
+    auto bound = std::make_shared<const Bindings>(bind(body->program, std::pmr::get_default_resource()));
+    auto need = required_depth(body->program, body->begin, body->end, bound->effects);
+    auto label = std::make_shared<const std::string>(name);
+    op_table_[name] = [this, body, bound, need, label](std::stack<WofValue>& st) {
+        // The word may redefine itself while it runs, destroying this
+        // handler and its captures; hold them for the duration of the call.
+        auto self_body = body;
+        auto self_bound = bound;
+        auto self_label = label;
+        bool verified = need && *need <= st.size();
+        run_quotation(*self_body, st, true, *self_bound, verified, self_label.get());
+    };
+    words_[name] = std::move(body);
+    ++words_defined_;
+    effects_.erase(name);  // a redefined op no longer has its declared effect
+}
+
+void WoflangInterpreter::set_variable(const std::string& name, WofValue value) {
+    variables_[name] = std::move(value);
+}
+
+void WoflangInterpreter::mark_pure(const std::string& name, size_t arity) {
+    auto it = op_table_.find(name);
+    if (it == op_table_.end()) {
+        throw std::runtime_error("mark_pure: unknown op '" + name + "'");
     }
+    bool added = false;
+    uint32_t id = memo_->add_op(name, arity, &added);
+    if (!added) return;  // already wrapped
+
+    // Wrap in place: bindings to the map node see the memoized handler.
+    it->second = [memo = memo_.get(), id, arity, inner = std::move(it->second)](
+                     std::stack<WofValue>& st) {
+        if (st.size() < arity) {
+            inner(st);  // let the op report its own underflow
+            return;
+        }
+        std::vector<WofValue> args(arity);
+        for (size_t k = arity; k-- > 0;) {
+            args[k] = std::move(st.top());
+            st.pop();
+        }
+        std::vector<WofValue> results;
+        if (MemoCache::cacheable(args) && memo->lookup(id, args, results)) {
+            for (auto& v : results) st.push(std::move(v));
+            return;
+        }
+        // Pure ops see only their arguments, so run on a private stack and
+        // keep whatever it leaves as the result. If it fails, the caller's
+        // stack gets its arguments back.
+        std::stack<WofValue> local;
+        for (const auto& v : args) local.push(v);
+        try {
+            inner(local);
+        } catch (...) {
+            for (auto& v : args) st.push(std::move(v));
+            throw;
+        }
+        results.resize(local.size());
+        for (size_t k = results.size(); k-- > 0;) {
+            results[k] = std::move(local.top());
+            local.pop();
+        }
+        for (const auto& v : results) st.push(v);
+        if (MemoCache::cacheable(args)) memo->insert(id, args, std::move(results));
+    };
 }
 
 void WoflangInterpreter::loadPlugin(const std::string& path) {
@@ -241,10 +1117,33 @@ void WoflangInterpreter::loadPlugin(const std::string& path) {
     auto init_func = reinterpret_cast<InitFunc>(GetProcAddress(handle, "init_plugin"));
     if (init_func) {
         init_func(&op_table_);
-        std::cout << "Loaded plugin: " << path << "\n";
+        plugins_.push_back(std::filesystem::absolute(path).string());
+        if (plugin_messages_) std::cout << "Loaded plugin: " << path << "\n";
     } else {
         std::cout << "Plugin missing init_plugin function: " << path << "\n";
     }
+    using BindFunc = void(*)(WoflangInterpreter* (*)());
+    if (auto bind_func = reinterpret_cast<BindFunc>(GetProcAddress(handle, "bind_host"))) {
+        bind_func(&WoflangInterpreter::current);
+    }
+    using PureFunc = void(*)(PureOpSink, void*);
+    if (auto pure_func = reinterpret_cast<PureFunc>(GetProcAddress(handle, "declare_pure_ops"))) {
+        pure_func([](void* self, const char* name, int arity) {
+            try {
+                static_cast<WoflangInterpreter*>(self)->mark_pure(name, static_cast<size_t>(arity));
+            } catch (const std::exception& e) {
+                std::cout << "Plugin declared pure op: " << e.what() << "\n";
+            }
+        }, this);
+    }
+    using EffectFunc = void(*)(StackEffectSink, void*);
+    if (auto effect_func = reinterpret_cast<EffectFunc>(GetProcAddress(handle, "declare_stack_effects"))) {
+        effect_func([](void* self, const char* name, int in, int out) {
+            if (in < 0 || out < 0 || in >= StackEffect::kUnknown || out >= StackEffect::kUnknown) return;
+            static_cast<WoflangInterpreter*>(self)->declare_effect(
+                name, {static_cast<uint8_t>(in), static_cast<uint8_t>(out)});
+        }, this);
+    }
 #else
     void* handle = dlopen(path.c_str(), RTLD_LAZY);
     if (!handle) {
@@ -255,10 +1154,33 @@ void WoflangInterpreter::loadPlugin(const std::string& path) {
     auto init_func = reinterpret_cast<InitFunc>(dlsym(handle, "init_plugin"));
     if (init_func) {
         init_func(&op_table_);
-        std::cout << "Loaded plugin: " << path << "\n";
+        plugins_.push_back(std::filesystem::absolute(path).string());
+        if (plugin_messages_) std::cout << "Loaded plugin: " << path << "\n";
     } else {
         std::cout << "Plugin missing init_plugin function: " << path << "\n";
     }
+    using BindFunc = void(*)(WoflangInterpreter* (*)());
+    if (auto bind_func = reinterpret_cast<BindFunc>(dlsym(handle, "bind_host"))) {
+        bind_func(&WoflangInterpreter::current);
+    }
+    using PureFunc = void(*)(PureOpSink, void*);
+    if (auto pure_func = reinterpret_cast<PureFunc>(dlsym(handle, "declare_pure_ops"))) {
+        pure_func([](void* self, const char* name, int arity) {
+            try {
+                static_cast<WoflangInterpreter*>(self)->mark_pure(name, static_cast<size_t>(arity));
+            } catch (const std::exception& e) {
+                std::cout << "Plugin declared pure op: " << e.what() << "\n";
+            }
+        }, this);
+    }
+    using EffectFunc = void(*)(StackEffectSink, void*);
+    if (auto effect_func = reinterpret_cast<EffectFunc>(dlsym(handle, "declare_stack_effects"))) {
+        effect_func([](void* self, const char* name, int in, int out) {
+            if (in < 0 || out < 0 || in >= StackEffect::kUnknown || out >= StackEffect::kUnknown) return;
+            static_cast<WoflangInterpreter*>(self)->declare_effect(
+                name, {static_cast<uint8_t>(in), static_cast<uint8_t>(out)});
+        }, this);
+    }
 #endif
 }
 
@@ -268,7 +1190,7 @@ void WoflangInterpreter::load_plugins(const std::filesystem::path& plugin_dir) {
         return;
     }
     
-    std::cout << "Loading plugins from: " << plugin_dir << "\n";
+    if (plugin_messages_) std::cout << "Loading plugins from: " << plugin_dir << "\n";
     for (auto& entry : std::filesystem::directory_iterator(plugin_dir)) {
         if (entry.is_regular_file()) {
             auto path = entry.path();
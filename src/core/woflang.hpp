@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <map>
@@ -6,23 +7,70 @@
 #include <functional>
 #include <filesystem>
 #include <memory>
+#include <mutex>
 #include <variant>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <set>
+#include <sstream>
+#include <span>
+#include <string_view>
+#include <memory_resource>
+#include "arena.hpp"
+#include "async.hpp"
+#include "bytecode.hpp"
+#include "history.hpp"
+#include "lazy.hpp"
+#include "memo.hpp"
+#include "op_profiler.hpp"
+#include "sampler.hpp"
+#include "stack_effect.hpp"
+#include "store.hpp"
 
 namespace woflang {
 
+// Flat numeric array. Shared and immutable once wrapped in a WofValue, so
+// copying values around the stack never copies the elements.
+using WofArray = std::vector<double>;
+
+// Body of a `{ ... }` block, run by call and the parallel combinators: a
+// range of compiled code plus whatever keeps that code alive (the script's
+// Program or mapped .wofc file, or a heap copy for lines compiled into the
+// scratch arena).
+struct Quotation {
+    std::shared_ptr<const void> owner;
+    ProgramView program;
+    uint32_t begin = 0;
+    uint32_t end = 0;
+};
+
 // Enhanced WofValue with proper methods that plugins expect
 struct WofValue {
-    // Core data storage
-    int i = 0;
+    // Core data storage. Integer literals and integer arithmetic keep an
+    // exact int64 in `i` (with `exact` set); `d` always mirrors the value so
+    // plugins that only read `d` keep working.
+    int64_t i = 0;
     double d = 0.0;
+    bool exact = false;
+    // Set for string values, so an empty string is still a string and not 0.
+    bool text = false;
     std::string s;
+    std::shared_ptr<const WofArray> arr;
+    std::shared_ptr<const LazyExpr> lazy;  // deferred array, see lazy.hpp
+    std::shared_ptr<const Quotation> quote;
+    // Non-zero for matrices: the array holds rows x cols elements in
+    // row-major order (see matrix.hpp). Elementwise arithmetic and
+    // reductions see the elements and give plain arrays.
+    uint32_t cols = 0;
     
     // Constructors for convenience
     WofValue() = default;
     WofValue(double val) : i(0), d(val) {}
-    WofValue(int val) : i(val), d(0.0) {}
-    WofValue(const std::string& val) : i(0), d(0.0), s(val) {}
-    WofValue(const char* val) : i(0), d(0.0), s(val) {}
+    WofValue(int val) : i(val), d(static_cast<double>(val)), exact(true) {}
+    WofValue(const std::string& val) : i(0), d(0.0), text(true), s(val) {}
+    WofValue(const char* val) : i(0), d(0.0), text(true), s(val) {}
     
     // Plugin-expected methods
     bool is_numeric() const {
@@ -30,23 +78,104 @@ struct WofValue {
     }
     
     bool is_string() const {
-        return !s.empty();
+        return text || !s.empty();
+    }
+
+    bool is_array() const { return arr != nullptr || lazy != nullptr; }
+
+    // Elements of an array value, evaluating a deferred expression if needed.
+    std::shared_ptr<const WofArray> array() const {
+        return lazy ? materialize(*lazy) : arr;
+    }
+    bool is_quotation() const { return quote != nullptr; }
+    bool is_matrix() const { return cols != 0; }
+    bool is_int() const { return exact; }
+
+    static WofValue make_int(int64_t v) {
+        WofValue r;
+        r.i = v;
+        r.d = static_cast<double>(v);
+        r.exact = true;
+        return r;
+    }
+
+    static WofValue make_array(WofArray values) {
+        WofValue v;
+        v.arr = std::make_shared<const WofArray>(std::move(values));
+        return v;
+    }
+
+    // `values` must hold a whole number of rows.
+    static WofValue make_matrix(WofArray values, uint32_t cols) {
+        WofValue v = make_array(std::move(values));
+        v.cols = cols;
+        return v;
     }
     
     double as_numeric() const {
+        if (exact) return static_cast<double>(i);
         if (d != 0.0) return d;
         if (i != 0) return static_cast<double>(i);
         return 0.0;
     }
     
     std::string to_string() const {
-        if (!s.empty()) return s;
+        if (is_string()) return s;
+        if (is_matrix()) {
+            auto values = array();
+            size_t rows = values->size() / cols;
+            std::ostringstream out;
+            out << "[";
+            for (size_t r = 0; r < std::min<size_t>(rows, 8); ++r) {
+                out << " [";
+                for (size_t c = 0; c < std::min<size_t>(cols, 8); ++c) out << " " << (*values)[r * cols + c];
+                out << (cols > 8 ? " ... ]" : " ]");
+            }
+            if (rows > 8) out << " ...";
+            out << " ] (" << rows << "x" << cols << ")";
+            return out.str();
+        }
+        if (is_array()) {
+            // Only the shown prefix is evaluated, so printing a deferred
+            // sequence never materializes it.
+            size_t n = array_size(*this);
+            std::ostringstream out;
+            out << "[";
+            for (double x : head(*this, 8)) out << " " << x;
+            if (n == kUnbounded) out << " ... (unbounded)";
+            else if (n > 8) out << " ... (" << n << " values)";
+            out << " ]";
+            return out.str();
+        }
+        if (quote) {
+            return "{ " + decompile(quote->program, quote->begin, quote->end) + "}";
+        }
+        if (exact) return std::to_string(i);
         if (d != 0.0) return std::to_string(d);
         if (i != 0) return std::to_string(i);
         return "0";
     }
 };
 
+bool is_number(std::string_view str);
+WofValue parse_number(std::string_view str);
+
+// Cooperative resource budgets for one top-level execute_line call.
+// A zero field means "unlimited"; the default-constructed limits never trip.
+struct ExecutionLimits {
+    uint64_t max_instructions = 0;          // dispatched tokens
+    std::chrono::milliseconds timeout{0};   // wall clock from the start of the line
+    size_t max_stack_depth = 0;             // values on the stack
+    size_t max_value_bytes = 0;             // approximate bytes held by stack values
+};
+
+// Thrown when a budget is exhausted. Unlike ordinary op errors this aborts the
+// rest of the line and propagates out of execute_line to the host.
+class BudgetExceeded : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
 // Plugin base class for the more complex plugins
 class WoflangPlugin {
 public:
@@ -57,14 +186,101 @@ public:
 class WoflangInterpreter {
 public:
     using OpHandler = std::function<void(std::stack<WofValue>&)>;
-    using OpTable = std::map<std::string, OpHandler>;
+    // Transparent comparator: the dispatcher looks ops up by string_view.
+    using OpTable = std::map<std::string, OpHandler, std::less<>>;
+    // Async ops may co_await sleep_for()/offload() and are suspended rather
+    // than blocking the thread when the line runs under a Scheduler.
+    using AsyncOpHandler = std::function<Task(std::stack<WofValue>&)>;
+    using AsyncOpTable = std::map<std::string, AsyncOpHandler, std::less<>>;
 
     WoflangInterpreter();
+    ~WoflangInterpreter();
 
     void register_op(const std::string& name, OpHandler handler);
+    // Register an op with a fixed stack effect. Its handler may assume the
+    // `in` values are present: lines whose depth verifies up front run it
+    // unchecked, and everywhere else the interpreter checks the depth before
+    // the call. The effect stays with the name if the op is re-registered.
+    void register_op(const std::string& name, OpHandler handler, StackEffect effect);
+    // Declare the effect of an op registered elsewhere (plugins export
+    // declare_stack_effects, see StackEffectSink).
+    void declare_effect(const std::string& name, StackEffect effect);
     void execute_line(const std::string& code);
+    // Run code compiled elsewhere, e.g. shared by an InterpreterPool.
+    void execute(const std::shared_ptr<const Program>& program);
+
+    // Run a script as one top-level execution. The compiled form is cached
+    // next to it (`x.wof` -> `x.wofc`) and mapped on later runs while the
+    // source, interpreter version and op table are unchanged. False if the
+    // file cannot be read or any op failed while it ran.
+    bool execute_file(const std::filesystem::path& path, bool use_cache = true);
+    // Changes whenever an op is added or removed (e.g. a plugin is loaded).
+    uint64_t op_table_fingerprint() const;
+
+    // Coroutine execution: spawn on a Scheduler to multiplex many sessions
+    // over a few threads. Each interpreter must run at most one line at a time.
+    // An async op reached through execute_line, or from a quotation (call,
+    // pmap, ...), is driven with sync_wait; on a Scheduler thread that is an
+    // op error rather than a deadlock, so only top-level tokens of
+    // execute_line_async may use async ops there.
+    void register_async_op(const std::string& name, AsyncOpHandler handler);
+    // Run this (synchronous) op on the scheduler's blocking pool when executed
+    // asynchronously, e.g. long plugin computations.
+    void mark_blocking(const std::string& name);
+    Task execute_line_async(std::string code);
+
+    // Memoize an already registered op that is pure (output depends only on
+    // its top `arity` arguments, no side effects). Repeated calls with equal
+    // numeric/string arguments replay the cached results. Plugins opt in by
+    // exporting declare_pure_ops (see PureOpSink).
+    void mark_pure(const std::string& name, size_t arity);
+    MemoCache& memo() { return *memo_; }
+
     void loadPlugin(const std::string& path);
     void load_plugins(const std::filesystem::path& plugin_dir);
+    const std::vector<std::string>& plugins() const { return plugins_; }
+    bool has_op(std::string_view name) const { return op_table_.find(name) != op_table_.end(); }
+    // "Loaded plugin" progress lines, on by default; failures always print.
+    void set_plugin_messages(bool on) { plugin_messages_ = on; }
+
+    // User words (`'name { body } def`) and variables (`value 'name !`).
+    // Both are called by bare name; ops take precedence over variables.
+    void define_word(const std::string& name, std::shared_ptr<const Quotation> body);
+    // Words defined (or redefined) since construction, so a host can tell
+    // whether a run changed the op table.
+    uint64_t words_defined() const { return words_defined_; }
+    void set_variable(const std::string& name, WofValue value);
+    void clear_variables() { variables_.clear(); }
+
+    // Snapshot of the stack, words, variables and loaded plugin paths. The
+    // image is mapped on load and word bodies run from the mapping in place.
+    // load_image re-loads listed plugins not loaded yet and replaces the
+    // stack; it returns false (state unchanged) for a missing or bad image.
+    // Scripts reach both through the save_image and load_image ops.
+    void save_image(const std::filesystem::path& path) const;
+    bool load_image(const std::filesystem::path& path);
+
+    // Time-travel debugging. While recording, every instruction that changes
+    // the stack becomes a step (see StackHistory); travel_to() puts the
+    // stack back as it was at a retained step, and running code from there
+    // discards the steps after it.
+    void record_history(size_t max_steps);
+    void stop_history() { history_.reset(); }
+    const StackHistory* history() const { return history_.get(); }
+    bool travel_to(uint64_t step);
+
+    // Per-op calls, time and (optionally) hardware counters; see OpProfiler.
+    void start_profiler(bool hardware_counters) { profiler_ = std::make_unique<OpProfiler>(hardware_counters); }
+    void stop_profiler() { profiler_.reset(); }
+    OpProfiler* profiler() { return profiler_.get(); }
+    // Statistical profile of Woflang code by word and line; see
+    // SamplingProfiler. Throws if sampling cannot be started.
+    void start_sampler(unsigned hz) {
+        sampler_.reset();
+        sampler_ = std::make_unique<SamplingProfiler>(hz);
+    }
+    void stop_sampler() { sampler_.reset(); }
+    SamplingProfiler* sampler() { return sampler_.get(); }
 
     // Stack access for plugin compatibility
     std::stack<WofValue> stack;
@@ -78,11 +294,149 @@ public:
         return val; 
     }
     void clear_stack() { while (!stack.empty()) stack.pop(); }
+    // Op failures (unknown op, underflow, op threw) printed and skipped over
+    // since construction; lets hosts tell a clean run from a noisy one.
+    uint64_t op_errors() const { return op_errors_.load(std::memory_order_relaxed); }
+    // With capture on, their messages collect here instead of going to
+    // stdout, so a host running requests on several interpreters at once
+    // can hand each one its own. take_errors() returns and clears them.
+    void capture_errors(bool on);
+    std::string take_errors();
+
+    // Resource governor
+    void set_limits(const ExecutionLimits& limits) { limits_ = limits; }
+    const ExecutionLimits& limits() const { return limits_; }
+    uint64_t instructions_executed() const { return steps_; }
+
+    // Request that the running line stops at its next check. Safe to call
+    // from another thread (e.g. a watchdog enforcing an SLO).
+    void cancel() { cancel_requested_.store(true, std::memory_order_relaxed); }
+
+    // Cheap poll for long-running ops: true once the deadline has passed or
+    // cancel() was called. Reads the clock only every kYieldClockStride polls.
+    bool should_yield() {
+        if (cancel_requested_.load(std::memory_order_relaxed)) return true;
+        if (!has_deadline_ || ++yield_polls_ % kYieldClockStride != 0) return false;
+        return std::chrono::steady_clock::now() >= deadline_;
+    }
+
+    // Interpreter running execute_line on the calling thread, or null.
+    static WoflangInterpreter* current();
+    // Parallel bodies (pmap, preduce, pfor, evolve candidates) share this
+    // interpreter's words, variables and store without locking, so ops that
+    // change them call this first; it throws on a thread running such a body.
+    static void refuse_in_parallel(const char* op);
+
+    // Scratch memory for the current top-level execution. Everything
+    // allocated here is released in bulk when the line finishes, so results
+    // that outlive the op must be copied out (e.g. into a WofValue).
+    std::pmr::memory_resource* scratch() { return &arena_; }
 
 private:
+    static constexpr uint32_t kYieldClockStride = 64;
+    static constexpr uint64_t kBudgetCheckStride = 64;
+
+    // Handlers and declared effects resolved per program symbol (null
+    // handler: look the name up when called).
+    struct Bindings {
+        std::pmr::vector<const OpHandler*> handlers;
+        std::pmr::vector<StackEffect> effects;
+    };
+
+    // Evaluation state for one run over compiled code: the stack it runs on,
+    // the depths recorded by pending '[' marks, and the bindings. `verified`
+    // means the entry depth satisfied required_depth(), so calls skip the
+    // depth check; it is cleared as soon as an op fails part way.
+    struct Frame {
+        std::stack<WofValue>& stack;
+        const ProgramView& program;
+        const std::shared_ptr<const void>& owner;
+        const Bindings& bound;
+        bool verified;
+        std::vector<size_t> marks;
+    };
+
+    Bindings bind(const ProgramView& program, std::pmr::memory_resource* mr) const;
+    // Whether code[begin, end) verifies when entered with `depth` values.
+    static bool verified_at(const ProgramView& program, uint32_t begin, uint32_t end,
+                            const Bindings& bound, size_t depth);
+    void run_program(const ProgramView& program, const std::shared_ptr<const void>& owner);
+    uint32_t step(uint32_t pc, Frame& frame);
+    void record_step(const Instr& in, const Frame& frame);
+    bool dispatch_token(std::string_view token, std::stack<WofValue>& st,
+                        const OpHandler* handler = nullptr);
+    // Counts an op error and prints or captures its message (one line).
+    void report_error(const std::string& message);
+    // `label` names the frame for the sampling profiler (a word's name).
+    uint64_t run_quotation(const Quotation& q, std::stack<WofValue>& st, bool charge,
+                           const Bindings& bound, bool verified = false, const std::string* label = nullptr);
+    // Runs chunk(c) for each of the ceil(count / per_chunk) chunks on the
+    // shared pool; chunk returns the instructions it ran, which are charged
+    // against the budget.
+    void run_chunks(size_t count, size_t per_chunk, const std::function<uint64_t(size_t)>& chunk);
+    void register_parallel_ops();
+    void register_sequence_ops();
+    void register_word_ops();
+    void register_evolve_ops();
+    void register_store_ops();
+    void register_matrix_ops();
+    void register_image_ops();
+    ValueStore& value_store();  // opened on first use
+    bool deadline_passed() const;
+    void begin_budget();
+    void charge_instruction(std::string_view token);
+    // Adds instructions run outside charge_instruction, e.g. preduce's
+    // final fold; inside parallel work they go to the shared tally.
+    void count_steps(uint64_t n);
+    size_t stack_value_bytes() const;
+
     OpTable op_table_;
+    std::map<std::string, StackEffect, std::less<>> effects_;
+    std::map<std::string, std::shared_ptr<const Quotation>, std::less<>> words_;
+    uint64_t words_defined_ = 0;
+    std::map<std::string, WofValue, std::less<>> variables_;
+    std::vector<std::string> plugins_;  // absolute paths, in load order
+    bool plugin_messages_ = true;
+    AsyncOpTable async_op_table_;
+    std::set<std::string, std::less<>> blocking_ops_;
+    Arena arena_;
+    std::unique_ptr<MemoCache> memo_;
+    std::unique_ptr<StackHistory> history_;
+    std::unique_ptr<OpProfiler> profiler_;
+    std::unique_ptr<SamplingProfiler> sampler_;
+    std::unique_ptr<ValueStore> store_;
+
+    ExecutionLimits limits_;
+    uint64_t steps_ = 0;
+    std::atomic<uint64_t> op_errors_{0};  // also counted by ops on pool workers
+    std::mutex errors_mutex_;
+    bool capture_errors_ = false;
+    std::string captured_errors_;
+    bool has_deadline_ = false;
+    std::chrono::steady_clock::time_point deadline_{};
+    uint32_t yield_polls_ = 0;
+    int exec_depth_ = 0;
+    std::atomic<bool> cancel_requested_{false};
 };
 
+// Plugins are separate modules, so they cannot see the host's notion of the
+// running interpreter directly. A plugin that wants to poll should_yield()
+// adds WOFLANG_PLUGIN_BIND_HOST() once; the loader then hands it the host's
+// lookup function. Inside the core this is set by the interpreter itself.
+inline WoflangInterpreter* (*host_current_interpreter)() = nullptr;
+
+inline bool should_yield() {
+    WoflangInterpreter* interp = host_current_interpreter ? host_current_interpreter() : nullptr;
+    return interp && interp->should_yield();
+}
+
+// Per-execution scratch arena of the running interpreter (see scratch()),
+// or the global heap when called outside an execution or on a worker thread.
+inline std::pmr::memory_resource* scratch_resource() {
+    WoflangInterpreter* interp = host_current_interpreter ? host_current_interpreter() : nullptr;
+    return interp ? interp->scratch() : std::pmr::get_default_resource();
+}
+
 } // namespace woflang
 
 // Plugin export macro for Windows/cross-platform compatibility
@@ -90,4 +444,9 @@ private:
     #define WOFLANG_PLUGIN_EXPORT extern "C" __declspec(dllexport)
 #else
     #define WOFLANG_PLUGIN_EXPORT extern "C"
-#endif
\ No newline at end of file
+#endif
+
+#define WOFLANG_PLUGIN_BIND_HOST()                                              \
+    WOFLANG_PLUGIN_EXPORT void bind_host(woflang::WoflangInterpreter* (*current)()) { \
+        woflang::host_current_interpreter = current;                            \
+    }
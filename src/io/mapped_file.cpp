@@ -0,0 +1,157 @@
+#include "mapped_file.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <string>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace woflang {
+
+std::shared_ptr<const MappedFile> MappedFile::open(const std::filesystem::path& path) {
+    std::shared_ptr<MappedFile> file(new MappedFile());
+#ifdef _WIN32
+    HANDLE h = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                           nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) return nullptr;
+    file->file_ = h;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(h, &size)) return nullptr;
+    file->size_ = static_cast<size_t>(size.QuadPart);
+    if (file->size_ == 0) return file;
+    HANDLE m = CreateFileMappingW(h, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m) return nullptr;
+    file->mapping_ = m;
+    file->data_ = static_cast<const std::byte*>(MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0));
+    if (!file->data_) return nullptr;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return nullptr;
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return nullptr;
+    }
+    file->size_ = static_cast<size_t>(st.st_size);
+    if (file->size_ > 0) {
+        void* p = ::mmap(nullptr, file->size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            return nullptr;
+        }
+        file->data_ = static_cast<const std::byte*>(p);
+    }
+    ::close(fd);
+#endif
+    return file;
+}
+
+MappedFile::~MappedFile() {
+#ifdef _WIN32
+    if (data_) UnmapViewOfFile(data_);
+    if (mapping_) CloseHandle(mapping_);
+    if (file_) CloseHandle(file_);
+#else
+    if (data_) ::munmap(const_cast<std::byte*>(data_), size_);
+#endif
+}
+
+#ifdef _WIN32
+AtomicFile::AtomicFile(std::filesystem::path path) : path_(std::move(path)) {
+    static std::atomic<unsigned> counter{0};
+    for (int attempt = 0; attempt < 100 && !file_; ++attempt) {
+        tmp_ = path_;
+        tmp_ += ".tmp" + std::to_string(GetCurrentProcessId()) + "." + std::to_string(counter++);
+        HANDLE h = CreateFileW(tmp_.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (h != INVALID_HANDLE_VALUE) file_ = h;
+        else if (GetLastError() != ERROR_FILE_EXISTS) break;
+    }
+    ok_ = file_ != nullptr;
+}
+
+AtomicFile::~AtomicFile() {
+    if (file_) CloseHandle(file_);
+    if (!committed_ && !tmp_.empty()) DeleteFileW(tmp_.c_str());
+}
+
+bool AtomicFile::write(const void* data, size_t size) {
+    auto* p = static_cast<const char*>(data);
+    while (ok_ && size > 0) {
+        DWORD chunk = static_cast<DWORD>((std::min<size_t>)(size, 1u << 30)), written = 0;
+        ok_ = WriteFile(file_, p, chunk, &written, nullptr) && written > 0;
+        p += written;
+        size -= written;
+    }
+    return ok_;
+}
+
+bool AtomicFile::commit() {
+    if (!ok_) return false;
+    ok_ = FlushFileBuffers(file_) != 0;
+    CloseHandle(file_);
+    file_ = nullptr;
+    ok_ = ok_ && MoveFileExW(tmp_.c_str(), path_.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+    committed_ = ok_;
+    return ok_;
+}
+#else
+AtomicFile::AtomicFile(std::filesystem::path path) : path_(std::move(path)) {
+    std::string name = path_.string() + ".XXXXXX";
+    fd_ = ::mkstemp(name.data());
+    if (fd_ < 0) return;
+    tmp_ = name;
+    struct stat st;
+    mode_t mode = ::stat(path_.c_str(), &st) == 0 ? (st.st_mode & 07777) : 0644;
+    ok_ = ::fchmod(fd_, mode) == 0;
+}
+
+AtomicFile::~AtomicFile() {
+    if (fd_ >= 0) ::close(fd_);
+    if (!committed_ && !tmp_.empty()) ::unlink(tmp_.c_str());
+}
+
+bool AtomicFile::write(const void* data, size_t size) {
+    auto* p = static_cast<const char*>(data);
+    while (ok_ && size > 0) {
+        ssize_t n = ::write(fd_, p, size);
+        if (n < 0 && errno == EINTR) continue;
+        ok_ = n > 0;
+        if (ok_) {
+            p += n;
+            size -= static_cast<size_t>(n);
+        }
+    }
+    return ok_;
+}
+
+bool AtomicFile::commit() {
+    if (!ok_) return false;
+    ok_ = ::fsync(fd_) == 0;
+    ok_ = ::close(fd_) == 0 && ok_;
+    fd_ = -1;
+    ok_ = ok_ && ::rename(tmp_.c_str(), path_.c_str()) == 0;
+    if (!ok_) return false;
+    committed_ = true;
+    // The rename is durable once the directory is synced.
+    auto dir = path_.parent_path();
+    int dfd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dfd >= 0) {
+        ::fsync(dfd);
+        ::close(dfd);
+    }
+    return true;
+}
+#endif
+
+bool write_file_atomic(const std::filesystem::path& path, std::string_view bytes) {
+    AtomicFile file(path);
+    return file.write(bytes.data(), bytes.size()) && file.commit();
+}
+
+} // namespace woflang
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+
+namespace woflang {
+
+// Read-only memory mapping of a whole file. Shared ownership lets values and
+// compiled programs that point into the mapping keep it alive.
+class MappedFile {
+public:
+    // Maps `path`, or returns null if it does not exist or cannot be mapped.
+    static std::shared_ptr<const MappedFile> open(const std::filesystem::path& path);
+
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const std::byte* data() const { return data_; }
+    size_t size() const { return size_; }
+    std::string_view text() const { return {reinterpret_cast<const char*>(data_), size_}; }
+
+private:
+    MappedFile() = default;
+
+    const std::byte* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#endif
+};
+
+// A file written under a unique temporary name in the target's directory
+// and renamed over the target by commit(), after the data and then the
+// directory entry are synced: concurrent readers, concurrent writers and a
+// crash all leave either the old file or the complete new one. Destroying
+// it uncommitted removes the temporary. A replaced file keeps its mode; a
+// new one is created 0644.
+class AtomicFile {
+public:
+    explicit AtomicFile(std::filesystem::path path);
+    ~AtomicFile();
+
+    AtomicFile(const AtomicFile&) = delete;
+    AtomicFile& operator=(const AtomicFile&) = delete;
+
+    // False once any step has failed; later calls then do nothing.
+    bool ok() const { return ok_; }
+    bool write(const void* data, size_t size);
+    bool commit();
+
+private:
+    std::filesystem::path path_;
+    std::filesystem::path tmp_;
+    bool ok_ = false;
+    bool committed_ = false;
+#ifdef _WIN32
+    void* file_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+};
+
+// Write `bytes` to `path` through an AtomicFile.
+bool write_file_atomic(const std::filesystem::path& path, std::string_view bytes);
+
+} // namespace woflang
@@ -0,0 +1,205 @@
+#include "numeric_text.hpp"
+#include "../core/thread_pool.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <utility>
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define WOFLANG_AVX2_SCAN 1
+#endif
+
+namespace woflang {
+
+namespace {
+
+constexpr size_t kMinChunk = size_t(1) << 20;  // bytes; smaller inputs parse on one thread
+constexpr size_t kBlock = 64;
+constexpr double kMissing = std::numeric_limits<double>::quiet_NaN();
+
+struct Separators {
+    explicit Separators(std::string_view list) : count(list.size()) {
+        std::copy(list.begin(), list.end(), chars.begin());
+        for (unsigned char c : list) table[c] = true;
+    }
+    std::array<char, 8> chars{};
+    size_t count;
+    std::array<bool, 256> table{};
+};
+
+// Bit k is set when p[k] is a separator; p has kBlock readable bytes.
+using BlockMask = uint64_t (*)(const char* p, const Separators& seps);
+
+uint64_t block_mask_scalar(const char* p, const Separators& seps) {
+    uint64_t m = 0;
+    for (size_t k = 0; k < kBlock; ++k) {
+        m |= uint64_t(seps.table[static_cast<unsigned char>(p[k])]) << k;
+    }
+    return m;
+}
+
+#ifdef WOFLANG_AVX2_SCAN
+__attribute__((target("avx2"))) uint64_t block_mask_avx2(const char* p, const Separators& seps) {
+    __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+    __m256i hit_lo = _mm256_setzero_si256();
+    __m256i hit_hi = _mm256_setzero_si256();
+    for (size_t k = 0; k < seps.count; ++k) {
+        __m256i c = _mm256_set1_epi8(seps.chars[k]);
+        hit_lo = _mm256_or_si256(hit_lo, _mm256_cmpeq_epi8(lo, c));
+        hit_hi = _mm256_or_si256(hit_hi, _mm256_cmpeq_epi8(hi, c));
+    }
+    return uint64_t(uint32_t(_mm256_movemask_epi8(hit_lo))) |
+           uint64_t(uint32_t(_mm256_movemask_epi8(hit_hi))) << 32;
+}
+#endif
+
+BlockMask block_mask() {
+#ifdef WOFLANG_AVX2_SCAN
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    if (avx2) return block_mask_avx2;
+#endif
+    return block_mask_scalar;
+}
+
+// Calls field(first, last, ends_line) for each run between separators in
+// [begin, end). Input that does not end in a newline still ends a line.
+template <class Field>
+void for_each_field(const char* begin, const char* end, const Separators& seps, Field&& field) {
+    BlockMask mask = block_mask();
+    const char* start = begin;
+    auto emit = [&](const char* at) {
+        field(start, at, *at == '\n');
+        start = at + 1;
+    };
+    const char* p = begin;
+    for (; static_cast<size_t>(end - p) >= kBlock; p += kBlock) {
+        for (uint64_t m = mask(p, seps); m; m &= m - 1) emit(p + std::countr_zero(m));
+    }
+    for (; p < end; ++p) {
+        if (seps.table[static_cast<unsigned char>(*p)]) emit(p);
+    }
+    if (start < end) field(start, end, true);
+}
+
+bool is_padding(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '"'; }
+
+bool blank(const char* first, const char* last) {
+    return std::all_of(first, last, is_padding);
+}
+
+bool to_number(const char* first, const char* last, double& out) {
+    while (first < last && is_padding(*first)) ++first;
+    while (last > first && is_padding(last[-1])) --last;
+    if (first < last && *first == '+') ++first;
+    auto r = std::from_chars(first, last, out);
+    return r.ec == std::errc() && r.ptr == last && first < last;
+}
+
+// Cuts `text` after newlines into roughly equal chunks, a few per worker.
+std::vector<std::pair<const char*, const char*>> split_lines(std::string_view text) {
+    size_t parts = std::clamp<size_t>(text.size() / kMinChunk, 1, ThreadPool::shared().size() * 4);
+    std::vector<std::pair<const char*, const char*>> chunks;
+    const char* base = text.data();
+    size_t begin = 0;
+    for (size_t k = 1; k <= parts && begin < text.size(); ++k) {
+        size_t end = std::max(begin, text.size() * k / parts);
+        if (end < text.size()) {
+            size_t nl = text.find('\n', end);
+            end = nl == std::string_view::npos ? text.size() : nl + 1;
+        }
+        chunks.push_back({base + begin, base + end});
+        begin = end;
+    }
+    return chunks;
+}
+
+std::vector<double> concat(std::vector<std::vector<double>>& parts) {
+    if (parts.size() == 1) return std::move(parts.front());
+    size_t total = 0;
+    for (const auto& p : parts) total += p.size();
+    std::vector<double> out;
+    out.reserve(total);
+    for (const auto& p : parts) out.insert(out.end(), p.begin(), p.end());
+    return out;
+}
+
+} // namespace
+
+std::vector<double> parse_numbers(std::string_view text) {
+    Separators seps(" \t\r\n,;");
+    auto chunks = split_lines(text);
+    std::vector<std::vector<double>> parts(chunks.size());
+    ThreadPool::shared().parallel_for(chunks.size(), [&](size_t c) {
+        auto [begin, end] = chunks[c];
+        auto& out = parts[c];
+        out.reserve(static_cast<size_t>(end - begin) / 16);
+        for_each_field(begin, end, seps, [&](const char* first, const char* last, bool) {
+            double x;
+            if (first != last && to_number(first, last, x)) out.push_back(x);
+        });
+    });
+    return chunks.empty() ? std::vector<double>{} : concat(parts);
+}
+
+std::vector<std::vector<double>> parse_csv(std::string_view text) {
+    size_t nl = text.find('\n');
+    std::string_view first_line = text.substr(0, nl == std::string_view::npos ? text.size() : nl + 1);
+    size_t commas = std::count(first_line.begin(), first_line.end(), ',');
+    size_t semicolons = std::count(first_line.begin(), first_line.end(), ';');
+    size_t tabs = std::count(first_line.begin(), first_line.end(), '\t');
+    char delim = semicolons > commas && semicolons >= tabs ? ';' : tabs > commas ? '\t' : ',';
+    Separators seps(std::string{delim, '\n'});
+
+    size_t ncols = 0;
+    bool header = false;
+    for_each_field(first_line.data(), first_line.data() + first_line.size(), seps,
+                   [&](const char* first, const char* last, bool) {
+                       double x;
+                       ++ncols;
+                       if (!blank(first, last) && !to_number(first, last, x)) header = true;
+                   });
+    if (ncols == 0) return {};
+    std::string_view rows = header ? text.substr(first_line.size()) : text;
+
+    auto chunks = split_lines(rows);
+    std::vector<std::vector<std::vector<double>>> parts(chunks.size(),
+                                                        std::vector<std::vector<double>>(ncols));
+    ThreadPool::shared().parallel_for(chunks.size(), [&](size_t c) {
+        auto [begin, end] = chunks[c];
+        auto& cols = parts[c];
+        size_t col = 0;
+        bool empty_line = true;
+        for_each_field(begin, end, seps, [&](const char* first, const char* last, bool ends_line) {
+            if (col < ncols) {
+                double x;
+                cols[col].push_back(to_number(first, last, x) ? x : kMissing);
+            }
+            empty_line = empty_line && blank(first, last);
+            ++col;
+            if (!ends_line) return;
+            if (col == 1 && empty_line) {
+                cols[0].pop_back();  // blank line, not a row
+            } else {
+                for (size_t k = col; k < ncols; ++k) cols[k].push_back(kMissing);
+            }
+            col = 0;
+            empty_line = true;
+        });
+    });
+
+    std::vector<std::vector<double>> columns(ncols);
+    for (size_t k = 0; k < ncols; ++k) {
+        std::vector<std::vector<double>> pieces;
+        pieces.reserve(parts.size());
+        for (auto& p : parts) pieces.push_back(std::move(p[k]));
+        columns[k] = pieces.empty() ? std::vector<double>{} : concat(pieces);
+    }
+    return columns;
+}
+
+} // namespace woflang
@@ -0,0 +1,23 @@
+#pragma once
+#include <string_view>
+#include <vector>
+
+namespace woflang {
+
+// Parsers behind load_numbers and load_csv. The text is cut at newlines
+// into chunks parsed in parallel on the shared thread pool. Within a chunk,
+// separators are found 64 bytes at a time (with AVX2 when the CPU has it)
+// and each field is converted with std::from_chars.
+
+// Every number in `text`, in order. Fields are separated by whitespace,
+// commas or semicolons; fields that are not numbers are skipped.
+std::vector<double> parse_numbers(std::string_view text);
+
+// Columns of comma, semicolon or tab separated text (whichever is most
+// common in the first line). A first line that is not all numbers is a
+// header and skipped. The first row fixes the column count: short rows are
+// padded with NaN, extra cells ignored, and cells that are not numbers read
+// as NaN.
+std::vector<std::vector<double>> parse_csv(std::string_view text);
+
+} // namespace woflang
@@ -0,0 +1,107 @@
+#include "statement_reader.hpp"
+#include <cerrno>
+#include <thread>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace woflang {
+
+namespace {
+
+constexpr size_t kBlockSize = size_t(1) << 20;
+constexpr size_t kMaxReadyBatches = 4;  // bounds read-ahead on huge inputs
+
+// Whatever is available, up to `size` bytes; 0 at end of input. Unlike
+// fread this does not wait for a full block, so a slow producer's lines
+// run as they arrive.
+size_t read_some(std::FILE* in, char* buf, size_t size) {
+#ifdef _WIN32
+    int n = _read(_fileno(in), buf, static_cast<unsigned>(size));
+#else
+    ssize_t n;
+    do {
+        n = ::read(fileno(in), buf, size);
+    } while (n < 0 && errno == EINTR);
+#endif
+    return n > 0 ? static_cast<size_t>(n) : 0;
+}
+
+} // namespace
+
+StatementReader::StatementReader(std::FILE* in) {
+    std::thread([queue = queue_, in] { read_loop(queue, in); }).detach();
+}
+
+StatementReader::~StatementReader() {
+    {
+        std::lock_guard<std::mutex> lock(queue_->mutex);
+        queue_->stop = true;
+    }
+    queue_->cv.notify_all();
+}
+
+void StatementReader::publish(Queue& queue, std::unique_ptr<Batch> batch) {
+    std::unique_lock<std::mutex> lock(queue.mutex);
+    queue.cv.wait(lock, [&] { return queue.stop || queue.ready.size() < kMaxReadyBatches; });
+    if (!queue.stop) queue.ready.push_back(std::move(batch));
+    queue.cv.notify_all();
+}
+
+void StatementReader::read_loop(const std::shared_ptr<Queue>& queue, std::FILE* in) {
+    std::string carry;  // a line split across blocks
+    std::vector<char> block(kBlockSize);
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(queue->mutex);
+            if (queue->stop) break;
+        }
+        size_t n = read_some(in, block.data(), block.size());
+        auto batch = std::make_unique<Batch>();
+        batch->text = std::move(carry);
+        carry.clear();
+        batch->text.append(block.data(), n);
+        if (n > 0) {
+            size_t last = batch->text.rfind('\n');
+            if (last == std::string::npos) {
+                carry = std::move(batch->text);
+                continue;
+            }
+            carry.assign(batch->text, last + 1);
+            batch->text.resize(last + 1);
+        }
+        std::string_view text = batch->text;
+        for (size_t pos = 0; pos < text.size();) {
+            size_t end = text.find('\n', pos);
+            if (end == std::string_view::npos) end = text.size();
+            std::string_view line = text.substr(pos, end - pos);
+            auto program = std::make_shared<Program>();
+            *program = compile(line, std::pmr::get_default_resource());
+            batch->statements.push_back({line, std::move(program)});
+            pos = end + 1;
+        }
+        if (!batch->statements.empty()) publish(*queue, std::move(batch));
+        if (n == 0) break;
+    }
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    queue->done = true;
+    queue->cv.notify_all();
+}
+
+bool StatementReader::next(Statement& out) {
+    while (!current_ || index_ == current_->statements.size()) {
+        std::unique_lock<std::mutex> lock(queue_->mutex);
+        queue_->cv.wait(lock, [&] { return !queue_->ready.empty() || queue_->done; });
+        if (queue_->ready.empty()) return false;
+        current_ = std::move(queue_->ready.front());
+        queue_->ready.pop_front();
+        index_ = 0;
+        queue_->cv.notify_all();
+    }
+    out = current_->statements[index_++];
+    return true;
+}
+
+} // namespace woflang
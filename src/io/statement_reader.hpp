@@ -0,0 +1,58 @@
+#pragma once
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../core/bytecode.hpp"
+
+namespace woflang {
+
+// Input for batch mode (`woflang < job.wof`). A background thread reads the
+// stream in large blocks, cuts it into lines and compiles each line, so the
+// next block is read and compiled while the current one runs. A line is a
+// statement, exactly as typed at the REPL.
+class StatementReader {
+public:
+    struct Statement {
+        std::string_view text;  // without the newline; valid until the next call
+        std::shared_ptr<const Program> program;
+    };
+
+    explicit StatementReader(std::FILE* in);
+    // Stops reading; input not yet consumed is dropped.
+    ~StatementReader();
+
+    StatementReader(const StatementReader&) = delete;
+    StatementReader& operator=(const StatementReader&) = delete;
+
+    // The next statement in input order; false at end of input.
+    bool next(Statement& out);
+
+private:
+    struct Batch {
+        std::string text;  // the lines the statements point into
+        std::vector<Statement> statements;
+    };
+    // Shared with the reader thread, which may outlive this object while it
+    // waits on a silent pipe.
+    struct Queue {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<std::unique_ptr<Batch>> ready;
+        bool done = false;
+        bool stop = false;
+    };
+
+    static void read_loop(const std::shared_ptr<Queue>& queue, std::FILE* in);
+    static void publish(Queue& queue, std::unique_ptr<Batch> batch);
+
+    std::shared_ptr<Queue> queue_ = std::make_shared<Queue>();
+    std::unique_ptr<Batch> current_;
+    size_t index_ = 0;
+};
+
+} // namespace woflang
@@ -57,6 +57,33 @@ std::vector<std::pair<std::string, std::string>> tokenize(const std::string& inp
     return tokens;
 }
 
+std::pmr::vector<std::string_view> tokenize_views(std::string_view input,
+                                                  std::pmr::memory_resource* mr) {
+    std::pmr::vector<std::string_view> tokens(mr);
+    tokens.reserve(input.size() / 4 + 4);
+    size_t start = std::string_view::npos;
+    for (size_t i = 0; i < input.size(); ++i) {
+        char c = input[i];
+        bool space = std::isspace(static_cast<unsigned char>(c));
+        bool punct = c == '(' || c == ')' || c == '[' || c == ']' ||
+                     c == '{' || c == '}' || c == ',' || c == ';';
+        if (space || punct) {
+            if (start != std::string_view::npos) {
+                tokens.push_back(input.substr(start, i - start));
+                start = std::string_view::npos;
+            }
+            if (punct) tokens.push_back(input.substr(i, 1));
+        } else if (start == std::string_view::npos && c == '#') {
+            // Comment to end of line (only at the start of a token).
+            while (i + 1 < input.size() && input[i + 1] != '\n') ++i;
+        } else if (start == std::string_view::npos) {
+            start = i;
+        }
+    }
+    if (start != std::string_view::npos) tokens.push_back(input.substr(start));
+    return tokens;
+}
+
 std::string classify(const std::string& token) {
     if (keyword_table.count(token)) return keyword_table[token];
     if (symbol_table.count(token)) return symbol_table[token];
@@ -1,10 +1,18 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
 #include <utility>
+#include <memory_resource>
 
 namespace woflang {
     void register_symbol(const std::string& symbol, const std::string& name);
     void register_keyword(const std::string& keyword, const std::string& name);
     std::vector<std::pair<std::string, std::string>> tokenize(const std::string& input);
+    // Same splitting rules as tokenize(), without classification: views into
+    // `input` stored in an array from `mr`, so no per-token strings are made.
+    // A `#` at the start of a token comments out the rest of the line.
+    std::pmr::vector<std::string_view> tokenize_views(std::string_view input,
+                                                      std::pmr::memory_resource* mr);
 }
+
@@ -0,0 +1,46 @@
+#!/usr/bin/env bash
+# Several woflang processes appending to one value store at the same time
+# must not lose or interleave records.
+# usage: tests/store_concurrency.sh [path/to/woflang]
+set -euo pipefail
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+BIN="${1:-${ROOT}/build/bin/woflang}"
+if [[ ! -x "$BIN" ]]; then
+  echo "missing $BIN — build first"; exit 1
+fi
+WORK="$(mktemp -d)"
+trap 'rm -rf "$WORK"' EXIT
+export WOFLANG_STORE="$WORK/shared.store"
+
+procs=8
+for p in $(seq 1 $procs); do
+  {
+    echo "1 200000 range 'big$p store"
+    for k in $(seq 1 50); do echo "$p$k 'small${p}_$k store"; done
+  } > "$WORK/writer$p.wof"
+done
+for p in $(seq 1 $procs); do "$BIN" "$WORK/writer$p.wof" > "$WORK/writer$p.out" & done
+fail=0
+for job in $(jobs -p); do wait "$job" || fail=1; done
+if [[ $fail -ne 0 ]]; then echo "FAIL: a writer exited with an error"; exit 1; fi
+
+# A fresh process must see every record, whole.
+{
+  for p in $(seq 1 $procs); do
+    echo "'big$p fetch len ."
+    for k in $(seq 1 50); do echo "'small${p}_$k fetch ."; done
+  done
+} > "$WORK/check.wof"
+"$BIN" "$WORK/check.wof" > "$WORK/check.out" || true
+{
+  for p in $(seq 1 $procs); do
+    echo 200000
+    for k in $(seq 1 50); do echo "$p$k"; done
+  done
+} > "$WORK/expected.out"
+if ! diff -q "$WORK/expected.out" "$WORK/check.out" > /dev/null; then
+  echo "FAIL: records missing or damaged"
+  diff "$WORK/expected.out" "$WORK/check.out" | head -20
+  exit 1
+fi
+echo "PASS: $procs writers, $((procs * 51)) records"
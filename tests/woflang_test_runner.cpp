@@ -1,295 +1,339 @@
-// tests/woflang_test_runner.cpp - Test runner for Woflang
+// tests/woflang_test_runner.cpp - Parallel test runner for Woflang
+//
+//   woflang_test_runner [DIR|FILE.wof ...] [--jobs N] [--timeout MS]
+//                       [--plugins DIR] [--filter S] [--verbose]
+//
+// Runs every *.wof under the given directories (default: the source tree's
+// tests/) on a pool of interpreters, one test per interpreter, in parallel.
+// Each test gets a newly built interpreter with the plugins already loaded,
+// so words, variables and redefined ops never leak from one test into the
+// next. A test passes when it finishes within the timeout, no op failed
+// along the way, and it leaves the string "PASS" on top of the stack. The
+// expect_* ops of the assert_ops plugin throw on a mismatch, so a failed
+// check is an op error.
+//
+// Comment lines at the top of a test may hold directives:
+//
+//   # skip: reason           not run, reported as skipped
+//   # requires: op ...       skipped unless every op is registered
+//   # expect-errors: N       exactly N op errors are part of the test
+//
+// Tests run in a scratch directory, removed afterwards, that holds a copy
+// of the data/ directory next to them: fixtures are read by relative path
+// and files a test writes never land in the source tree. Tests run
+// concurrently, so each must use its own file names.
+//
+// The timeout is enforced between instructions (see ExecutionLimits); a
+// native op that does not poll should_yield() runs to completion, and a
+// test that finishes but took longer than the timeout still fails.
+//
+// Output printed by a test is captured per test and shown when it fails
+// (or always with --verbose). Exit status is 1 if any test failed.
 #include "../src/core/woflang.hpp"
-#include <iostream>
+#include "../src/core/interp_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
 #include <vector>
-#include <chrono>
+
+#ifndef WOFLANG_TEST_DIR
+#define WOFLANG_TEST_DIR "tests"
+#endif
 
 using namespace woflang;
 
+namespace {
+
 struct TestResult {
     std::string name;
-    bool passed;
+    bool passed = false;
+    bool skipped = false;
     std::string error;
-    double duration_ms;
+    std::string output;
+    double duration_ms = 0;
 };
 
-class TestRunner {
-private:
-    std::vector<TestResult> results;
-    
+// Installed as std::cout's and std::cerr's buffer while tests run: each
+// thread's writes go to the string it has claimed, or to the original
+// stream if it has not claimed one.
+class ThreadCapture : public std::streambuf {
 public:
-    void run_test(const std::filesystem::path& test_file) {
-        auto start = std::chrono::high_resolution_clock::now();
-        
-        TestResult result;
-        result.name = test_file.stem().string();
-        result.passed = true;
-        
-        try {
-            WoflangInterpreter interp;
-            
-            // Load core plugins for tests
-            auto plugin_dir = std::filesystem::path("../bin/plugins");
-            if (std::filesystem::exists(plugin_dir)) {
-                interp.load_plugins(plugin_dir);
-            }
-            
-            // Execute test script
-            interp.exec_script(test_file);
-            
-            // Check if test left "PASS" on stack
-            if (!interp.stack.empty() && 
-                interp.stack.back().type == WofType::String &&
-                std::get<std::string>(interp.stack.back().value) == "PASS") {
-                result.passed = true;
-            } else {
-                result.passed = false;
-                result.error = "Test did not leave 'PASS' on stack";
-            }
-            
-        } catch (const std::exception& e) {
-            result.passed = false;
-            result.error = e.what();
+    explicit ThreadCapture(std::streambuf* fallback) : fallback_(fallback) {}
+
+    static void claim(std::string* target) { target_ = target; }
+
+protected:
+    int overflow(int c) override {
+        if (c == traits_type::eof()) return traits_type::not_eof(c);
+        if (target_) {
+            target_->push_back(static_cast<char>(c));
+            return c;
         }
-        
-        auto end = std::chrono::high_resolution_clock::now();
-        result.duration_ms = std::chrono::duration<double, std::milli>(end - start).count();
-        
-        results.push_back(result);
+        return fallback_->sputc(static_cast<char>(c));
     }
-    
-    void run_all_tests(const std::filesystem::path& test_dir) {
-        std::cout << "Running Woflang Test Suite\n";
-        std::cout << "==========================\n\n";
-        
-        if (!std::filesystem::exists(test_dir)) {
-            std::cout << "Test directory not found: " << test_dir << "\n";
-            return;
-        }
-        
-        for (const auto& entry : std::filesystem::directory_iterator(test_dir)) {
-            if (entry.path().extension() == ".wof") {
-                run_test(entry.path());
-            }
-        }
-        
-        // If no .wof files found, run built-in tests
-        if (results.empty()) {
-            run_builtin_tests();
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        if (target_) {
+            target_->append(s, static_cast<size_t>(n));
+            return n;
         }
+        return fallback_->sputn(s, n);
     }
-    
-    void run_builtin_tests() {
-        std::cout << "Running built-in tests...\n";
-        
-        // Test 1: Basic arithmetic
-        {
-            TestResult result;
-            result.name = "basic_arithmetic";
-            auto start = std::chrono::high_resolution_clock::now();
-            
-            try {
-                WoflangInterpreter interp;
-                interp.execute("2 3 + 5 =");
-                
-                if (!interp.stack.empty() && 
-                    interp.stack.back().type == WofType::Boolean &&
-                    std::get<bool>(interp.stack.back().value)) {
-                    result.passed = true;
-                } else {
-                    result.passed = false;
-                    result.error = "2 + 3 != 5";
-                }
-            } catch (const std::exception& e) {
-                result.passed = false;
-                result.error = e.what();
-            }
-            
-            auto end = std::chrono::high_resolution_clock::now();
-            result.duration_ms = std::chrono::duration<double, std::milli>(end - start).count();
-            results.push_back(result);
+    int sync() override { return target_ ? 0 : fallback_->pubsync(); }
+
+private:
+    std::streambuf* fallback_;
+    static thread_local std::string* target_;
+};
+
+thread_local std::string* ThreadCapture::target_ = nullptr;
+
+struct Options {
+    std::vector<std::filesystem::path> inputs;
+    unsigned jobs = 0;
+    std::chrono::milliseconds timeout{10000};
+    std::filesystem::path plugins;
+    std::string filter;
+    bool verbose = false;
+};
+
+std::vector<std::filesystem::path> discover(const Options& opt) {
+    std::vector<std::filesystem::path> tests;
+    for (const auto& input : opt.inputs) {
+        if (std::filesystem::is_regular_file(input)) {
+            tests.push_back(std::filesystem::absolute(input));
+            continue;
         }
-        
-        // Test 2: Stack operations
-        {
-            TestResult result;
-            result.name = "stack_operations";
-            auto start = std::chrono::high_resolution_clock::now();
-            
-            try {
-                WoflangInterpreter interp;
-                interp.execute("1 2 3 rot");
-                
-                if (interp.stack.size() == 3 &&
-                    interp.stack[0].type == WofType::Integer &&
-                    interp.stack[1].type == WofType::Integer &&
-                    interp.stack[2].type == WofType::Integer &&
-                    std::get<int64_t>(interp.stack[0].value) == 2 &&
-                    std::get<int64_t>(interp.stack[1].value) == 3 &&
-                    std::get<int64_t>(interp.stack[2].value) == 1) {
-                    result.passed = true;
-                } else {
-                    result.passed = false;
-                    result.error = "rot operation failed";
-                }
-            } catch (const std::exception& e) {
-                result.passed = false;
-                result.error = e.what();
-            }
-            
-            auto end = std::chrono::high_resolution_clock::now();
-            result.duration_ms = std::chrono::duration<double, std::milli>(end - start).count();
-            results.push_back(result);
+        if (!std::filesystem::is_directory(input)) {
+            throw std::runtime_error("test directory not found: " + input.string());
         }
-        
-        // Test 3: Variables
-        {
-            TestResult result;
-            result.name = "variables";
-            auto start = std::chrono::high_resolution_clock::now();
-            
-            try {
-                WoflangInterpreter interp;
-                interp.execute("42 !answer $answer $answer +");
-                
-                if (!interp.stack.empty() && 
-                    interp.stack.back().type == WofType::Integer &&
-                    std::get<int64_t>(interp.stack.back().value) == 84) {
-                    result.passed = true;
-                } else {
-                    result.passed = false;
-                    result.error = "Variable storage/retrieval failed";
-                }
-            } catch (const std::exception& e) {
-                result.passed = false;
-                result.error = e.what();
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(input)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".wof") {
+                tests.push_back(std::filesystem::absolute(entry.path()));
             }
-            
-            auto end = std::chrono::high_resolution_clock::now();
-            result.duration_ms = std::chrono::duration<double, std::milli>(end - start).count();
-            results.push_back(result);
         }
-        
-        // Test 4: String operations
-        {
-            TestResult result;
-            result.name = "string_operations";
-            auto start = std::chrono::high_resolution_clock::now();
-            
-            try {
-                WoflangInterpreter interp;
-                interp.execute("\"Hello\" \" World\" +");
-                
-                if (!interp.stack.empty() && 
-                    interp.stack.back().type == WofType::String &&
-                    std::get<std::string>(interp.stack.back().value) == "Hello World") {
-                    result.passed = true;
-                } else {
-                    result.passed = false;
-                    result.error = "String concatenation failed";
-                }
-            } catch (const std::exception& e) {
-                result.passed = false;
-                result.error = e.what();
-            }
-            
-            auto end = std::chrono::high_resolution_clock::now();
-            result.duration_ms = std::chrono::duration<double, std::milli>(end - start).count();
-            results.push_back(result);
+    }
+    std::erase_if(tests, [&](const auto& p) {
+        return !opt.filter.empty() && p.string().find(opt.filter) == std::string::npos;
+    });
+    std::sort(tests.begin(), tests.end());
+    return tests;
+}
+
+// Fresh working directory for the run, holding a copy of each test
+// directory's data/.
+std::filesystem::path make_scratch(const std::vector<std::filesystem::path>& tests) {
+    auto scratch = std::filesystem::temp_directory_path() /
+                   ("woflang_tests_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    std::filesystem::create_directories(scratch / "data");
+    for (const auto& test : tests) {
+        auto data = test.parent_path() / "data";
+        if (std::filesystem::is_directory(data)) {
+            std::filesystem::copy(data, scratch / "data",
+                                  std::filesystem::copy_options::recursive |
+                                      std::filesystem::copy_options::skip_existing);
         }
-        
-        // Test 5: Plugin loading (if available)
-        {
-            TestResult result;
-            result.name = "plugin_loading";
-            auto start = std::chrono::high_resolution_clock::now();
-            
-            try {
-                WoflangInterpreter interp;
-                
-                // Try to load plugins
-                auto plugin_dir = std::filesystem::path("../bin/plugins");
-                if (std::filesystem::exists(plugin_dir)) {
-                    interp.load_plugins(plugin_dir);
-                    
-                    // Test if π (pi) operation is available (from math_greek plugin)
-                    interp.execute("π");
-                    
-                    if (!interp.stack.empty() && 
-                        interp.stack.back().type == WofType::Double) {
-                        double pi_val = std::get<double>(interp.stack.back().value);
-                        if (pi_val > 3.14 && pi_val < 3.15) {
-                            result.passed = true;
-                        } else {
-                            result.passed = false;
-                            result.error = "π value incorrect";
-                        }
-                    } else {
-                        result.passed = false;
-                        result.error = "π operation not found";
-                    }
-                } else {
-                    result.passed = false;
-                    result.error = "Plugin directory not found";
-                }
-            } catch (const std::exception& e) {
-                result.passed = false;
-                result.error = e.what();
-            }
-            
-            auto end = std::chrono::high_resolution_clock::now();
-            result.duration_ms = std::chrono::duration<double, std::milli>(end - start).count();
-            results.push_back(result);
+    }
+    return scratch;
+}
+
+struct Directives {
+    std::string skip;
+    std::vector<std::string> requires_ops;
+    uint64_t expect_errors = 0;
+};
+
+// The leading comment block; parsing stops at the first line of code.
+Directives read_directives(const std::filesystem::path& file) {
+    Directives d;
+    std::ifstream in(file);
+    for (std::string line; std::getline(in, line);) {
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos) continue;
+        if (line[first] != '#') break;
+        std::istringstream words(line.substr(first + 1));
+        std::string key;
+        words >> key;
+        if (key == "skip:") {
+            std::getline(words >> std::ws, d.skip);
+            if (d.skip.empty()) d.skip = "skipped";
+        } else if (key == "requires:") {
+            for (std::string op; words >> op;) d.requires_ops.push_back(op);
+        } else if (key == "expect-errors:") {
+            words >> d.expect_errors;
         }
     }
-    
-    void print_results() {
-        int passed = 0;
-        int failed = 0;
-        
-        for (const auto& result : results) {
-            if (result.passed) {
-                std::cout << "✓ " << result.name << " (" 
-                         << std::fixed << std::setprecision(2) << result.duration_ms << " ms)\n";
-                passed++;
-            } else {
-                std::cout << "✗ " << result.name << " - " 
-                         << result.error << "\n";
-                failed++;
-            }
+    return d;
+}
+
+TestResult run_test(InterpreterPool& pool, const std::filesystem::path& file, std::chrono::milliseconds timeout) {
+    TestResult result;
+    result.name = file.stem().string();
+    Directives directives = read_directives(file);
+    if (!directives.skip.empty()) {
+        result.skipped = true;
+        result.error = directives.skip;
+        return result;
+    }
+    WoflangInterpreter& interp = pool.acquire();
+    for (const auto& op : directives.requires_ops) {
+        if (!interp.has_op(op)) {
+            result.skipped = true;
+            result.error = "requires '" + op + "'";
+            pool.release(interp);
+            return result;
         }
-        
-        std::cout << "\n";
-        std::cout << "Tests: " << passed << " passed, " << failed << " failed, "
-                  << (passed + failed) << " total\n";
-        
-        if (failed > 0) {
-            std::cout << "Test suite FAILED\n";
+    }
+    ThreadCapture::claim(&result.output);
+    auto start = std::chrono::steady_clock::now();
+    try {
+        interp.execute_file(file, false);  // no .wofc next to the sources
+        if (interp.op_errors() != directives.expect_errors) {
+            result.error = std::to_string(interp.op_errors()) + " op error(s)";
+            if (directives.expect_errors > 0) result.error += ", expected " + std::to_string(directives.expect_errors);
+        } else if (interp.stack.empty() || !interp.stack.top().is_string() ||
+                   interp.stack.top().s != "PASS") {
+            result.error = interp.stack.empty() ? "stack empty, expected \"PASS\""
+                                                : "left " + interp.stack.top().to_string() + ", expected \"PASS\"";
         } else {
-            std::cout << "Test suite PASSED\n";
+            result.passed = true;
         }
+    } catch (const BudgetExceeded& e) {
+        result.error = std::string("timed out: ") + e.what();
+    } catch (const std::exception& e) {
+        result.error = e.what();
     }
-    
-    bool all_passed() const {
-        for (const auto& result : results) {
-            if (!result.passed) return false;
-        }
-        return true;
+    result.duration_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (result.passed && result.duration_ms > static_cast<double>(timeout.count())) {
+        result.passed = false;
+        result.error = "took longer than the " + std::to_string(timeout.count()) + " ms timeout";
     }
-};
+    ThreadCapture::claim(nullptr);
+    pool.renew(interp);
+    return result;
+}
+
+void print_result(const TestResult& r, bool verbose) {
+    if (r.skipped) {
+        std::cout << "- " << std::left << std::setw(28) << r.name << std::right << "  skipped: " << r.error << "\n";
+        return;
+    }
+    std::cout << (r.passed ? "✓ " : "✗ ") << std::left << std::setw(28) << r.name << std::right << std::fixed
+              << std::setprecision(2) << std::setw(10) << r.duration_ms << " ms";
+    if (!r.passed) std::cout << "  " << r.error;
+    std::cout << "\n";
+    if ((verbose || !r.passed) && !r.output.empty()) {
+        std::istringstream lines(r.output);
+        for (std::string line; std::getline(lines, line);) std::cout << "    | " << line << "\n";
+    }
+}
+
+} // namespace
 
 int main(int argc, char* argv[]) {
-    std::filesystem::path test_dir = "tests";
-    
-    if (argc > 1) {
-        test_dir = argv[1];
+    Options opt;
+    for (int k = 1; k < argc; ++k) {
+        std::string a = argv[k];
+        bool has_value = k + 1 < argc;
+        if (a == "--jobs" && has_value) opt.jobs = static_cast<unsigned>(std::atoi(argv[++k]));
+        else if (a == "--timeout" && has_value) opt.timeout = std::chrono::milliseconds(std::atoll(argv[++k]));
+        else if (a == "--plugins" && has_value) opt.plugins = argv[++k];
+        else if (a == "--filter" && has_value) opt.filter = argv[++k];
+        else if (a == "--verbose" || a == "-v") opt.verbose = true;
+        else if (a.rfind("--", 0) == 0) {
+            std::cerr << "usage: woflang_test_runner [DIR|FILE.wof ...] [--jobs N] [--timeout MS]\n"
+                         "                           [--plugins DIR] [--filter S] [--verbose]\n";
+            return 2;
+        } else {
+            opt.inputs.push_back(a);
+        }
+    }
+    if (opt.inputs.empty()) opt.inputs.push_back(WOFLANG_TEST_DIR);
+    if (opt.plugins.empty()) {
+        // Next to the executable, as in the build tree's bin/.
+        auto beside = std::filesystem::absolute(argv[0]).parent_path() / "plugins";
+        opt.plugins = std::filesystem::exists(beside) ? beside : std::filesystem::path("plugins");
+    }
+    // Interpreters renewed after the move to the scratch directory load
+    // plugins from here too.
+    opt.plugins = std::filesystem::absolute(opt.plugins);
+    if (opt.jobs == 0) opt.jobs = std::max(1u, std::thread::hardware_concurrency());
+
+    try {
+        auto tests = discover(opt);
+        if (tests.empty()) {
+            std::cout << "No tests found\n";
+            return 1;
+        }
+        unsigned jobs = std::min<unsigned>(opt.jobs, static_cast<unsigned>(tests.size()));
+        std::cout << "Running " << tests.size() << " test(s) on " << jobs << " interpreter(s)\n\n";
+
+        auto scratch = make_scratch(tests);
+        auto original_dir = std::filesystem::current_path();
+        std::filesystem::current_path(scratch);
+
+        auto start = std::chrono::steady_clock::now();
+        InterpreterPool pool(jobs, opt.plugins);
+        ExecutionLimits limits;
+        limits.timeout = opt.timeout;
+        pool.set_limits(limits);
+
+        std::vector<TestResult> results(tests.size());
+        std::atomic<size_t> next{0};
+        std::mutex print_mutex;
+        ThreadCapture out_capture(std::cout.rdbuf()), err_capture(std::cerr.rdbuf());
+        auto* saved_out = std::cout.rdbuf(&out_capture);
+        auto* saved_err = std::cerr.rdbuf(&err_capture);
+        std::vector<std::thread> workers;
+        for (unsigned w = 0; w < jobs; ++w) {
+            workers.emplace_back([&] {
+                for (size_t k; (k = next.fetch_add(1)) < tests.size();) {
+                    results[k] = run_test(pool, tests[k], opt.timeout);
+                    std::lock_guard<std::mutex> lock(print_mutex);
+                    print_result(results[k], opt.verbose);
+                }
+            });
+        }
+        for (auto& t : workers) t.join();
+        std::cout.rdbuf(saved_out);
+        std::cerr.rdbuf(saved_err);
+        std::filesystem::current_path(original_dir);
+        std::error_code ec;
+        std::filesystem::remove_all(scratch, ec);
+        double wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        size_t passed = 0, skipped = 0;
+        double total_ms = 0;
+        for (const auto& r : results) {
+            passed += r.passed;
+            skipped += r.skipped;
+            total_ms += r.duration_ms;
+        }
+        size_t failed = results.size() - passed - skipped;
+        std::cout << "\nTests: " << passed << " passed, " << failed << " failed, " << skipped << " skipped, "
+                  << results.size() << " total\n";
+        std::cout << std::fixed << std::setprecision(1) << "Time:  " << wall_ms << " ms wall, " << total_ms
+                  << " ms in tests\n";
+        std::sort(results.begin(), results.end(),
+                  [](const auto& a, const auto& b) { return a.duration_ms > b.duration_ms; });
+        std::cout << "Slowest:";
+        for (size_t k = 0; k < std::min<size_t>(3, results.size()); ++k) {
+            std::cout << " " << results[k].name << " (" << std::setprecision(2) << results[k].duration_ms << " ms)";
+        }
+        std::cout << "\n" << (failed == 0 ? "Test suite PASSED\n" : "Test suite FAILED\n");
+        return failed == 0 ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 2;
     }
-    
-    TestRunner runner;
-    runner.run_all_tests(test_dir);
-    runner.print_results();
-    
-    return runner.all_passed() ? 0 : 1;
-}
\ No newline at end of file
+}